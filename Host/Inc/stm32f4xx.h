@@ -0,0 +1,494 @@
+/* ============================================================================
+ * STM32F411 Device Header (Host Emulator)
+ * Stands in for the CMSIS device header when Src/ is built for Linux. The
+ * register layouts and bit definitions match CMSIS; every peripheral macro
+ * goes through emu_reg(), which brings that peripheral's model up to the
+ * current virtual time before the firmware touches its registers.
+ * ============================================================================ */
+
+#ifndef STM32F4XX_H
+#define STM32F4XX_H
+
+#include <stdint.h>
+
+#define __IO    volatile
+#define __I     volatile const
+#define __O     volatile
+
+#define __NVIC_PRIO_BITS    4
+
+/* Register Layouts */
+typedef struct {
+    __IO uint32_t MODER, OTYPER, OSPEEDR, PUPDR, IDR, ODR, BSRR, LCKR, AFR[2];
+} GPIO_TypeDef;
+
+typedef struct {
+    __IO uint32_t CR, PLLCFGR, CFGR, CIR, AHB1RSTR, AHB2RSTR, RESERVED0[2];
+    __IO uint32_t APB1RSTR, APB2RSTR, RESERVED1[2], AHB1ENR, AHB2ENR, RESERVED2[2];
+    __IO uint32_t APB1ENR, APB2ENR, RESERVED3[2], AHB1LPENR, AHB2LPENR, RESERVED4[2];
+    __IO uint32_t APB1LPENR, APB2LPENR, RESERVED5[2], BDCR, CSR, RESERVED6[2];
+    __IO uint32_t SSCGR, PLLI2SCFGR, RESERVED7, DCKCFGR;
+} RCC_TypeDef;
+
+typedef struct {
+    __IO uint32_t ACR, KEYR, OPTKEYR, SR, CR, OPTCR;
+} FLASH_TypeDef;
+
+typedef struct {
+    __IO uint32_t CR, CSR;
+} PWR_TypeDef;
+
+typedef struct {
+    __IO uint32_t MEMRMP, PMC, EXTICR[4], RESERVED[2], CMPCR;
+} SYSCFG_TypeDef;
+
+typedef struct {
+    __IO uint32_t IMR, EMR, RTSR, FTSR, SWIER, PR;
+} EXTI_TypeDef;
+
+typedef struct {
+    __IO uint32_t SR, DR, BRR, CR1, CR2, CR3, GTPR;
+} USART_TypeDef;
+
+typedef struct {
+    __IO uint32_t SR, CR1, CR2, SMPR1, SMPR2, JOFR1, JOFR2, JOFR3, JOFR4;
+    __IO uint32_t HTR, LTR, SQR1, SQR2, SQR3, JSQR, JDR1, JDR2, JDR3, JDR4, DR;
+} ADC_TypeDef;
+
+typedef struct {
+    __IO uint32_t CSR, CCR, CDR;
+} ADC_Common_TypeDef;
+
+typedef struct {
+    __IO uint32_t CR1, CR2, SMCR, DIER, SR, EGR, CCMR1, CCMR2, CCER, CNT, PSC, ARR;
+    __IO uint32_t RCR, CCR1, CCR2, CCR3, CCR4, BDTR, DCR, DMAR, OR;
+} TIM_TypeDef;
+
+typedef struct {
+    __IO uint32_t CR1, CR2, OAR1, OAR2, DR, SR1, SR2, CCR, TRISE, FLTR;
+} I2C_TypeDef;
+
+typedef struct {
+    __IO uint32_t LISR, HISR, LIFCR, HIFCR;
+} DMA_TypeDef;
+
+/* Address registers are pointer-wide here so DMA can reach host memory */
+typedef struct {
+    __IO uint32_t CR, NDTR;
+    __IO uintptr_t PAR, M0AR, M1AR;
+    __IO uint32_t FCR;
+} DMA_Stream_TypeDef;
+
+typedef struct {
+    __IO uint32_t CTRL, LOAD, VAL, CALIB;
+} SysTick_Type;
+
+typedef struct {
+    __IO uint32_t CTRL, CYCCNT, CPICNT, EXCCNT, SLEEPCNT, LSUCNT, FOLDCNT, PCSR;
+} DWT_Type;
+
+typedef struct {
+    __IO uint32_t DHCSR, DCRSR, DCRDR, DEMCR;
+} CoreDebug_Type;
+
+typedef struct {
+    __IO uint32_t CPUID, ICSR, VTOR, AIRCR, SCR, CCR, SHP[12], SHCSR, CFSR, HFSR;
+} SCB_Type;
+
+/* Peripheral Access: each use syncs the model, then yields its registers */
+typedef enum {
+    EMU_GPIOA, EMU_GPIOB, EMU_GPIOC, EMU_RCC, EMU_FLASH, EMU_PWR, EMU_SYSCFG,
+    EMU_EXTI, EMU_USART2, EMU_ADC1, EMU_ADC_COMMON, EMU_TIM2, EMU_TIM3, EMU_TIM4,
+    EMU_TIM5, EMU_I2C1, EMU_DMA1, EMU_DMA2,
+    EMU_DMA1_STREAM0, EMU_DMA2_STREAM0 = EMU_DMA1_STREAM0 + 8,
+    EMU_SYSTICK = EMU_DMA2_STREAM0 + 8, EMU_DWT, EMU_COREDEBUG, EMU_SCB,
+    EMU_PERIPH_COUNT
+} EMU_Periph_t;
+
+void* emu_reg(EMU_Periph_t id);
+
+#define GPIOA           ((GPIO_TypeDef*)emu_reg(EMU_GPIOA))
+#define GPIOB           ((GPIO_TypeDef*)emu_reg(EMU_GPIOB))
+#define GPIOC           ((GPIO_TypeDef*)emu_reg(EMU_GPIOC))
+#define RCC             ((RCC_TypeDef*)emu_reg(EMU_RCC))
+#define FLASH           ((FLASH_TypeDef*)emu_reg(EMU_FLASH))
+#define PWR             ((PWR_TypeDef*)emu_reg(EMU_PWR))
+#define SYSCFG          ((SYSCFG_TypeDef*)emu_reg(EMU_SYSCFG))
+#define EXTI            ((EXTI_TypeDef*)emu_reg(EMU_EXTI))
+#define USART2          ((USART_TypeDef*)emu_reg(EMU_USART2))
+#define ADC1            ((ADC_TypeDef*)emu_reg(EMU_ADC1))
+#define ADC1_COMMON     ((ADC_Common_TypeDef*)emu_reg(EMU_ADC_COMMON))
+#define ADC123_COMMON   ADC1_COMMON
+#define TIM2            ((TIM_TypeDef*)emu_reg(EMU_TIM2))
+#define TIM3            ((TIM_TypeDef*)emu_reg(EMU_TIM3))
+#define TIM4            ((TIM_TypeDef*)emu_reg(EMU_TIM4))
+#define TIM5            ((TIM_TypeDef*)emu_reg(EMU_TIM5))
+#define I2C1            ((I2C_TypeDef*)emu_reg(EMU_I2C1))
+#define DMA1            ((DMA_TypeDef*)emu_reg(EMU_DMA1))
+#define DMA2            ((DMA_TypeDef*)emu_reg(EMU_DMA2))
+#define DMA1_Stream0    ((DMA_Stream_TypeDef*)emu_reg(EMU_DMA1_STREAM0 + 0))
+#define DMA1_Stream1    ((DMA_Stream_TypeDef*)emu_reg(EMU_DMA1_STREAM0 + 1))
+#define DMA1_Stream2    ((DMA_Stream_TypeDef*)emu_reg(EMU_DMA1_STREAM0 + 2))
+#define DMA1_Stream3    ((DMA_Stream_TypeDef*)emu_reg(EMU_DMA1_STREAM0 + 3))
+#define DMA1_Stream4    ((DMA_Stream_TypeDef*)emu_reg(EMU_DMA1_STREAM0 + 4))
+#define DMA1_Stream5    ((DMA_Stream_TypeDef*)emu_reg(EMU_DMA1_STREAM0 + 5))
+#define DMA1_Stream6    ((DMA_Stream_TypeDef*)emu_reg(EMU_DMA1_STREAM0 + 6))
+#define DMA1_Stream7    ((DMA_Stream_TypeDef*)emu_reg(EMU_DMA1_STREAM0 + 7))
+#define DMA2_Stream0    ((DMA_Stream_TypeDef*)emu_reg(EMU_DMA2_STREAM0 + 0))
+#define DMA2_Stream1    ((DMA_Stream_TypeDef*)emu_reg(EMU_DMA2_STREAM0 + 1))
+#define DMA2_Stream2    ((DMA_Stream_TypeDef*)emu_reg(EMU_DMA2_STREAM0 + 2))
+#define DMA2_Stream3    ((DMA_Stream_TypeDef*)emu_reg(EMU_DMA2_STREAM0 + 3))
+#define DMA2_Stream4    ((DMA_Stream_TypeDef*)emu_reg(EMU_DMA2_STREAM0 + 4))
+#define DMA2_Stream5    ((DMA_Stream_TypeDef*)emu_reg(EMU_DMA2_STREAM0 + 5))
+#define DMA2_Stream6    ((DMA_Stream_TypeDef*)emu_reg(EMU_DMA2_STREAM0 + 6))
+#define DMA2_Stream7    ((DMA_Stream_TypeDef*)emu_reg(EMU_DMA2_STREAM0 + 7))
+#define SysTick         ((SysTick_Type*)emu_reg(EMU_SYSTICK))
+#define DWT             ((DWT_Type*)emu_reg(EMU_DWT))
+#define CoreDebug       ((CoreDebug_Type*)emu_reg(EMU_COREDEBUG))
+#define SCB             ((SCB_Type*)emu_reg(EMU_SCB))
+
+/* Interrupt Numbers */
+typedef enum {
+    NonMaskableInt_IRQn = -14, HardFault_IRQn = -13, SVCall_IRQn = -5,
+    PendSV_IRQn = -2, SysTick_IRQn = -1,
+    WWDG_IRQn = 0, FLASH_IRQn = 4, RCC_IRQn = 5,
+    EXTI0_IRQn = 6, EXTI1_IRQn = 7, EXTI2_IRQn = 8, EXTI3_IRQn = 9, EXTI4_IRQn = 10,
+    DMA1_Stream0_IRQn = 11, DMA1_Stream1_IRQn = 12, DMA1_Stream2_IRQn = 13,
+    DMA1_Stream3_IRQn = 14, DMA1_Stream4_IRQn = 15, DMA1_Stream5_IRQn = 16,
+    DMA1_Stream6_IRQn = 17, ADC_IRQn = 18, EXTI9_5_IRQn = 23,
+    TIM2_IRQn = 28, TIM3_IRQn = 29, TIM4_IRQn = 30,
+    I2C1_EV_IRQn = 31, I2C1_ER_IRQn = 32, USART2_IRQn = 38, EXTI15_10_IRQn = 40,
+    DMA1_Stream7_IRQn = 47, TIM5_IRQn = 50,
+    DMA2_Stream0_IRQn = 56, DMA2_Stream1_IRQn = 57, DMA2_Stream2_IRQn = 58,
+    DMA2_Stream3_IRQn = 59, DMA2_Stream4_IRQn = 60, DMA2_Stream5_IRQn = 68,
+    DMA2_Stream6_IRQn = 69, DMA2_Stream7_IRQn = 70
+} IRQn_Type;
+
+/* Core Functions: implemented by the emulator, each one a safe point where
+ * pending interrupts may run */
+void NVIC_EnableIRQ(IRQn_Type irq);
+void NVIC_DisableIRQ(IRQn_Type irq);
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority);
+uint32_t NVIC_GetPriority(IRQn_Type irq);
+void NVIC_SetPendingIRQ(IRQn_Type irq);
+void NVIC_ClearPendingIRQ(IRQn_Type irq);
+uint32_t SysTick_Config(uint32_t ticks);
+
+void __WFI(void);
+void __WFE(void);
+void __SEV(void);
+void __DSB(void);
+void __DMB(void);
+void __ISB(void);
+void __NOP(void);
+void __enable_irq(void);
+void __disable_irq(void);
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t primask);
+uint32_t __get_IPSR(void);
+uint32_t __get_MSP(void);
+
+/* ============================================================================
+ * Bit Definitions
+ * ============================================================================ */
+/* RCC */
+#define RCC_CR_HSION                (1u << 0)
+#define RCC_CR_HSIRDY               (1u << 1)
+#define RCC_CR_HSEON                (1u << 16)
+#define RCC_CR_HSERDY               (1u << 17)
+#define RCC_CR_HSEBYP               (1u << 18)
+#define RCC_CR_PLLON                (1u << 24)
+#define RCC_CR_PLLRDY               (1u << 25)
+#define RCC_PLLCFGR_PLLM_Pos        0
+#define RCC_PLLCFGR_PLLM            (0x3Fu << 0)
+#define RCC_PLLCFGR_PLLN_Pos        6
+#define RCC_PLLCFGR_PLLN            (0x1FFu << 6)
+#define RCC_PLLCFGR_PLLP_Pos        16
+#define RCC_PLLCFGR_PLLP            (3u << 16)
+#define RCC_PLLCFGR_PLLSRC_Pos      22
+#define RCC_PLLCFGR_PLLSRC          (1u << 22)
+#define RCC_PLLCFGR_PLLSRC_HSI      0u
+#define RCC_PLLCFGR_PLLSRC_HSE      (1u << 22)
+#define RCC_PLLCFGR_PLLQ_Pos        24
+#define RCC_PLLCFGR_PLLQ            (0xFu << 24)
+#define RCC_CFGR_SW_Pos             0
+#define RCC_CFGR_SW                 (3u << 0)
+#define RCC_CFGR_SW_HSI             0u
+#define RCC_CFGR_SW_HSE             1u
+#define RCC_CFGR_SW_PLL             2u
+#define RCC_CFGR_SWS_Pos            2
+#define RCC_CFGR_SWS                (3u << 2)
+#define RCC_CFGR_SWS_HSI            0u
+#define RCC_CFGR_SWS_HSE            4u
+#define RCC_CFGR_SWS_PLL            8u
+#define RCC_CFGR_HPRE_Pos           4
+#define RCC_CFGR_HPRE               (0xFu << 4)
+#define RCC_CFGR_HPRE_DIV1          0u
+#define RCC_CFGR_HPRE_DIV2          (8u << 4)
+#define RCC_CFGR_PPRE1_Pos          10
+#define RCC_CFGR_PPRE1              (7u << 10)
+#define RCC_CFGR_PPRE1_DIV1         0u
+#define RCC_CFGR_PPRE1_DIV2         (4u << 10)
+#define RCC_CFGR_PPRE1_DIV4         (5u << 10)
+#define RCC_CFGR_PPRE2_Pos          13
+#define RCC_CFGR_PPRE2              (7u << 13)
+#define RCC_CFGR_PPRE2_DIV1         0u
+#define RCC_CFGR_PPRE2_DIV2         (4u << 13)
+#define RCC_AHB1ENR_GPIOAEN         (1u << 0)
+#define RCC_AHB1ENR_GPIOBEN         (1u << 1)
+#define RCC_AHB1ENR_GPIOCEN         (1u << 2)
+#define RCC_AHB1ENR_DMA1EN          (1u << 21)
+#define RCC_AHB1ENR_DMA2EN          (1u << 22)
+#define RCC_APB1ENR_TIM2EN          (1u << 0)
+#define RCC_APB1ENR_TIM3EN          (1u << 1)
+#define RCC_APB1ENR_TIM4EN          (1u << 2)
+#define RCC_APB1ENR_TIM5EN          (1u << 3)
+#define RCC_APB1ENR_USART2EN        (1u << 17)
+#define RCC_APB1ENR_I2C1EN          (1u << 21)
+#define RCC_APB1ENR_PWREN           (1u << 28)
+#define RCC_APB1RSTR_I2C1RST        (1u << 21)
+#define RCC_APB2ENR_ADC1EN          (1u << 8)
+#define RCC_APB2ENR_SYSCFGEN        (1u << 14)
+
+/* FLASH */
+#define FLASH_ACR_LATENCY           (0xFu << 0)
+#define FLASH_ACR_LATENCY_0WS       0u
+#define FLASH_ACR_LATENCY_1WS       1u
+#define FLASH_ACR_LATENCY_2WS       2u
+#define FLASH_ACR_LATENCY_3WS       3u
+#define FLASH_ACR_PRFTEN            (1u << 8)
+#define FLASH_ACR_ICEN              (1u << 9)
+#define FLASH_ACR_DCEN              (1u << 10)
+#define FLASH_ACR_ICRST             (1u << 11)
+#define FLASH_ACR_DCRST             (1u << 12)
+#define FLASH_SR_EOP                (1u << 0)
+#define FLASH_SR_SOP                (1u << 1)
+#define FLASH_SR_WRPERR             (1u << 4)
+#define FLASH_SR_PGAERR             (1u << 5)
+#define FLASH_SR_PGPERR             (1u << 6)
+#define FLASH_SR_PGSERR             (1u << 7)
+#define FLASH_SR_BSY                (1u << 16)
+#define FLASH_CR_PG                 (1u << 0)
+#define FLASH_CR_SER                (1u << 1)
+#define FLASH_CR_MER                (1u << 2)
+#define FLASH_CR_SNB_Pos            3
+#define FLASH_CR_SNB                (0xFu << 3)
+#define FLASH_CR_PSIZE_Pos          8
+#define FLASH_CR_PSIZE              (3u << 8)
+#define FLASH_CR_PSIZE_0            (1u << 8)
+#define FLASH_CR_PSIZE_1            (2u << 8)
+#define FLASH_CR_STRT               (1u << 16)
+#define FLASH_CR_EOPIE              (1u << 24)
+#define FLASH_CR_ERRIE              (1u << 25)
+#define FLASH_CR_LOCK               (1u << 31)
+
+/* PWR */
+#define PWR_CR_VOS_Pos              14
+#define PWR_CR_VOS                  (3u << 14)
+#define PWR_CSR_VOSRDY              (1u << 14)
+
+/* USART */
+#define USART_SR_PE                 (1u << 0)
+#define USART_SR_ORE                (1u << 3)
+#define USART_SR_RXNE               (1u << 5)
+#define USART_SR_TC                 (1u << 6)
+#define USART_SR_TXE                (1u << 7)
+#define USART_CR1_RE                (1u << 2)
+#define USART_CR1_TE                (1u << 3)
+#define USART_CR1_RXNEIE            (1u << 5)
+#define USART_CR1_TCIE              (1u << 6)
+#define USART_CR1_TXEIE             (1u << 7)
+#define USART_CR1_UE                (1u << 13)
+#define USART_CR1_OVER8             (1u << 15)
+#define USART_CR3_DMAR              (1u << 6)
+#define USART_CR3_DMAT              (1u << 7)
+
+/* I2C */
+#define I2C_CR1_PE                  (1u << 0)
+#define I2C_CR1_START               (1u << 8)
+#define I2C_CR1_STOP                (1u << 9)
+#define I2C_CR1_ACK                 (1u << 10)
+#define I2C_CR1_SWRST               (1u << 15)
+#define I2C_CR2_FREQ                (0x3Fu << 0)
+#define I2C_CR2_ITERREN             (1u << 8)
+#define I2C_CR2_ITEVTEN             (1u << 9)
+#define I2C_CR2_ITBUFEN             (1u << 10)
+#define I2C_CR2_DMAEN               (1u << 11)
+#define I2C_CR2_LAST                (1u << 12)
+#define I2C_SR1_SB                  (1u << 0)
+#define I2C_SR1_ADDR                (1u << 1)
+#define I2C_SR1_BTF                 (1u << 2)
+#define I2C_SR1_STOPF               (1u << 4)
+#define I2C_SR1_RXNE                (1u << 6)
+#define I2C_SR1_TXE                 (1u << 7)
+#define I2C_SR1_BERR                (1u << 8)
+#define I2C_SR1_ARLO                (1u << 9)
+#define I2C_SR1_AF                  (1u << 10)
+#define I2C_SR1_OVR                 (1u << 11)
+#define I2C_SR1_TIMEOUT             (1u << 14)
+#define I2C_SR2_MSL                 (1u << 0)
+#define I2C_SR2_BUSY                (1u << 1)
+#define I2C_SR2_TRA                 (1u << 2)
+#define I2C_CCR_CCR                 (0xFFFu << 0)
+#define I2C_CCR_DUTY                (1u << 14)
+#define I2C_CCR_FS                  (1u << 15)
+
+/* ADC */
+#define ADC_SR_AWD                  (1u << 0)
+#define ADC_SR_EOC                  (1u << 1)
+#define ADC_SR_STRT                 (1u << 4)
+#define ADC_SR_OVR                  (1u << 5)
+#define ADC_CR1_EOCIE               (1u << 5)
+#define ADC_CR1_SCAN                (1u << 8)
+#define ADC_CR1_RES_Pos             24
+#define ADC_CR1_RES                 (3u << 24)
+#define ADC_CR1_OVRIE               (1u << 26)
+#define ADC_CR2_ADON                (1u << 0)
+#define ADC_CR2_CONT                (1u << 1)
+#define ADC_CR2_DMA                 (1u << 8)
+#define ADC_CR2_DDS                 (1u << 9)
+#define ADC_CR2_EOCS                (1u << 10)
+#define ADC_CR2_ALIGN               (1u << 11)
+#define ADC_CR2_EXTSEL_Pos          24
+#define ADC_CR2_EXTSEL              (0xFu << 24)
+#define ADC_CR2_EXTEN_Pos           28
+#define ADC_CR2_EXTEN               (3u << 28)
+#define ADC_CR2_SWSTART             (1u << 30)
+#define ADC_SMPR2_SMP0_Pos          0
+#define ADC_SMPR2_SMP1_Pos          3
+#define ADC_SMPR2_SMP2_Pos          6
+#define ADC_SMPR2_SMP3_Pos          9
+#define ADC_SMPR2_SMP4_Pos          12
+#define ADC_SQR1_L_Pos              20
+#define ADC_SQR1_L                  (0xFu << 20)
+#define ADC_SQR3_SQ1_Pos            0
+#define ADC_SQR3_SQ1                (0x1Fu << 0)
+#define ADC_SQR3_SQ2_Pos            5
+#define ADC_SQR3_SQ2                (0x1Fu << 5)
+#define ADC_SQR3_SQ3_Pos            10
+#define ADC_SQR3_SQ3                (0x1Fu << 10)
+#define ADC_CCR_ADCPRE_Pos          16
+#define ADC_CCR_ADCPRE              (3u << 16)
+#define ADC_CCR_TSVREFE             (1u << 23)
+
+/* DMA */
+#define DMA_SxCR_EN                 (1u << 0)
+#define DMA_SxCR_DMEIE              (1u << 1)
+#define DMA_SxCR_TEIE               (1u << 2)
+#define DMA_SxCR_HTIE               (1u << 3)
+#define DMA_SxCR_TCIE               (1u << 4)
+#define DMA_SxCR_PFCTRL             (1u << 5)
+#define DMA_SxCR_DIR_Pos            6
+#define DMA_SxCR_DIR                (3u << 6)
+#define DMA_SxCR_DIR_0              (1u << 6)
+#define DMA_SxCR_DIR_1              (2u << 6)
+#define DMA_SxCR_CIRC               (1u << 8)
+#define DMA_SxCR_PINC               (1u << 9)
+#define DMA_SxCR_MINC               (1u << 10)
+#define DMA_SxCR_PSIZE_Pos          11
+#define DMA_SxCR_PSIZE              (3u << 11)
+#define DMA_SxCR_PSIZE_0            (1u << 11)
+#define DMA_SxCR_PSIZE_1            (2u << 11)
+#define DMA_SxCR_MSIZE_Pos          13
+#define DMA_SxCR_MSIZE              (3u << 13)
+#define DMA_SxCR_MSIZE_0            (1u << 13)
+#define DMA_SxCR_MSIZE_1            (2u << 13)
+#define DMA_SxCR_PL_Pos             16
+#define DMA_SxCR_PL                 (3u << 16)
+#define DMA_SxCR_CHSEL_Pos          25
+#define DMA_SxCR_CHSEL              (7u << 25)
+#define DMA_LISR_FEIF0              (1u << 0)
+#define DMA_LISR_DMEIF0             (1u << 2)
+#define DMA_LISR_TEIF0              (1u << 3)
+#define DMA_LISR_HTIF0              (1u << 4)
+#define DMA_LISR_TCIF0              (1u << 5)
+#define DMA_LIFCR_CFEIF0            (1u << 0)
+#define DMA_LIFCR_CDMEIF0           (1u << 2)
+#define DMA_LIFCR_CTEIF0            (1u << 3)
+#define DMA_LIFCR_CHTIF0            (1u << 4)
+#define DMA_LIFCR_CTCIF0            (1u << 5)
+#define DMA_HISR_FEIF6              (1u << 16)
+#define DMA_HISR_DMEIF6             (1u << 18)
+#define DMA_HISR_TEIF6              (1u << 19)
+#define DMA_HISR_HTIF6              (1u << 20)
+#define DMA_HISR_TCIF6              (1u << 21)
+#define DMA_HISR_FEIF7              (1u << 22)
+#define DMA_HISR_DMEIF7             (1u << 24)
+#define DMA_HISR_TEIF7              (1u << 25)
+#define DMA_HISR_HTIF7              (1u << 26)
+#define DMA_HISR_TCIF7              (1u << 27)
+#define DMA_HIFCR_CFEIF6            (1u << 16)
+#define DMA_HIFCR_CDMEIF6           (1u << 18)
+#define DMA_HIFCR_CTEIF6            (1u << 19)
+#define DMA_HIFCR_CHTIF6            (1u << 20)
+#define DMA_HIFCR_CTCIF6            (1u << 21)
+#define DMA_HIFCR_CFEIF7            (1u << 22)
+#define DMA_HIFCR_CDMEIF7           (1u << 24)
+#define DMA_HIFCR_CTEIF7            (1u << 25)
+#define DMA_HIFCR_CHTIF7            (1u << 26)
+#define DMA_HIFCR_CTCIF7            (1u << 27)
+
+/* TIM */
+#define TIM_CR1_CEN                 (1u << 0)
+#define TIM_CR1_UDIS                (1u << 1)
+#define TIM_CR1_URS                 (1u << 2)
+#define TIM_CR1_OPM                 (1u << 3)
+#define TIM_CR1_DIR                 (1u << 4)
+#define TIM_CR1_ARPE                (1u << 7)
+#define TIM_CR2_MMS_Pos             4
+#define TIM_CR2_MMS                 (7u << 4)
+#define TIM_CR2_MMS_0               (1u << 4)
+#define TIM_CR2_MMS_1               (2u << 4)
+#define TIM_CR2_MMS_2               (4u << 4)
+#define TIM_DIER_UIE                (1u << 0)
+#define TIM_DIER_CC1IE              (1u << 1)
+#define TIM_DIER_UDE                (1u << 8)
+#define TIM_SR_UIF                  (1u << 0)
+#define TIM_SR_CC1IF                (1u << 1)
+#define TIM_EGR_UG                  (1u << 0)
+#define TIM_CCMR1_OC1M_Pos          4
+#define TIM_CCMR1_OC1M              (7u << 4)
+#define TIM_CCMR1_OC1PE             (1u << 3)
+#define TIM_CCMR1_OC2M_Pos          12
+#define TIM_CCMR1_OC2M              (7u << 12)
+#define TIM_CCMR1_OC2PE             (1u << 11)
+#define TIM_CCMR2_OC3M_Pos          4
+#define TIM_CCMR2_OC3M              (7u << 4)
+#define TIM_CCMR2_OC3PE             (1u << 3)
+#define TIM_CCMR2_OC4M_Pos          12
+#define TIM_CCMR2_OC4M              (7u << 12)
+#define TIM_CCMR2_OC4PE             (1u << 11)
+#define TIM_CCER_CC1E               (1u << 0)
+#define TIM_CCER_CC1P               (1u << 1)
+#define TIM_CCER_CC2E               (1u << 4)
+#define TIM_CCER_CC3E               (1u << 8)
+#define TIM_CCER_CC4E               (1u << 12)
+#define TIM_CCER_CC4P               (1u << 13)
+
+/* SYSCFG */
+#define SYSCFG_EXTICR1_EXTI0_Pos    0
+#define SYSCFG_EXTICR1_EXTI1_Pos    4
+#define SYSCFG_EXTICR1_EXTI2_Pos    8
+#define SYSCFG_EXTICR1_EXTI3_Pos    12
+#define SYSCFG_EXTICR2_EXTI4_Pos    0
+#define SYSCFG_EXTICR2_EXTI5_Pos    4
+#define SYSCFG_EXTICR2_EXTI6_Pos    8
+#define SYSCFG_EXTICR2_EXTI7_Pos    12
+#define SYSCFG_EXTICR3_EXTI8_Pos    0
+#define SYSCFG_EXTICR3_EXTI9_Pos    4
+#define SYSCFG_EXTICR3_EXTI10_Pos   8
+#define SYSCFG_EXTICR3_EXTI11_Pos   12
+
+/* Core */
+#define SysTick_CTRL_ENABLE_Msk     (1u << 0)
+#define SysTick_CTRL_TICKINT_Msk    (1u << 1)
+#define SysTick_CTRL_CLKSOURCE_Msk  (1u << 2)
+#define SysTick_CTRL_COUNTFLAG_Msk  (1u << 16)
+#define SysTick_LOAD_RELOAD_Msk     (0xFFFFFFu)
+#define SysTick_VAL_CURRENT_Msk     (0xFFFFFFu)
+#define DWT_CTRL_CYCCNTENA_Msk      (1u << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk  (1u << 24)
+#define SCB_SCR_SLEEPONEXIT_Msk     (1u << 1)
+#define SCB_SCR_SLEEPDEEP_Msk       (1u << 2)
+
+#endif /* STM32F4XX_H */
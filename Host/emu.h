@@ -0,0 +1,151 @@
+/* ============================================================================
+ * Host Peripheral Emulator
+ * Virtual time, interrupt controller and register-file plumbing shared by the
+ * peripheral models, plus the control surface used by host programs.
+ *
+ * Registers are ordinary memory. Each emu_reg() call (every peripheral macro
+ * in the firmware) first commits what the firmware wrote since the last call
+ * by diffing against a shadow copy, advances virtual time by one bus access,
+ * runs any interrupt that became due, then refreshes the status registers of
+ * the peripheral being accessed.
+ * ============================================================================ */
+
+#ifndef EMU_H
+#define EMU_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define STM32F411xE
+#include "stm32f4xx.h"
+
+/* Virtual Time: picoseconds since reset */
+typedef uint64_t emu_time_t;
+
+#define EMU_PS_PER_US       1000000ull
+#define EMU_PS_PER_MS       1000000000ull
+#define EMU_PS_PER_S        1000000000000ull
+#define EMU_NEVER           UINT64_MAX
+
+#define EMU_ACCESS_CYCLES   2   /* HCLK cycles charged per register access */
+#define EMU_HSI_HZ          16000000u
+#define EMU_HSE_HZ          8000000u    /* Nucleo ST-LINK MCO */
+
+extern emu_time_t emu_now;
+extern uint64_t emu_cycles;             /* HCLK cycles since reset (DWT) */
+extern emu_time_t emu_sleep_time;       /* time spent in __WFI */
+
+/* Clock Tree: derived from the RCC registers */
+uint32_t emu_hclk(void);
+uint32_t emu_pclk1(void);
+uint32_t emu_pclk2(void);
+uint32_t emu_timclk1(void);
+emu_time_t emu_ps(uint64_t count, uint32_t hz);   /* duration of count clocks */
+emu_time_t emu_time_at_cycle(uint64_t cycle);     /* when emu_cycles reaches cycle */
+
+/* Register Binding: memory-backed registers plus a shadow of what the
+ * firmware last saw; commit() runs when they differ, present() refreshes
+ * read-side state before the firmware looks */
+typedef struct {
+    void (*commit)(int id, const void* old);
+    void (*present)(int id);
+} EMU_RegOps_t;
+
+void emu_bind(EMU_Periph_t id, void* regs, uint16_t size, const EMU_RegOps_t* ops);
+void emu_commit_all(void);
+
+/* Timed Models: next() returns when the model next has work (EMU_NEVER if
+ * idle), run() performs whatever is due at emu_now */
+typedef struct {
+    emu_time_t (*next)(void);
+    void (*run)(void);
+    void (*rebase)(void);       /* clock tree changed, may be NULL */
+} EMU_Model_t;
+
+void emu_add_model(const EMU_Model_t* m);
+void emu_clock_changed(void);
+void emu_stall(emu_time_t d);           /* core held on the bus: models run, interrupts wait */
+
+/* Interrupts: a line is pending while its level function returns non-zero
+ * or after emu_irq_pend(); on_exit runs when the handler returns */
+void emu_irq_level(IRQn_Type irq, uint8_t (*level)(void));
+void emu_irq_on_exit(IRQn_Type irq, void (*on_exit)(void));
+void emu_irq_pend(IRQn_Type irq);
+uint32_t emu_irq_count(IRQn_Type irq);
+const char* emu_irq_name(IRQn_Type irq);
+
+/* DMA Requests: level functions polled by the DMA model; read/write move
+ * one item between the peripheral and the stream */
+typedef enum { EMU_DREQ_ADC1, EMU_DREQ_I2C1_TX, EMU_DREQ_USART2_TX, EMU_DREQ_COUNT } EMU_DmaReq_t;
+
+void emu_dma_source(EMU_DmaReq_t req, uint8_t (*level)(void),
+                    uint32_t (*read)(void), void (*write)(uint32_t v));
+void emu_dma_service(void);
+
+/* Cross-Peripheral Signals */
+void emu_adc_trigger(uint8_t extsel);           /* timer TRGO */
+void emu_exti_edge(uint8_t port, uint8_t pin, uint8_t level);
+void emu_i2c_reset(void);                       /* RCC APB1RSTR.I2C1RST */
+void emu_fatal(const char* fmt, ...) __attribute__((noreturn, format(printf, 1, 2)));
+
+/* Control Surface */
+void emu_init(void);
+void emu_run_until(emu_time_t t);               /* from a host program's own loop */
+void emu_set_end(emu_time_t t, void (*on_end)(void));
+void emu_trace_enable(FILE* f);
+void emu_trace(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+
+void emu_button(uint8_t port, uint8_t pin, uint8_t pressed);
+void emu_adc_set(uint8_t channel, uint16_t value12, uint16_t noise);
+void emu_uart_capture(void (*tx)(uint8_t byte));
+void emu_uart_send(const uint8_t* data, uint16_t n);
+uint16_t emu_tim_pwm(uint8_t tim, uint8_t ch, uint32_t* freq_hz);  /* duty in 0.1% */
+
+/* I2C / Display */
+typedef struct {
+    uint32_t starts;            /* START conditions */
+    uint32_t bytes;             /* bytes clocked, address included */
+    uint32_t nacks;
+    emu_time_t busy;            /* SCL running, START to STOP */
+    uint32_t cmd_bytes;         /* SSD1306 command / data split */
+    uint32_t data_bytes;
+} EMU_I2CStats_t;
+
+extern EMU_I2CStats_t emu_i2c_stats;
+
+void emu_i2c_hang(void);                        /* next byte stalls: SCL held until I2C1 resets */
+
+/* SH1106 panel: begin() after the address is ACKed, then every byte */
+typedef enum { EMU_PANEL_CTRL, EMU_PANEL_CMD, EMU_PANEL_DATA } EMU_PanelByte_t;
+
+void emu_sh1106_init(void);
+void emu_sh1106_begin(void);
+EMU_PanelByte_t emu_sh1106_byte(uint8_t b);
+uint8_t emu_oled_pixel(uint8_t x, uint8_t y);
+uint8_t emu_oled_on(void);
+void emu_oled_write_pbm(FILE* f);
+void emu_oled_write_text(FILE* f);
+
+/* Flash: sectors 6-7 (the firmware's _sstore), optionally kept in a file */
+typedef struct {
+    uint32_t words;             /* 32-bit words programmed */
+    uint32_t erases;            /* sector erases */
+    emu_time_t stall;           /* core held by programs and erases */
+} EMU_FlashStats_t;
+
+extern EMU_FlashStats_t emu_flash_stats;
+
+uint8_t emu_flash_load(const char* path);       /* 0 = no such file, store left erased */
+void emu_flash_save(const char* path);
+
+/* Models (one init per file) */
+void emu_gpio_init(void);
+void emu_timers_init(void);
+void emu_serial_init(void);
+void emu_analog_init(void);
+void emu_dma_init(void);
+void emu_i2c_init(void);
+void emu_flash_init(void);
+void emu_flash_check_latency(void);             /* wait states against HCLK */
+
+#endif /* EMU_H */
@@ -0,0 +1,179 @@
+/* ============================================================================
+ * Host Emulator: ADC1
+ * Regular group only: SQR1..3 sequence, per-channel sample time plus
+ * resolution at ADCCLK = PCLK2 / ADCPRE, triggered by SWSTART or a timer
+ * TRGO. A result the DMA or firmware has not taken before the next one
+ * lands raises OVR and blocks DMA requests until CR2.DMA is toggled.
+ * ============================================================================ */
+
+#include "emu.h"
+
+#define CHANNELS        19
+#define DR_BITS(res)    (12 - 2 * (res))
+
+static ADC_TypeDef s_adc;
+static ADC_Common_TypeDef s_common;
+static uint32_t s_sr = 0;
+static uint8_t s_seq = 0;                       // rank being converted
+static uint8_t s_seq_active = 0;
+static emu_time_t s_conv_end = EMU_NEVER;
+static uint8_t s_pending = 0;                   // DR not yet read
+static uint8_t s_eoc_shown = 0;
+static uint8_t s_dma_blocked = 0;
+
+static uint16_t s_level[CHANNELS];
+static uint16_t s_noise[CHANNELS];
+static uint32_t s_rng = 0x2545F491u;
+
+void emu_adc_set(uint8_t channel, uint16_t value12, uint16_t noise) {
+    if(channel >= CHANNELS) emu_fatal("no ADC channel %u", channel);
+    s_level[channel] = value12 > 4095 ? 4095 : value12;
+    s_noise[channel] = noise;
+    emu_trace("ADC IN%u = %u +/- %u", channel, s_level[channel], noise);
+}
+
+static uint16_t sample(uint8_t channel) {
+    int32_t v = s_level[channel];
+    if(s_noise[channel]) {
+        s_rng = s_rng * 1664525u + 1013904223u;
+        v += (int32_t)((s_rng >> 16) % (2u * s_noise[channel] + 1)) - s_noise[channel];
+    }
+    if(v < 0) v = 0;
+    if(v > 4095) v = 4095;
+    return (uint16_t)v;
+}
+
+/* ============================================================================
+ * Sequencer
+ * ============================================================================ */
+static uint8_t seq_length(void) {
+    return (uint8_t)(((s_adc.SQR1 & ADC_SQR1_L) >> ADC_SQR1_L_Pos) + 1);
+}
+
+static uint8_t seq_channel(uint8_t rank) {
+    if(rank < 6)  return (uint8_t)((s_adc.SQR3 >> (rank * 5)) & 0x1Fu);
+    if(rank < 12) return (uint8_t)((s_adc.SQR2 >> ((rank - 6) * 5)) & 0x1Fu);
+    return (uint8_t)((s_adc.SQR1 >> ((rank - 12) * 5)) & 0x1Fu);
+}
+
+static emu_time_t conv_time(uint8_t channel) {
+    static const uint16_t SMP_CYCLES[8] = { 3, 15, 28, 56, 84, 112, 144, 480 };
+    uint32_t smp = channel < 10 ? (s_adc.SMPR2 >> (channel * 3)) & 7u
+                                : (s_adc.SMPR1 >> ((channel - 10) * 3)) & 7u;
+    uint32_t res = (s_adc.CR1 & ADC_CR1_RES) >> ADC_CR1_RES_Pos;
+    uint32_t pre = ((s_common.CCR & ADC_CCR_ADCPRE) >> ADC_CCR_ADCPRE_Pos) + 1;
+    uint32_t adcclk = emu_pclk2() / (pre * 2);
+    if(adcclk > 36000000u) emu_fatal("ADCCLK %lu Hz above 36 MHz (ADC_CCR ADCPRE)", (unsigned long)adcclk);
+    return emu_ps(SMP_CYCLES[smp] + DR_BITS(res), adcclk);
+}
+
+static void conv_start(void) {
+    s_sr |= ADC_SR_STRT;
+    s_conv_end = emu_now + conv_time(seq_channel(s_seq));
+}
+
+static void seq_start(void) {
+    if(!(s_adc.CR2 & ADC_CR2_ADON) || s_seq_active) return;
+    s_seq = 0;
+    s_seq_active = 1;
+    conv_start();
+}
+
+void emu_adc_trigger(uint8_t extsel) {
+    uint32_t exten = (s_adc.CR2 & ADC_CR2_EXTEN) >> ADC_CR2_EXTEN_Pos;
+    if(exten == 0 || exten == 2) return;        // off, or falling edge only
+    if(((s_adc.CR2 & ADC_CR2_EXTSEL) >> ADC_CR2_EXTSEL_Pos) != extsel) return;
+    seq_start();
+}
+
+static emu_time_t adc_next(void) {
+    return s_conv_end;
+}
+
+static void adc_run(void) {
+    uint8_t channel = seq_channel(s_seq);
+    uint32_t res = (s_adc.CR1 & ADC_CR1_RES) >> ADC_CR1_RES_Pos;
+    uint16_t v = sample(channel) >> (12 - DR_BITS(res));
+
+    s_conv_end = EMU_NEVER;
+    if(s_pending && (s_adc.CR2 & (ADC_CR2_DMA | ADC_CR2_EOCS))) {
+        s_sr |= ADC_SR_OVR;
+        s_dma_blocked = 1;
+    }
+    s_adc.DR = (s_adc.CR2 & ADC_CR2_ALIGN) ? (uint32_t)v << (16 - DR_BITS(res)) : v;
+    s_pending = 1;
+    s_sr |= ADC_SR_EOC;
+    s_eoc_shown = 0;
+
+    if(!(s_adc.CR1 & ADC_CR1_SCAN) || ++s_seq >= seq_length()) {
+        s_seq = 0;
+        s_seq_active = 0;
+        if(s_adc.CR2 & ADC_CR2_CONT) seq_start();
+    } else {
+        conv_start();
+    }
+}
+
+/* ============================================================================
+ * DMA Request
+ * ============================================================================ */
+static uint8_t adc_dma_level(void) {
+    if(!(s_adc.CR2 & ADC_CR2_DMA) || s_dma_blocked) return 0;
+    return s_pending;
+}
+
+static uint32_t adc_dma_read(void) {
+    s_pending = 0;
+    s_sr &= ~ADC_SR_EOC;
+    return s_adc.DR;
+}
+
+/* ============================================================================
+ * Registers
+ * ============================================================================ */
+static void adc_commit(int id, const void* old) {
+    const ADC_TypeDef* was = old;
+    (void)id;
+    s_sr &= ~(was->SR & ~s_adc.SR);             // rc_w0
+
+    if(!(s_adc.CR2 & ADC_CR2_ADON)) {
+        s_seq_active = 0;
+        s_conv_end = EMU_NEVER;
+    }
+    if((s_adc.CR2 & ADC_CR2_DMA) && !(was->CR2 & ADC_CR2_DMA)) s_dma_blocked = 0;
+    if(s_adc.CR2 & ADC_CR2_SWSTART) {
+        s_adc.CR2 &= ~ADC_CR2_SWSTART;
+        seq_start();
+    }
+}
+
+static void adc_present(int id) {
+    (void)id;
+    // A firmware read of DR with EOC showing takes the result
+    if(s_eoc_shown && !(s_adc.CR2 & ADC_CR2_DMA)) {
+        s_pending = 0;
+        s_sr &= ~ADC_SR_EOC;
+    }
+    s_eoc_shown = (s_sr & ADC_SR_EOC) != 0;
+    s_adc.SR = s_sr;
+}
+
+static uint8_t adc_irq(void) {
+    return ((s_sr & ADC_SR_EOC) && (s_adc.CR1 & ADC_CR1_EOCIE)) ||
+           ((s_sr & ADC_SR_OVR) && (s_adc.CR1 & ADC_CR1_OVRIE));
+}
+
+/* ============================================================================
+ * Initialization
+ * ============================================================================ */
+void emu_analog_init(void) {
+    static const EMU_RegOps_t ADC_OPS = { adc_commit, adc_present };
+    static const EMU_Model_t ADC_MODEL = { adc_next, adc_run, 0 };
+
+    for(uint8_t ch = 0; ch < CHANNELS; ch++) s_level[ch] = 2048;
+    emu_bind(EMU_ADC1, &s_adc, sizeof(s_adc), &ADC_OPS);
+    emu_bind(EMU_ADC_COMMON, &s_common, sizeof(s_common), 0);
+    emu_add_model(&ADC_MODEL);
+    emu_irq_level(ADC_IRQn, adc_irq);
+    emu_dma_source(EMU_DREQ_ADC1, adc_dma_level, adc_dma_read, 0);
+}
@@ -0,0 +1,676 @@
+/* ============================================================================
+ * Host Emulator Core
+ * Virtual time, register commit/present cycle, NVIC and the Cortex-M core
+ * peripherals (SysTick, DWT), plus RCC/PWR for the clock tree.
+ *
+ * Interrupts run at safe points: every register access, every core
+ * intrinsic, __WFI, and handler exit. Code that polls RAM an ISR updates
+ * (no register access in the loop) is caught by a host-timer watchdog that
+ * lets virtual time run on until a handler has executed.
+ * ============================================================================ */
+
+#include "emu.h"
+#include <signal.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define IRQ_SLOTS       (16 + 96)           /* exceptions, then IRQ0.. */
+#define IRQ_INDEX(n)    ((int)(n) + 16)
+#define THREAD_PRIO     0x100u
+#define MAX_MODELS      16
+#define SPIN_PERIOD_NS  50000               /* host time between spin checks */
+
+/* Global Variables */
+emu_time_t emu_now = 0;
+uint64_t emu_cycles = 0;
+emu_time_t emu_sleep_time = 0;
+
+typedef struct {
+    uint8_t* regs;
+    uint16_t size;
+    const EMU_RegOps_t* ops;
+    uint8_t shadow[256];
+} Bind_t;
+
+typedef struct {
+    void (*handler)(void);
+    uint8_t (*level)(void);
+    void (*on_exit)(void);
+    const char* name;
+    uint8_t enabled;
+    uint8_t latched;
+    uint16_t prio;
+    uint32_t count;
+} Irq_t;
+
+static Bind_t s_bind[EMU_PERIPH_COUNT];
+static uint64_t s_touched = 0;          // handed out since their last commit
+
+static const EMU_Model_t* s_models[MAX_MODELS];
+static uint8_t s_model_count = 0;
+static uint64_t s_cycle_frac = 0;       // ps x Hz carried between advances
+
+static Irq_t s_irq[IRQ_SLOTS];
+static uint8_t s_primask = 0;
+static uint16_t s_exec_prio = THREAD_PRIO;
+static uint32_t s_ipsr = 0;
+static uint8_t s_event_flag = 0;
+
+static emu_time_t s_end = EMU_NEVER;
+static void (*s_on_end)(void) = 0;
+static FILE* s_trace = 0;
+
+static volatile sig_atomic_t s_in_emu = 0;
+static volatile uint32_t s_safe_points = 0;
+static uint32_t s_spin_seen = 0;
+static uint8_t s_spin_quiet = 0;
+
+/* ============================================================================
+ * Firmware Vectors: weak so a build that lacks a handler still links
+ * ============================================================================ */
+#define VECTOR(name) extern void name(void) __attribute__((weak));
+VECTOR(SysTick_Handler)
+VECTOR(EXTI0_IRQHandler)        VECTOR(EXTI1_IRQHandler)        VECTOR(EXTI2_IRQHandler)
+VECTOR(EXTI3_IRQHandler)        VECTOR(EXTI4_IRQHandler)        VECTOR(EXTI9_5_IRQHandler)
+VECTOR(EXTI15_10_IRQHandler)    VECTOR(FLASH_IRQHandler)        VECTOR(ADC_IRQHandler)
+VECTOR(DMA1_Stream6_IRQHandler) VECTOR(DMA1_Stream7_IRQHandler) VECTOR(DMA2_Stream0_IRQHandler)
+VECTOR(TIM2_IRQHandler)         VECTOR(TIM3_IRQHandler)         VECTOR(TIM4_IRQHandler)
+VECTOR(TIM5_IRQHandler)         VECTOR(I2C1_EV_IRQHandler)      VECTOR(I2C1_ER_IRQHandler)
+VECTOR(USART2_IRQHandler)
+
+static void vectors_init(void) {
+    static const struct { IRQn_Type irq; void (*fn)(void); const char* name; } V[] = {
+        { SysTick_IRQn,      SysTick_Handler,         "SysTick" },
+        { EXTI0_IRQn,        EXTI0_IRQHandler,        "EXTI0" },
+        { EXTI1_IRQn,        EXTI1_IRQHandler,        "EXTI1" },
+        { EXTI2_IRQn,        EXTI2_IRQHandler,        "EXTI2" },
+        { EXTI3_IRQn,        EXTI3_IRQHandler,        "EXTI3" },
+        { EXTI4_IRQn,        EXTI4_IRQHandler,        "EXTI4" },
+        { EXTI9_5_IRQn,      EXTI9_5_IRQHandler,      "EXTI9_5" },
+        { EXTI15_10_IRQn,    EXTI15_10_IRQHandler,    "EXTI15_10" },
+        { FLASH_IRQn,        FLASH_IRQHandler,        "FLASH" },
+        { ADC_IRQn,          ADC_IRQHandler,          "ADC" },
+        { DMA1_Stream6_IRQn, DMA1_Stream6_IRQHandler, "DMA1_Stream6" },
+        { DMA1_Stream7_IRQn, DMA1_Stream7_IRQHandler, "DMA1_Stream7" },
+        { DMA2_Stream0_IRQn, DMA2_Stream0_IRQHandler, "DMA2_Stream0" },
+        { TIM2_IRQn,         TIM2_IRQHandler,         "TIM2" },
+        { TIM3_IRQn,         TIM3_IRQHandler,         "TIM3" },
+        { TIM4_IRQn,         TIM4_IRQHandler,         "TIM4" },
+        { TIM5_IRQn,         TIM5_IRQHandler,         "TIM5" },
+        { I2C1_EV_IRQn,      I2C1_EV_IRQHandler,      "I2C1_EV" },
+        { I2C1_ER_IRQn,      I2C1_ER_IRQHandler,      "I2C1_ER" },
+        { USART2_IRQn,       USART2_IRQHandler,       "USART2" },
+    };
+    for(size_t i = 0; i < sizeof(V) / sizeof(V[0]); i++) {
+        s_irq[IRQ_INDEX(V[i].irq)].handler = V[i].fn;
+        s_irq[IRQ_INDEX(V[i].irq)].name = V[i].name;
+    }
+    s_irq[IRQ_INDEX(SysTick_IRQn)].enabled = 1;     // gated by CTRL.TICKINT instead
+}
+
+/* ============================================================================
+ * Diagnostics
+ * ============================================================================ */
+void emu_fatal(const char* fmt, ...) {
+    va_list ap;
+    fprintf(stderr, "[EMU %.3f ms] fatal: ", (double)emu_now / EMU_PS_PER_MS);
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fputc('\n', stderr);
+    exit(2);
+}
+
+void emu_trace_enable(FILE* f) {
+    s_trace = f;
+}
+
+void emu_trace(const char* fmt, ...) {
+    if(!s_trace) return;
+    va_list ap;
+    fprintf(s_trace, "[%12.6f ms] ", (double)emu_now / EMU_PS_PER_MS);
+    va_start(ap, fmt);
+    vfprintf(s_trace, fmt, ap);
+    va_end(ap);
+    fputc('\n', s_trace);
+}
+
+/* ============================================================================
+ * Virtual Time
+ * ============================================================================ */
+emu_time_t emu_ps(uint64_t count, uint32_t hz) {
+    return (emu_time_t)(((unsigned __int128)count * EMU_PS_PER_S + hz - 1) / hz);
+}
+
+emu_time_t emu_time_at_cycle(uint64_t cycle) {
+    if(cycle <= emu_cycles) return emu_now;
+    unsigned __int128 need = (unsigned __int128)(cycle - emu_cycles) * EMU_PS_PER_S - s_cycle_frac;
+    uint32_t hz = emu_hclk();
+    return emu_now + (emu_time_t)((need + hz - 1) / hz);
+}
+
+static void set_time(emu_time_t t) {
+    unsigned __int128 acc = (unsigned __int128)(t - emu_now) * emu_hclk() + s_cycle_frac;
+    emu_cycles += (uint64_t)(acc / EMU_PS_PER_S);
+    s_cycle_frac = (uint64_t)(acc % EMU_PS_PER_S);
+    emu_now = t;
+}
+
+static void check_end(void) {
+    if(emu_now < s_end || !s_on_end) return;
+    void (*cb)(void) = s_on_end;
+    s_on_end = 0;
+    cb();
+}
+
+static emu_time_t next_event(int* which) {
+    emu_time_t next = EMU_NEVER;
+    for(int i = 0; i < s_model_count; i++) {
+        emu_time_t t = s_models[i]->next();
+        if(t < next) { next = t; *which = i; }
+    }
+    return next;
+}
+
+// Run every model event due up to t, then move the clock to t
+static void advance_to(emu_time_t t) {
+    for(;;) {
+        int which = -1;
+        emu_time_t next = next_event(&which);
+        if(next > t) break;
+        if(next > emu_now) set_time(next);
+        check_end();
+        s_models[which]->run();
+        emu_dma_service();
+    }
+    if(t > emu_now) set_time(t);
+    check_end();
+}
+
+static void charge(uint32_t cycles) {
+    advance_to(emu_time_at_cycle(emu_cycles + cycles));
+}
+
+void emu_add_model(const EMU_Model_t* m) {
+    if(s_model_count == MAX_MODELS) emu_fatal("too many models");
+    s_models[s_model_count++] = m;
+}
+
+// No safe point inside: whatever becomes pending is taken afterwards
+void emu_stall(emu_time_t d) {
+    advance_to(emu_now + d);
+}
+
+void emu_clock_changed(void) {
+    for(int i = 0; i < s_model_count; i++) {
+        if(s_models[i]->rebase) s_models[i]->rebase();
+    }
+}
+
+void emu_set_end(emu_time_t t, void (*on_end)(void)) {
+    s_end = t;
+    s_on_end = on_end;
+}
+
+/* ============================================================================
+ * Register Commit / Present
+ * ============================================================================ */
+void emu_bind(EMU_Periph_t id, void* regs, uint16_t size, const EMU_RegOps_t* ops) {
+    if(size > sizeof(s_bind[id].shadow)) emu_fatal("register block %d too large", id);
+    s_bind[id].regs = regs;
+    s_bind[id].size = size;
+    s_bind[id].ops = ops;
+    memcpy(s_bind[id].shadow, regs, size);
+}
+
+static void commit_one(int id) {
+    Bind_t* b = &s_bind[id];
+    if(memcmp(b->regs, b->shadow, b->size) == 0) return;
+    if(b->ops && b->ops->commit) b->ops->commit(id, b->shadow);
+    memcpy(b->shadow, b->regs, b->size);
+}
+
+void emu_commit_all(void) {
+    while(s_touched) {
+        int id = __builtin_ctzll(s_touched);
+        s_touched &= s_touched - 1;
+        commit_one(id);
+    }
+    emu_dma_service();
+}
+
+/* ============================================================================
+ * NVIC
+ * ============================================================================ */
+static uint8_t irq_pending(const Irq_t* q) {
+    return q->latched || (q->level && q->level());
+}
+
+// Highest-priority pending line that would preempt the running code
+static int irq_next(void) {
+    int best = -1;
+    uint16_t best_prio = s_exec_prio;
+    for(int i = 0; i < IRQ_SLOTS; i++) {
+        Irq_t* q = &s_irq[i];
+        if(!q->enabled || q->prio >= best_prio || !irq_pending(q)) continue;
+        best = i;
+        best_prio = q->prio;
+    }
+    return best;
+}
+
+static void irq_run(int i) {
+    Irq_t* q = &s_irq[i];
+    if(!q->handler) emu_fatal("%s pending with no handler", q->name ? q->name : "IRQ");
+
+    uint16_t prio = s_exec_prio;
+    uint32_t ipsr = s_ipsr;
+    q->latched = 0;
+    q->count++;
+    s_exec_prio = q->prio;
+    s_ipsr = (uint32_t)i;
+    charge(12);                         // exception entry
+
+    q->handler();
+
+    emu_commit_all();
+    if(q->on_exit) q->on_exit();
+    charge(10);                         // exception return
+    s_exec_prio = prio;
+    s_ipsr = ipsr;
+}
+
+static void deliver(void) {
+    while(!s_primask) {
+        emu_commit_all();
+        int i = irq_next();
+        if(i < 0) return;
+        irq_run(i);
+    }
+}
+
+void emu_irq_level(IRQn_Type irq, uint8_t (*level)(void)) {
+    s_irq[IRQ_INDEX(irq)].level = level;
+}
+
+void emu_irq_on_exit(IRQn_Type irq, void (*on_exit)(void)) {
+    s_irq[IRQ_INDEX(irq)].on_exit = on_exit;
+}
+
+void emu_irq_pend(IRQn_Type irq) {
+    s_irq[IRQ_INDEX(irq)].latched = 1;
+}
+
+uint32_t emu_irq_count(IRQn_Type irq) {
+    return s_irq[IRQ_INDEX(irq)].count;
+}
+
+const char* emu_irq_name(IRQn_Type irq) {
+    return s_irq[IRQ_INDEX(irq)].name;
+}
+
+/* ============================================================================
+ * Safe Points
+ * ============================================================================ */
+static void safe_point(uint32_t cycles) {
+    s_safe_points++;
+    s_in_emu = 1;
+    emu_commit_all();
+    charge(cycles);
+    s_in_emu = 0;
+    deliver();
+}
+
+void* emu_reg(EMU_Periph_t id) {
+    Bind_t* b = &s_bind[id];
+    if(!b->regs) emu_fatal("peripheral %d is not modelled", id);
+
+    safe_point(EMU_ACCESS_CYCLES);
+    s_in_emu = 1;
+    if(b->ops && b->ops->present) b->ops->present(id);
+    memcpy(b->shadow, b->regs, b->size);
+    s_touched |= 1ull << id;
+    s_in_emu = 0;
+    return b->regs;
+}
+
+void NVIC_EnableIRQ(IRQn_Type irq)           { s_irq[IRQ_INDEX(irq)].enabled = 1; safe_point(1); }
+void NVIC_DisableIRQ(IRQn_Type irq)          { s_irq[IRQ_INDEX(irq)].enabled = 0; safe_point(1); }
+void NVIC_SetPendingIRQ(IRQn_Type irq)       { emu_irq_pend(irq); safe_point(1); }
+void NVIC_ClearPendingIRQ(IRQn_Type irq)     { s_irq[IRQ_INDEX(irq)].latched = 0; safe_point(1); }
+uint32_t NVIC_GetPriority(IRQn_Type irq)     { return s_irq[IRQ_INDEX(irq)].prio; }
+
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority) {
+    s_irq[IRQ_INDEX(irq)].prio = priority & ((1u << __NVIC_PRIO_BITS) - 1);
+    safe_point(1);
+}
+
+void __enable_irq(void)             { s_primask = 0; safe_point(1); }
+void __disable_irq(void)            { s_primask = 1; safe_point(1); }
+void __set_PRIMASK(uint32_t v)      { s_primask = v & 1; safe_point(1); }
+uint32_t __get_PRIMASK(void)        { safe_point(1); return s_primask; }
+uint32_t __get_IPSR(void)           { safe_point(1); return s_ipsr; }
+uint32_t __get_MSP(void)            { volatile uint32_t sp = 0; return (uint32_t)(uintptr_t)&sp; }
+void __DSB(void)                    { safe_point(1); }
+void __DMB(void)                    { safe_point(1); }
+void __ISB(void)                    { safe_point(1); }
+void __NOP(void)                    { safe_point(1); }
+void __SEV(void)                    { s_event_flag = 1; safe_point(1); }
+
+// Sleep until a line that could preempt us is pending (PRIMASK only defers it)
+void __WFI(void) {
+    s_safe_points++;
+    s_in_emu = 1;
+    emu_commit_all();
+    emu_time_t start = emu_now;
+    while(irq_next() < 0) {
+        int which = -1;
+        emu_time_t next = next_event(&which);
+        if(next == EMU_NEVER) emu_fatal("__WFI with nothing left to wake the core");
+        advance_to(next);
+        emu_commit_all();
+    }
+    emu_sleep_time += emu_now - start;
+    s_in_emu = 0;
+    deliver();
+}
+
+void __WFE(void) {
+    if(s_event_flag) {
+        s_event_flag = 0;
+        safe_point(1);
+        return;
+    }
+    __WFI();
+}
+
+void emu_run_until(emu_time_t t) {
+    while(emu_now < t) {
+        int which = -1;
+        emu_time_t next = next_event(&which);
+        s_in_emu = 1;
+        emu_commit_all();
+        advance_to(next < t ? next : t);
+        s_in_emu = 0;
+        deliver();
+    }
+}
+
+/* ============================================================================
+ * Spin Watchdog
+ * A loop such as while(!I2C1_Idle()) makes no emulator calls, so virtual
+ * time would never reach the interrupt it waits for. If two checks in a row
+ * see no safe point, run the clock forward until some handler has executed.
+ * ============================================================================ */
+static void spin_check(int sig) {
+    (void)sig;
+    if(s_in_emu || s_safe_points != s_spin_seen) {
+        s_spin_seen = s_safe_points;
+        s_spin_quiet = 0;
+        return;
+    }
+    if(++s_spin_quiet < 2 || s_primask) return;
+    s_spin_quiet = 0;
+
+    s_in_emu = 1;
+    uint32_t before = 0;
+    for(int i = 0; i < IRQ_SLOTS; i++) before += s_irq[i].count;
+    for(;;) {
+        int which = -1;
+        emu_time_t next = next_event(&which);
+        if(next == EMU_NEVER) emu_fatal("polling loop with no pending events");
+        emu_commit_all();
+        advance_to(next);
+        s_in_emu = 0;
+        deliver();
+        s_in_emu = 1;
+        uint32_t after = 0;
+        for(int i = 0; i < IRQ_SLOTS; i++) after += s_irq[i].count;
+        if(after != before) break;
+    }
+    s_in_emu = 0;
+}
+
+static void spin_init(void) {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = spin_check;
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGVTALRM, &sa, 0);
+
+    timer_t timer;
+    struct sigevent ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.sigev_notify = SIGEV_SIGNAL;
+    ev.sigev_signo = SIGVTALRM;
+    if(timer_create(CLOCK_MONOTONIC, &ev, &timer) != 0) emu_fatal("timer_create failed");
+    struct itimerspec its = { { 0, SPIN_PERIOD_NS }, { 0, SPIN_PERIOD_NS } };
+    timer_settime(timer, 0, &its, 0);
+}
+
+/* ============================================================================
+ * RCC / PWR: ready flags follow their enables at once
+ * ============================================================================ */
+static RCC_TypeDef s_rcc;
+static PWR_TypeDef s_pwr;
+static uint32_t s_hclk = EMU_HSI_HZ, s_pclk1 = EMU_HSI_HZ, s_pclk2 = EMU_HSI_HZ, s_timclk1 = EMU_HSI_HZ;
+
+uint32_t emu_hclk(void)     { return s_hclk; }
+uint32_t emu_pclk1(void)    { return s_pclk1; }
+uint32_t emu_pclk2(void)    { return s_pclk2; }
+uint32_t emu_timclk1(void)  { return s_timclk1; }
+
+static void rcc_status(void) {
+    uint32_t cr = s_rcc.CR & ~(RCC_CR_HSIRDY | RCC_CR_HSERDY | RCC_CR_PLLRDY);
+    if(cr & RCC_CR_HSION) cr |= RCC_CR_HSIRDY;
+    if(cr & RCC_CR_HSEON) cr |= RCC_CR_HSERDY;
+    if(cr & RCC_CR_PLLON) cr |= RCC_CR_PLLRDY;
+    s_rcc.CR = cr;
+    s_rcc.CFGR = (s_rcc.CFGR & ~RCC_CFGR_SWS) | ((s_rcc.CFGR & RCC_CFGR_SW) << RCC_CFGR_SWS_Pos);
+}
+
+static void rcc_clocks(void) {
+    static const uint8_t AHB_SHIFT[16] = {0,0,0,0,0,0,0,0,1,2,3,4,6,7,8,9};
+    static const uint8_t APB_SHIFT[8]  = {0,0,0,0,1,2,3,4};
+    uint32_t cfgr = s_rcc.CFGR, pll = s_rcc.PLLCFGR;
+    uint64_t sys = EMU_HSI_HZ;
+
+    switch((cfgr & RCC_CFGR_SWS) >> RCC_CFGR_SWS_Pos) {
+        case 1: sys = EMU_HSE_HZ; break;
+        case 2: {
+            uint32_t m = (pll & RCC_PLLCFGR_PLLM) >> RCC_PLLCFGR_PLLM_Pos;
+            uint32_t n = (pll & RCC_PLLCFGR_PLLN) >> RCC_PLLCFGR_PLLN_Pos;
+            uint32_t p = (((pll & RCC_PLLCFGR_PLLP) >> RCC_PLLCFGR_PLLP_Pos) + 1) * 2;
+            uint64_t src = (pll & RCC_PLLCFGR_PLLSRC) ? EMU_HSE_HZ : EMU_HSI_HZ;
+            if(m < 2) emu_fatal("PLLM %lu is out of range", (unsigned long)m);
+            sys = src * n / m / p;
+            break;
+        }
+        default: break;
+    }
+
+    uint32_t hclk = (uint32_t)(sys >> AHB_SHIFT[(cfgr & RCC_CFGR_HPRE) >> RCC_CFGR_HPRE_Pos]);
+    uint32_t ppre1 = (cfgr & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos;
+    uint32_t ppre2 = (cfgr & RCC_CFGR_PPRE2) >> RCC_CFGR_PPRE2_Pos;
+    if(hclk == s_hclk && (hclk >> APB_SHIFT[ppre1]) == s_pclk1 && (hclk >> APB_SHIFT[ppre2]) == s_pclk2) return;
+
+    s_hclk = hclk;
+    s_pclk1 = hclk >> APB_SHIFT[ppre1];
+    s_pclk2 = hclk >> APB_SHIFT[ppre2];
+    s_timclk1 = (ppre1 >= 4) ? 2 * s_pclk1 : s_pclk1;
+    emu_trace("RCC HCLK %lu Hz, PCLK1 %lu Hz, PCLK2 %lu Hz", (unsigned long)s_hclk,
+              (unsigned long)s_pclk1, (unsigned long)s_pclk2);
+
+    // Datasheet limits; scale 2 is the reset value and tops out at 84 MHz
+    uint32_t vos = (s_pwr.CR & PWR_CR_VOS) >> PWR_CR_VOS_Pos;
+    if(s_hclk > 100000000u) emu_fatal("HCLK %lu Hz above 100 MHz", (unsigned long)s_hclk);
+    if(s_hclk > 84000000u && vos != 3)
+        emu_fatal("HCLK %lu Hz needs regulator scale 1 (PWR_CR VOS = 3)", (unsigned long)s_hclk);
+    if(s_pclk1 > 50000000u) emu_fatal("PCLK1 %lu Hz above 50 MHz", (unsigned long)s_pclk1);
+    emu_flash_check_latency();
+    emu_clock_changed();
+}
+
+static void rcc_commit(int id, const void* old) {
+    const RCC_TypeDef* was = old;
+    (void)id;
+    rcc_status();
+    if((s_rcc.APB1RSTR & RCC_APB1RSTR_I2C1RST) && !(was->APB1RSTR & RCC_APB1RSTR_I2C1RST))
+        emu_i2c_reset();
+    rcc_clocks();
+}
+
+static void rcc_present(int id) {
+    (void)id;
+    rcc_status();
+}
+
+static void pwr_present(int id) {
+    (void)id;
+    s_pwr.CSR |= PWR_CSR_VOSRDY;
+}
+
+/* ============================================================================
+ * SysTick: counts HCLK (or HCLK/8) cycles, tracked against emu_cycles. LOAD
+ * is latched as the counter leaves zero, so a write after that takes effect
+ * from the next period as on silicon
+ * ============================================================================ */
+static SysTick_Type s_systick;
+static uint64_t s_st_anchor = 0;        // emu_cycles when the counter held s_st_val
+static uint32_t s_st_val = 0;
+static uint32_t s_st_reload = 0;        // LOAD taken when the counter last left 0
+static uint8_t s_st_flag = 0;           // COUNTFLAG
+static uint8_t s_st_flag_shown = 0;
+
+static uint32_t st_div(void) {
+    return (s_systick.CTRL & SysTick_CTRL_CLKSOURCE_Msk) ? 1 : 8;
+}
+
+static uint32_t st_value(void) {
+    if(!(s_systick.CTRL & SysTick_CTRL_ENABLE_Msk)) return s_st_val;
+    uint64_t n = (emu_cycles - s_st_anchor) / st_div();
+    if(n <= s_st_val) return s_st_val - (uint32_t)n;
+    return s_st_reload - (uint32_t)((n - s_st_val - 1) % ((uint64_t)s_st_reload + 1));
+}
+
+static emu_time_t st_next(void) {
+    if(!(s_systick.CTRL & SysTick_CTRL_ENABLE_Msk)) return EMU_NEVER;
+    if(s_st_val == 0 && s_st_reload == 0) return EMU_NEVER;
+    uint64_t d = s_st_val ? s_st_val : (uint64_t)s_st_reload + 1;
+    return emu_time_at_cycle(s_st_anchor + d * st_div());
+}
+
+// Counter reached zero
+static void st_run(void) {
+    uint64_t d = s_st_val ? s_st_val : (uint64_t)s_st_reload + 1;
+    s_st_anchor += d * st_div();
+    s_st_val = 0;
+    s_st_reload = s_systick.LOAD & SysTick_LOAD_RELOAD_Msk;
+    s_st_flag = 1;
+    s_st_flag_shown = 0;
+    if(s_systick.CTRL & SysTick_CTRL_TICKINT_Msk) emu_irq_pend(SysTick_IRQn);
+}
+
+static void st_commit(int id, const void* old) {
+    const SysTick_Type* was = old;
+    const uint32_t ctrl_bits = SysTick_CTRL_ENABLE_Msk | SysTick_CTRL_TICKINT_Msk |
+                               SysTick_CTRL_CLKSOURCE_Msk;
+    (void)id;
+
+    // Freeze the count under the old settings before applying new ones
+    uint32_t now_val = 0;
+    uint32_t ctrl = s_systick.CTRL;
+    s_systick.CTRL = was->CTRL;
+    now_val = st_value();
+    s_systick.CTRL = (ctrl & ctrl_bits) | (s_st_flag ? SysTick_CTRL_COUNTFLAG_Msk : 0);
+
+    if(s_systick.VAL != was->VAL) {
+        now_val = 0;                    // any write clears the counter
+        s_st_flag = 0;
+    }
+    s_st_val = now_val;
+    s_st_anchor = emu_cycles;
+    if(now_val == 0) s_st_reload = s_systick.LOAD & SysTick_LOAD_RELOAD_Msk;
+}
+
+static void st_present(int id) {
+    (void)id;
+    if(s_st_flag_shown) s_st_flag = 0;  // COUNTFLAG clears once read
+    s_st_flag_shown = s_st_flag;
+    s_systick.VAL = st_value();
+    s_systick.CTRL = (s_systick.CTRL & ~SysTick_CTRL_COUNTFLAG_Msk) |
+                     (s_st_flag ? SysTick_CTRL_COUNTFLAG_Msk : 0);
+}
+
+uint32_t SysTick_Config(uint32_t ticks) {
+    if(ticks - 1 > SysTick_LOAD_RELOAD_Msk) return 1;
+    SysTick->LOAD = ticks - 1;
+    NVIC_SetPriority(SysTick_IRQn, (1u << __NVIC_PRIO_BITS) - 1);
+    SysTick->VAL = 0;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+    return 0;
+}
+
+/* ============================================================================
+ * DWT Cycle Counter
+ * ============================================================================ */
+static DWT_Type s_dwt;
+static CoreDebug_Type s_coredebug;
+static SCB_Type s_scb;
+static uint64_t s_dwt_base = 0;         // emu_cycles where CYCCNT was 0
+static uint32_t s_dwt_frozen = 0;
+
+static void dwt_commit(int id, const void* old) {
+    const DWT_Type* was = old;
+    (void)id;
+    uint32_t running = was->CTRL & DWT_CTRL_CYCCNTENA_Msk;
+    uint32_t count = running ? (uint32_t)(emu_cycles - s_dwt_base) : s_dwt_frozen;
+    if(s_dwt.CYCCNT != was->CYCCNT) count = s_dwt.CYCCNT;
+    s_dwt_frozen = count;
+    s_dwt_base = emu_cycles - count;
+}
+
+static void dwt_present(int id) {
+    (void)id;
+    s_dwt.CYCCNT = (s_dwt.CTRL & DWT_CTRL_CYCCNTENA_Msk) ? (uint32_t)(emu_cycles - s_dwt_base)
+                                                         : s_dwt_frozen;
+}
+
+/* ============================================================================
+ * Initialization
+ * ============================================================================ */
+void emu_init(void) {
+    static const EMU_RegOps_t RCC_OPS = { rcc_commit, rcc_present };
+    static const EMU_RegOps_t PWR_OPS = { 0, pwr_present };
+    static const EMU_RegOps_t ST_OPS  = { st_commit, st_present };
+    static const EMU_RegOps_t DWT_OPS = { dwt_commit, dwt_present };
+    static const EMU_Model_t ST_MODEL = { st_next, st_run, 0 };
+
+    vectors_init();
+
+    s_rcc.CR = 0x00000083;              // HSION | HSIRDY | HSITRIM=16
+    s_rcc.PLLCFGR = 0x24003010;
+    s_pwr.CR = 2u << PWR_CR_VOS_Pos;
+    s_systick.CALIB = 0x40000000u | (EMU_HSI_HZ / 8000);
+    s_scb.CPUID = 0x410FC241;           // Cortex-M4 r0p1
+
+    emu_bind(EMU_RCC, &s_rcc, sizeof(s_rcc), &RCC_OPS);
+    emu_bind(EMU_PWR, &s_pwr, sizeof(s_pwr), &PWR_OPS);
+    emu_bind(EMU_SYSTICK, &s_systick, sizeof(s_systick), &ST_OPS);
+    emu_bind(EMU_DWT, &s_dwt, sizeof(s_dwt), &DWT_OPS);
+    emu_bind(EMU_COREDEBUG, &s_coredebug, sizeof(s_coredebug), 0);
+    emu_bind(EMU_SCB, &s_scb, sizeof(s_scb), 0);
+    emu_add_model(&ST_MODEL);
+
+    emu_gpio_init();
+    emu_timers_init();
+    emu_serial_init();
+    emu_analog_init();
+    emu_dma_init();
+    emu_i2c_init();
+    emu_flash_init();
+
+    spin_init();
+}
@@ -0,0 +1,226 @@
+/* ============================================================================
+ * Host Emulator: DMA1 / DMA2
+ * Peripheral requests are level functions; while one is high and a stream
+ * selected for it is enabled, items move at once (bus time is not charged).
+ * Addresses are host pointers, so memory-side transfers touch firmware RAM
+ * directly; the peripheral side goes through the model's read/write hooks.
+ * ============================================================================ */
+
+#include "emu.h"
+#include <string.h>
+
+#define STREAMS         16      /* DMA1 S0..7, DMA2 S0..7 */
+
+#define FLAG_FE         (1u << 0)
+#define FLAG_DME        (1u << 2)
+#define FLAG_TE         (1u << 3)
+#define FLAG_HT         (1u << 4)
+#define FLAG_TC         (1u << 5)
+
+typedef struct {
+    DMA_Stream_TypeDef regs;
+    uint8_t active;
+    uint32_t ndtr;              // items left
+    uint32_t length;            // NDTR at enable, for HT and circular reload
+} Stream_t;
+
+typedef struct {
+    EMU_DmaReq_t req;
+    uint8_t stream;             // 0..15
+    uint8_t channel;
+} Route_t;
+
+typedef struct {
+    uint8_t (*level)(void);
+    uint32_t (*read)(void);
+    void (*write)(uint32_t v);
+} Source_t;
+
+static const Route_t ROUTES[] = {
+    { EMU_DREQ_ADC1,       8 + 0, 0 },
+    { EMU_DREQ_ADC1,       8 + 4, 0 },
+    { EMU_DREQ_I2C1_TX,    6,     1 },
+    { EMU_DREQ_I2C1_TX,    7,     1 },
+    { EMU_DREQ_USART2_TX,  6,     4 },
+};
+
+static const uint8_t FLAG_SHIFT[4] = { 0, 6, 16, 22 };
+
+static DMA_TypeDef s_dma[2];
+static uint32_t s_isr[2][2];            // [controller][LISR, HISR]
+static Stream_t s_stream[STREAMS];
+static Source_t s_source[EMU_DREQ_COUNT];
+
+void emu_dma_source(EMU_DmaReq_t req, uint8_t (*level)(void),
+                    uint32_t (*read)(void), void (*write)(uint32_t v)) {
+    s_source[req].level = level;
+    s_source[req].read = read;
+    s_source[req].write = write;
+}
+
+/* ============================================================================
+ * Stream Flags
+ * ============================================================================ */
+static uint32_t* flag_word(uint8_t n) {
+    return &s_isr[n / 8][(n % 8) / 4];
+}
+
+static uint32_t stream_flags(uint8_t n) {
+    return (*flag_word(n) >> FLAG_SHIFT[n % 4]) & 0x3Fu;
+}
+
+static void stream_flag(uint8_t n, uint32_t flag) {
+    *flag_word(n) |= flag << FLAG_SHIFT[n % 4];
+}
+
+static uint8_t stream_irq(uint8_t n) {
+    const Stream_t* s = &s_stream[n];
+    uint32_t f = stream_flags(n), cr = s->regs.CR;
+    return ((f & FLAG_TC) && (cr & DMA_SxCR_TCIE)) ||
+           ((f & FLAG_HT) && (cr & DMA_SxCR_HTIE)) ||
+           ((f & FLAG_TE) && (cr & DMA_SxCR_TEIE)) ||
+           ((f & FLAG_DME) && (cr & DMA_SxCR_DMEIE)) ||
+           ((f & FLAG_FE) && (s->regs.FCR & (1u << 7)));
+}
+
+/* ============================================================================
+ * Transfers
+ * ============================================================================ */
+static uint32_t item_size(uint32_t cr) {
+    return 1u << ((cr & DMA_SxCR_MSIZE) >> DMA_SxCR_MSIZE_Pos);
+}
+
+static uintptr_t mem_addr(const Stream_t* s) {
+    uint32_t done = s->length - s->ndtr;
+    return s->regs.M0AR + ((s->regs.CR & DMA_SxCR_MINC) ? done * item_size(s->regs.CR) : 0);
+}
+
+static void mem_store(uintptr_t a, uint32_t size, uint32_t v) {
+    if(size == 1)      *(uint8_t*)a = (uint8_t)v;
+    else if(size == 2) *(uint16_t*)a = (uint16_t)v;
+    else               *(uint32_t*)a = v;
+}
+
+static uint32_t mem_load(uintptr_t a, uint32_t size) {
+    if(size == 1) return *(const uint8_t*)a;
+    if(size == 2) return *(const uint16_t*)a;
+    return *(const uint32_t*)a;
+}
+
+static void stream_item(uint8_t n, const Source_t* src) {
+    Stream_t* s = &s_stream[n];
+    uint32_t size = item_size(s->regs.CR);
+    uint32_t dir = (s->regs.CR & DMA_SxCR_DIR) >> DMA_SxCR_DIR_Pos;
+
+    if(dir == 0 && src->read) {
+        mem_store(mem_addr(s), size, src->read());
+    } else if(dir == 1 && src->write) {
+        src->write(mem_load(mem_addr(s), size));
+    } else {
+        stream_flag(n, FLAG_TE);        // no such path on this request
+        s->active = 0;
+        return;
+    }
+
+    s->ndtr--;
+    if(s->ndtr == s->length / 2) stream_flag(n, FLAG_HT);
+    if(s->ndtr == 0) {
+        stream_flag(n, FLAG_TC);
+        if(s->regs.CR & DMA_SxCR_CIRC) s->ndtr = s->length;
+        else s->active = 0;
+    }
+}
+
+void emu_dma_service(void) {
+    for(size_t r = 0; r < sizeof(ROUTES) / sizeof(ROUTES[0]); r++) {
+        const Route_t* route = &ROUTES[r];
+        const Source_t* src = &s_source[route->req];
+        Stream_t* s = &s_stream[route->stream];
+        if(!src->level) continue;
+        while(s->active && ((s->regs.CR & DMA_SxCR_CHSEL) >> DMA_SxCR_CHSEL_Pos) == route->channel &&
+              src->level()) {
+            stream_item(route->stream, src);
+        }
+    }
+}
+
+/* ============================================================================
+ * Registers
+ * ============================================================================ */
+static void stream_commit(int id, const void* old) {
+    uint8_t n = (uint8_t)(id - EMU_DMA1_STREAM0);
+    Stream_t* s = &s_stream[n];
+    const DMA_Stream_TypeDef* was = old;
+
+    if(!s->active && s->regs.NDTR != was->NDTR) s->ndtr = s->regs.NDTR & 0xFFFFu;
+
+    if((s->regs.CR & DMA_SxCR_EN) && !(was->CR & DMA_SxCR_EN)) {
+        if(s->ndtr == 0) {
+            s->regs.CR &= ~DMA_SxCR_EN;
+            return;
+        }
+        s->length = s->ndtr;
+        s->active = 1;
+        if((s->regs.CR & DMA_SxCR_DIR) == DMA_SxCR_DIR_1) emu_fatal("DMA%u Stream%u: memory-to-memory is not modelled", n / 8 + 1, n % 8);
+    } else if(!(s->regs.CR & DMA_SxCR_EN) && (was->CR & DMA_SxCR_EN) && s->active) {
+        // Disabled mid-transfer: the stream stops and reports TC
+        s->active = 0;
+        stream_flag(n, FLAG_TC);
+    }
+}
+
+static void stream_present(int id) {
+    Stream_t* s = &s_stream[id - EMU_DMA1_STREAM0];
+    s->regs.CR = (s->regs.CR & ~DMA_SxCR_EN) | (s->active ? DMA_SxCR_EN : 0);
+    s->regs.NDTR = s->ndtr;
+}
+
+static void dma_commit(int id, const void* old) {
+    uint8_t c = (uint8_t)(id - EMU_DMA1);
+    (void)old;
+    s_isr[c][0] &= ~s_dma[c].LIFCR;
+    s_isr[c][1] &= ~s_dma[c].HIFCR;
+    s_dma[c].LIFCR = 0;
+    s_dma[c].HIFCR = 0;
+}
+
+static void dma_present(int id) {
+    uint8_t c = (uint8_t)(id - EMU_DMA1);
+    s_dma[c].LISR = s_isr[c][0];
+    s_dma[c].HISR = s_isr[c][1];
+    s_dma[c].LIFCR = 0;
+    s_dma[c].HIFCR = 0;
+}
+
+#define STREAM_IRQ(n) static uint8_t stream_irq_##n(void) { return stream_irq(n); }
+STREAM_IRQ(0)  STREAM_IRQ(1)  STREAM_IRQ(2)  STREAM_IRQ(3)
+STREAM_IRQ(4)  STREAM_IRQ(5)  STREAM_IRQ(6)  STREAM_IRQ(7)
+STREAM_IRQ(8)  STREAM_IRQ(9)  STREAM_IRQ(10) STREAM_IRQ(11)
+STREAM_IRQ(12) STREAM_IRQ(13) STREAM_IRQ(14) STREAM_IRQ(15)
+
+/* ============================================================================
+ * Initialization
+ * ============================================================================ */
+void emu_dma_init(void) {
+    static const EMU_RegOps_t DMA_OPS = { dma_commit, dma_present };
+    static const EMU_RegOps_t STREAM_OPS = { stream_commit, stream_present };
+    static const struct { IRQn_Type irq; uint8_t (*level)(void); } IRQS[STREAMS] = {
+        { DMA1_Stream0_IRQn, stream_irq_0 },  { DMA1_Stream1_IRQn, stream_irq_1 },
+        { DMA1_Stream2_IRQn, stream_irq_2 },  { DMA1_Stream3_IRQn, stream_irq_3 },
+        { DMA1_Stream4_IRQn, stream_irq_4 },  { DMA1_Stream5_IRQn, stream_irq_5 },
+        { DMA1_Stream6_IRQn, stream_irq_6 },  { DMA1_Stream7_IRQn, stream_irq_7 },
+        { DMA2_Stream0_IRQn, stream_irq_8 },  { DMA2_Stream1_IRQn, stream_irq_9 },
+        { DMA2_Stream2_IRQn, stream_irq_10 }, { DMA2_Stream3_IRQn, stream_irq_11 },
+        { DMA2_Stream4_IRQn, stream_irq_12 }, { DMA2_Stream5_IRQn, stream_irq_13 },
+        { DMA2_Stream6_IRQn, stream_irq_14 }, { DMA2_Stream7_IRQn, stream_irq_15 },
+    };
+
+    emu_bind(EMU_DMA1, &s_dma[0], sizeof(DMA_TypeDef), &DMA_OPS);
+    emu_bind(EMU_DMA2, &s_dma[1], sizeof(DMA_TypeDef), &DMA_OPS);
+    for(uint8_t n = 0; n < STREAMS; n++) {
+        s_stream[n].regs.FCR = 0x21;
+        emu_bind((EMU_Periph_t)(EMU_DMA1_STREAM0 + n), &s_stream[n].regs,
+                 sizeof(DMA_Stream_TypeDef), &STREAM_OPS);
+        emu_irq_level(IRQS[n].irq, IRQS[n].level);
+    }
+}
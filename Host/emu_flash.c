@@ -0,0 +1,156 @@
+/* ============================================================================
+ * Host Emulator: Flash Interface and Store Sectors
+ * Sectors 6 and 7 are host memory under the linker symbol _sstore, so the
+ * firmware reads them directly. A write to them is found at the next FLASH
+ * register access by comparing against a copy; it must happen with the
+ * interface unlocked and PG set, and only clears bits, as on silicon.
+ * Programs and erases stall the core for their typical duration (x32):
+ * virtual time and the models advance, interrupts wait.
+ * ============================================================================ */
+
+#include "emu.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define STORE_BASE          0x08040000u
+#define STORE_FIRST_SECTOR  6
+#define STORE_SECTORS       2
+#define SECTOR_WORDS        (128u * 1024u / 4)
+#define STORE_WORDS         (STORE_SECTORS * SECTOR_WORDS)
+#define KEY1                0x45670123u
+#define KEY2                0xCDEF89ABu
+#define PROGRAM_PS          (16 * EMU_PS_PER_US)    /* one 32-bit word */
+#define ERASE_PS            (1000 * EMU_PS_PER_MS)  /* one 128K sector */
+
+uint32_t _sstore[STORE_WORDS];          // the firmware's linker symbol
+EMU_FlashStats_t emu_flash_stats;
+
+static uint32_t s_seen[STORE_WORDS];    // contents after the last check
+static FLASH_TypeDef s_flash;
+static uint8_t s_key_step = 0;          // KEY1 written, KEY2 expected
+
+static void stall(emu_time_t d) {
+    emu_flash_stats.stall += d;
+    emu_stall(d);
+}
+
+/* ============================================================================
+ * Programming
+ * ============================================================================ */
+static void check_writes(void) {
+    if(memcmp(_sstore, s_seen, sizeof(s_seen)) == 0) return;
+
+    uint32_t cr = s_flash.CR, words = 0;
+    for(uint32_t i = 0; i < STORE_WORDS; i++) {
+        if(_sstore[i] == s_seen[i]) continue;
+        unsigned long addr = STORE_BASE + i * 4;
+        if((cr & FLASH_CR_LOCK) || !(cr & FLASH_CR_PG))
+            emu_fatal("flash word 0x%08lx written without FLASH_CR_PG", addr);
+        if((cr & FLASH_CR_PSIZE) != FLASH_CR_PSIZE_1)
+            emu_fatal("flash word 0x%08lx programmed with PSIZE other than x32", addr);
+        if(_sstore[i] & ~s_seen[i]) emu_trace("FLASH 0x%08lx programmed while not erased", addr);
+        _sstore[i] &= s_seen[i];
+        s_seen[i] = _sstore[i];
+        words++;
+    }
+    emu_flash_stats.words += words;
+    stall(words * PROGRAM_PS);
+}
+
+static void erase(uint32_t cr) {
+    if(cr & FLASH_CR_MER) emu_fatal("flash mass erase");
+    uint32_t snb = (cr & FLASH_CR_SNB) >> FLASH_CR_SNB_Pos;
+    if(snb < STORE_FIRST_SECTOR || snb >= STORE_FIRST_SECTOR + STORE_SECTORS)
+        emu_fatal("erase of flash sector %lu, outside the store", (unsigned long)snb);
+
+    uint32_t first = (snb - STORE_FIRST_SECTOR) * SECTOR_WORDS;
+    memset(&_sstore[first], 0xFF, SECTOR_WORDS * 4);
+    memset(&s_seen[first], 0xFF, SECTOR_WORDS * 4);
+    emu_flash_stats.erases++;
+    emu_trace("FLASH erase sector %lu", (unsigned long)snb);
+    stall(ERASE_PS);
+}
+
+/* ============================================================================
+ * Registers
+ * ============================================================================ */
+// Too few wait states for HCLK, limits for 2.7-3.6 V
+void emu_flash_check_latency(void) {
+    static const uint32_t MAX_MHZ[4] = { 30, 64, 90, 100 };
+    uint32_t ws = s_flash.ACR & FLASH_ACR_LATENCY;
+    if(ws < 4 && emu_hclk() > MAX_MHZ[ws] * 1000000u)
+        emu_fatal("HCLK %lu Hz with FLASH_ACR latency %lu WS", (unsigned long)emu_hclk(),
+                  (unsigned long)ws);
+}
+
+static void flash_commit(int id, const void* old) {
+    const FLASH_TypeDef* was = old;
+    (void)id;
+    check_writes();
+
+    if((s_flash.ACR ^ was->ACR) & FLASH_ACR_LATENCY) emu_flash_check_latency();
+
+    if(s_flash.SR != was->SR) {
+        // Status bits clear by writing 1, BSY is read-only
+        s_flash.SR = was->SR & ~(s_flash.SR & ~FLASH_SR_BSY);
+    }
+
+    if(s_flash.CR != was->CR) {
+        if(was->CR & FLASH_CR_LOCK) {
+            s_flash.CR = was->CR;       // ignored until unlocked
+        } else if((s_flash.CR & FLASH_CR_STRT) && (s_flash.CR & (FLASH_CR_SER | FLASH_CR_MER))) {
+            erase(s_flash.CR);
+            s_flash.CR &= ~FLASH_CR_STRT;
+        }
+    }
+
+    if(s_flash.KEYR != was->KEYR) {
+        uint32_t key = s_flash.KEYR;
+        s_flash.KEYR = 0;               // write-only
+        if(!(s_flash.CR & FLASH_CR_LOCK)) return;
+        if(s_key_step == 0 && key == KEY1) {
+            s_key_step = 1;
+        } else if(s_key_step == 1 && key == KEY2) {
+            s_key_step = 0;
+            s_flash.CR &= ~FLASH_CR_LOCK;
+        } else {
+            emu_fatal("wrong FLASH_KEYR sequence (0x%08lx)", (unsigned long)key);
+        }
+    }
+}
+
+static void flash_present(int id) {
+    (void)id;
+    check_writes();
+}
+
+/* ============================================================================
+ * Control Surface
+ * ============================================================================ */
+uint8_t emu_flash_load(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if(!f) return 0;
+    size_t n = fread(_sstore, 4, STORE_WORDS, f);
+    fclose(f);
+    if(n != STORE_WORDS) emu_fatal("%s: not a %u KB store image", path, STORE_WORDS * 4 / 1024);
+    memcpy(s_seen, _sstore, sizeof(s_seen));
+    return 1;
+}
+
+void emu_flash_save(const char* path) {
+    FILE* f = fopen(path, "wb");
+    if(!f || fwrite(s_seen, 4, STORE_WORDS, f) != STORE_WORDS) {
+        perror(path);
+        exit(2);
+    }
+    fclose(f);
+}
+
+void emu_flash_init(void) {
+    static const EMU_RegOps_t FLASH_OPS = { flash_commit, flash_present };
+
+    memset(_sstore, 0xFF, sizeof(_sstore));
+    memset(s_seen, 0xFF, sizeof(s_seen));
+    s_flash.CR = FLASH_CR_LOCK;
+    emu_bind(EMU_FLASH, &s_flash, sizeof(s_flash), &FLASH_OPS);
+}
@@ -0,0 +1,167 @@
+/* ============================================================================
+ * Host Emulator: GPIO, SYSCFG and EXTI
+ * Pin levels combine ODR for outputs with what the outside world drives
+ * (buttons pull to ground) and the configured pull resistors for inputs.
+ * Input edges on lines routed through SYSCFG set EXTI pending bits.
+ * ============================================================================ */
+
+#include "emu.h"
+#include <string.h>
+
+#define PORTS   3
+
+static GPIO_TypeDef s_gpio[PORTS];
+static uint16_t s_drive_low[PORTS];     // pins pulled to ground externally
+static uint16_t s_level[PORTS];         // last pin levels seen by EXTI
+
+static SYSCFG_TypeDef s_syscfg;
+static EXTI_TypeDef s_exti;
+static uint32_t s_pr = 0;               // EXTI pending lines
+static uint32_t s_pr_shown = 0;         // pending lines the firmware has read
+
+/* ============================================================================
+ * Pins
+ * ============================================================================ */
+static uint16_t pin_levels(uint8_t port) {
+    const GPIO_TypeDef* g = &s_gpio[port];
+    uint16_t levels = 0;
+    for(uint8_t pin = 0; pin < 16; pin++) {
+        uint32_t mode = (g->MODER >> (pin * 2)) & 3u;
+        uint32_t pull = (g->PUPDR >> (pin * 2)) & 3u;
+        uint8_t high;
+        if(mode == 1) {
+            // Output: push-pull drives ODR, open-drain only pulls low
+            high = (g->ODR >> pin) & 1u;
+            if((g->OTYPER >> pin) & 1u) high = high && pull != 2;
+        } else {
+            // Input, or AF with the modelled peripherals idling high; a
+            // floating pin reads high
+            high = (pull != 2);
+        }
+        if(s_drive_low[port] & (1u << pin)) high = 0;
+        if(high) levels |= 1u << pin;
+    }
+    return levels;
+}
+
+static void pins_changed(uint8_t port) {
+    uint16_t now = pin_levels(port);
+    uint16_t diff = now ^ s_level[port];
+    s_level[port] = now;
+    for(uint8_t pin = 0; pin < 16; pin++) {
+        if(diff & (1u << pin)) emu_exti_edge(port, pin, (now >> pin) & 1u);
+    }
+}
+
+static void gpio_commit(int id, const void* old) {
+    uint8_t port = (uint8_t)(id - EMU_GPIOA);
+    GPIO_TypeDef* g = &s_gpio[port];
+    const GPIO_TypeDef* was = old;
+
+    if(g->BSRR) {
+        g->ODR = (g->ODR | (g->BSRR & 0xFFFFu)) & ~(g->BSRR >> 16);
+        g->BSRR = 0;
+    }
+    g->IDR = was->IDR;                  // read-only
+    if(g->ODR != was->ODR) emu_trace("GPIO%c ODR %04lx", 'A' + port, (unsigned long)g->ODR);
+    pins_changed(port);
+}
+
+static void gpio_present(int id) {
+    uint8_t port = (uint8_t)(id - EMU_GPIOA);
+    s_gpio[port].IDR = pin_levels(port);
+    s_gpio[port].BSRR = 0;
+}
+
+// Drive a button: pressed pulls the pin to ground
+void emu_button(uint8_t port, uint8_t pin, uint8_t pressed) {
+    if(port >= PORTS || pin > 15) emu_fatal("no pin P%c%u", 'A' + port, pin);
+    if(pressed) s_drive_low[port] |= 1u << pin;
+    else        s_drive_low[port] &= ~(1u << pin);
+    emu_trace("P%c%u %s", 'A' + port, pin, pressed ? "pressed" : "released");
+    pins_changed(port);
+}
+
+/* ============================================================================
+ * EXTI
+ * PR is write-1-to-clear, and writing back exactly the value just read can't
+ * be told apart from no write at all. Lines the handler has seen pending are
+ * therefore also acknowledged when the handler returns.
+ * ============================================================================ */
+void emu_exti_edge(uint8_t port, uint8_t pin, uint8_t level) {
+    uint32_t route = (s_syscfg.EXTICR[pin / 4] >> ((pin % 4) * 4)) & 0xFu;
+    uint32_t bit = 1u << pin;
+    if(route != port || !(s_exti.IMR & bit)) return;
+    if(( level && (s_exti.RTSR & bit)) || (!level && (s_exti.FTSR & bit))) s_pr |= bit;
+}
+
+static void exti_commit(int id, const void* old) {
+    const EXTI_TypeDef* was = old;
+    (void)id;
+    if(s_exti.PR != was->PR) s_pr &= ~s_exti.PR;
+    s_pr |= s_exti.SWIER & ~was->SWIER & s_exti.IMR;
+    s_exti.SWIER &= ~s_pr;
+}
+
+static void exti_present(int id) {
+    (void)id;
+    s_exti.PR = s_pr;
+    s_pr_shown |= s_pr;
+}
+
+static uint8_t exti_pending(uint32_t lines) {
+    return (s_pr & s_exti.IMR & lines) != 0;
+}
+
+static uint8_t exti0(void)      { return exti_pending(1u << 0); }
+static uint8_t exti1(void)      { return exti_pending(1u << 1); }
+static uint8_t exti2(void)      { return exti_pending(1u << 2); }
+static uint8_t exti3(void)      { return exti_pending(1u << 3); }
+static uint8_t exti4(void)      { return exti_pending(1u << 4); }
+static uint8_t exti9_5(void)    { return exti_pending(0x03E0u); }
+static uint8_t exti15_10(void)  { return exti_pending(0xFC00u); }
+
+static void exti_ack(uint32_t lines) {
+    s_pr &= ~(s_pr_shown & lines);
+    s_pr_shown &= ~lines;
+}
+
+static void exti0_exit(void)     { exti_ack(1u << 0); }
+static void exti1_exit(void)     { exti_ack(1u << 1); }
+static void exti2_exit(void)     { exti_ack(1u << 2); }
+static void exti3_exit(void)     { exti_ack(1u << 3); }
+static void exti4_exit(void)     { exti_ack(1u << 4); }
+static void exti9_5_exit(void)   { exti_ack(0x03E0u); }
+static void exti15_10_exit(void) { exti_ack(0xFC00u); }
+
+/* ============================================================================
+ * Initialization
+ * ============================================================================ */
+void emu_gpio_init(void) {
+    static const EMU_RegOps_t GPIO_OPS = { gpio_commit, gpio_present };
+    static const EMU_RegOps_t EXTI_OPS = { exti_commit, exti_present };
+
+    // Reset state: SWD pins on AF with their pulls
+    s_gpio[0].MODER = 0xA8000000u;
+    s_gpio[0].PUPDR = 0x64000000u;
+    s_gpio[0].OSPEEDR = 0x0C000000u;
+    s_gpio[1].MODER = 0x00000280u;
+    s_gpio[1].PUPDR = 0x00000100u;
+    s_gpio[1].OSPEEDR = 0x000000C0u;
+
+    for(uint8_t port = 0; port < PORTS; port++) {
+        s_level[port] = pin_levels(port);
+        s_gpio[port].IDR = s_level[port];
+        emu_bind((EMU_Periph_t)(EMU_GPIOA + port), &s_gpio[port], sizeof(GPIO_TypeDef), &GPIO_OPS);
+    }
+    emu_bind(EMU_SYSCFG, &s_syscfg, sizeof(s_syscfg), 0);
+    emu_bind(EMU_EXTI, &s_exti, sizeof(s_exti), &EXTI_OPS);
+
+    emu_irq_level(EXTI0_IRQn, exti0);           emu_irq_on_exit(EXTI0_IRQn, exti0_exit);
+    emu_irq_level(EXTI1_IRQn, exti1);           emu_irq_on_exit(EXTI1_IRQn, exti1_exit);
+    emu_irq_level(EXTI2_IRQn, exti2);           emu_irq_on_exit(EXTI2_IRQn, exti2_exit);
+    emu_irq_level(EXTI3_IRQn, exti3);           emu_irq_on_exit(EXTI3_IRQn, exti3_exit);
+    emu_irq_level(EXTI4_IRQn, exti4);           emu_irq_on_exit(EXTI4_IRQn, exti4_exit);
+    emu_irq_level(EXTI9_5_IRQn, exti9_5);       emu_irq_on_exit(EXTI9_5_IRQn, exti9_5_exit);
+    emu_irq_level(EXTI15_10_IRQn, exti15_10);   emu_irq_on_exit(EXTI15_10_IRQn, exti15_10_exit);
+}
@@ -0,0 +1,269 @@
+/* ============================================================================
+ * Host Emulator: I2C1 Master Transmitter
+ * Bus timing follows CCR/FS/DUTY at PCLK1: a START or STOP costs one SCL
+ * period, every byte nine. Status flags follow the reference manual event
+ * sequence (EV5 SB, EV6 ADDR, EV8 TXE, EV8_2 BTF) closely enough for both
+ * the polled and the interrupt + DMA driver. The only slave is the SH1106
+ * panel (emu_sh1106.c) at 0x3C; other addresses NACK. emu_i2c_hang() makes
+ * the slave stretch SCL on the next byte until the peripheral is reset, as
+ * a panel stuck mid-byte would.
+ * ============================================================================ */
+
+#include "emu.h"
+#include <string.h>
+
+#define DR_SENTINEL     0xFFFFFFFFu
+#define PANEL_ADDR      0x3C
+
+typedef enum { EV_NONE, EV_START, EV_BYTE, EV_STOP } I2CEvent_t;
+
+/* Global Variables */
+EMU_I2CStats_t emu_i2c_stats = {0};
+
+static I2C_TypeDef s_i2c;
+static uint32_t s_sr1 = 0, s_sr2 = 0;
+static uint8_t s_addr_shown = 0;
+static uint8_t s_start_req = 0, s_stop_req = 0;
+static I2CEvent_t s_event = EV_NONE;
+static emu_time_t s_event_at = EMU_NEVER;
+static emu_time_t s_bus_since = 0;
+
+static uint8_t s_shift_busy = 0;        // a byte is on the wire
+static uint8_t s_shift_byte;
+static uint8_t s_shift_addr = 0;        // it is the address byte
+static uint8_t s_dr_full = 0;
+static uint8_t s_dr;
+static uint8_t s_addressed = 0;         // panel ACKed this transaction
+static uint8_t s_hang = 0;              // 1 = armed, 2 = holding SCL
+
+/* ============================================================================
+ * Bus Timing
+ * ============================================================================ */
+static emu_time_t scl_period(void) {
+    uint32_t ccr = s_i2c.CCR;
+    uint32_t n = ccr & I2C_CCR_CCR;
+    uint32_t mult = !(ccr & I2C_CCR_FS) ? 2 : (ccr & I2C_CCR_DUTY) ? 25 : 3;
+    if(n == 0) emu_fatal("I2C1 clocked with CCR unset");
+    return emu_ps((uint64_t)n * mult, emu_pclk1());
+}
+
+static void schedule(I2CEvent_t ev, uint32_t periods) {
+    s_event = ev;
+    s_event_at = emu_now + periods * scl_period();
+}
+
+static void shift_start(uint8_t b, uint8_t is_addr) {
+    s_shift_busy = 1;
+    s_shift_byte = b;
+    s_shift_addr = is_addr;
+    if(s_hang) {
+        s_hang = 2;                     // the byte never completes
+        return;
+    }
+    schedule(EV_BYTE, 9);
+}
+
+static void bus_start(void) {
+    s_start_req = 0;
+    if(!(s_sr2 & I2C_SR2_BUSY)) s_bus_since = emu_now;
+    schedule(EV_START, 1);
+}
+
+static void bus_stop(void) {
+    s_stop_req = 0;
+    schedule(EV_STOP, 1);
+}
+
+/* ============================================================================
+ * Timed Model
+ * ============================================================================ */
+static emu_time_t i2c_next(void) {
+    return s_event_at;
+}
+
+static void i2c_run(void) {
+    I2CEvent_t ev = s_event;
+    s_event = EV_NONE;
+    s_event_at = EMU_NEVER;
+
+    switch(ev) {
+        case EV_START:
+            emu_i2c_stats.starts++;
+            s_sr1 = (s_sr1 & ~(I2C_SR1_TXE | I2C_SR1_BTF)) | I2C_SR1_SB;
+            s_sr2 |= I2C_SR2_MSL | I2C_SR2_BUSY;
+            s_addressed = 0;
+            s_dr_full = 0;
+            break;
+
+        case EV_BYTE:
+            emu_i2c_stats.bytes++;
+            s_shift_busy = 0;
+            if(s_shift_addr) {
+                if((s_shift_byte >> 1) == PANEL_ADDR && !(s_shift_byte & 1)) {
+                    s_sr1 |= I2C_SR1_ADDR;
+                    s_sr2 |= I2C_SR2_TRA;
+                    s_addressed = 1;
+                    emu_sh1106_begin();
+                } else {
+                    emu_i2c_stats.nacks++;
+                    s_sr1 |= I2C_SR1_AF;
+                }
+            } else {
+                EMU_PanelByte_t kind = emu_sh1106_byte(s_shift_byte);
+                if(kind == EMU_PANEL_CMD) emu_i2c_stats.cmd_bytes++;
+                else if(kind == EMU_PANEL_DATA) emu_i2c_stats.data_bytes++;
+            }
+            if(s_stop_req) {
+                bus_stop();
+            } else if(s_start_req) {
+                bus_start();                    // repeated START
+            } else if(s_dr_full) {
+                s_dr_full = 0;
+                s_sr1 |= I2C_SR1_TXE;
+                shift_start(s_dr, 0);
+            } else if(!s_shift_addr) {
+                s_sr1 |= I2C_SR1_BTF;           // SCL stretched until DR is written
+            }
+            break;
+
+        case EV_STOP:
+            s_i2c.CR1 &= ~I2C_CR1_STOP;
+            s_sr1 &= ~(I2C_SR1_TXE | I2C_SR1_BTF | I2C_SR1_SB | I2C_SR1_ADDR);
+            s_sr2 = 0;
+            s_addressed = 0;
+            emu_i2c_stats.busy += emu_now - s_bus_since;
+            if(s_start_req) bus_start();
+            break;
+
+        default:
+            break;
+    }
+}
+
+/* ============================================================================
+ * Registers
+ * ============================================================================ */
+static void dr_write(uint32_t v) {
+    if(s_sr1 & I2C_SR1_SB) {
+        s_sr1 &= ~I2C_SR1_SB;
+        shift_start((uint8_t)v, 1);
+        return;
+    }
+    if(!s_addressed || (s_sr1 & I2C_SR1_ADDR)) {
+        // Before EV6 completes the byte waits in DR
+        if(s_addressed) { s_dr = (uint8_t)v; s_dr_full = 1; }
+        return;
+    }
+    s_sr1 &= ~I2C_SR1_BTF;
+    if(!s_shift_busy && !s_stop_req) {
+        shift_start((uint8_t)v, 0);
+    } else {
+        s_dr = (uint8_t)v;
+        s_dr_full = 1;
+        s_sr1 &= ~I2C_SR1_TXE;
+    }
+}
+
+static void i2c_reset_state(void) {
+    memset(&s_i2c, 0, sizeof(s_i2c));
+    s_i2c.DR = DR_SENTINEL;
+    s_sr1 = s_sr2 = 0;
+    s_addr_shown = s_start_req = s_stop_req = 0;
+    s_shift_busy = s_dr_full = s_addressed = 0;
+    s_event = EV_NONE;
+    s_event_at = EMU_NEVER;
+    if(s_hang == 2) s_hang = 0;
+}
+
+void emu_i2c_reset(void) {
+    i2c_reset_state();
+}
+
+void emu_i2c_hang(void) {
+    s_hang = 1;
+}
+
+static void i2c_commit(int id, const void* old) {
+    const I2C_TypeDef* was = old;
+    (void)id;
+
+    if(!(s_i2c.CR1 & I2C_CR1_PE) || (s_i2c.CR1 & I2C_CR1_SWRST)) {
+        uint32_t cr1 = s_i2c.CR1, cr2 = s_i2c.CR2, ccr = s_i2c.CCR, trise = s_i2c.TRISE;
+        i2c_reset_state();
+        s_i2c.CR1 = cr1 & ~(I2C_CR1_START | I2C_CR1_STOP);
+        s_i2c.CR2 = cr2;
+        s_i2c.CCR = ccr;
+        s_i2c.TRISE = trise;
+        return;
+    }
+
+    s_sr1 &= ~(was->SR1 & ~s_i2c.SR1 & (I2C_SR1_AF | I2C_SR1_BERR | I2C_SR1_ARLO | I2C_SR1_OVR));
+
+    if((s_i2c.CR1 & I2C_CR1_START) && !(was->CR1 & I2C_CR1_START)) {
+        s_start_req = 1;
+        s_sr1 &= ~I2C_SR1_BTF;
+        if(s_event == EV_NONE && !s_shift_busy && !s_stop_req) bus_start();
+    }
+    if((s_i2c.CR1 & I2C_CR1_STOP) && !(was->CR1 & I2C_CR1_STOP)) {
+        s_stop_req = 1;
+        s_sr1 &= ~I2C_SR1_BTF;
+        if(!s_shift_busy && s_event != EV_START) bus_stop();
+    }
+    if(s_i2c.DR != DR_SENTINEL) dr_write(s_i2c.DR);
+    s_i2c.DR = DR_SENTINEL;
+}
+
+static void i2c_present(int id) {
+    (void)id;
+    // ADDR clears on the access after the SR1 read that showed it (SR2 read)
+    if(s_addr_shown && (s_sr1 & I2C_SR1_ADDR)) {
+        s_sr1 &= ~I2C_SR1_ADDR;
+        s_sr1 |= I2C_SR1_TXE;
+        if(s_dr_full) {
+            s_dr_full = 0;
+            shift_start(s_dr, 0);
+        }
+    }
+    s_addr_shown = (s_sr1 & I2C_SR1_ADDR) != 0;
+
+    uint32_t cr1 = s_i2c.CR1 & ~(I2C_CR1_START | I2C_CR1_STOP);
+    if(s_start_req || s_event == EV_START) cr1 |= I2C_CR1_START;
+    if(s_stop_req || s_event == EV_STOP) cr1 |= I2C_CR1_STOP;
+    s_i2c.CR1 = cr1;
+    s_i2c.SR1 = s_sr1;
+    s_i2c.SR2 = s_sr2;
+    s_i2c.DR = DR_SENTINEL;
+}
+
+static uint8_t i2c_ev_irq(void) {
+    uint32_t cr2 = s_i2c.CR2;
+    if(!(cr2 & I2C_CR2_ITEVTEN)) return 0;
+    if(s_sr1 & (I2C_SR1_SB | I2C_SR1_ADDR | I2C_SR1_BTF | I2C_SR1_STOPF)) return 1;
+    return (cr2 & I2C_CR2_ITBUFEN) && (s_sr1 & (I2C_SR1_TXE | I2C_SR1_RXNE));
+}
+
+static uint8_t i2c_er_irq(void) {
+    return (s_i2c.CR2 & I2C_CR2_ITERREN) &&
+           (s_sr1 & (I2C_SR1_AF | I2C_SR1_BERR | I2C_SR1_ARLO | I2C_SR1_OVR));
+}
+
+static uint8_t i2c_dma_level(void) {
+    return (s_i2c.CR2 & I2C_CR2_DMAEN) && s_addressed && !(s_sr1 & I2C_SR1_ADDR) &&
+           (s_sr1 & I2C_SR1_TXE) && !s_stop_req;
+}
+
+/* ============================================================================
+ * Initialization
+ * ============================================================================ */
+void emu_i2c_init(void) {
+    static const EMU_RegOps_t I2C_OPS = { i2c_commit, i2c_present };
+    static const EMU_Model_t I2C_MODEL = { i2c_next, i2c_run, 0 };
+
+    i2c_reset_state();
+    emu_sh1106_init();
+    emu_bind(EMU_I2C1, &s_i2c, sizeof(s_i2c), &I2C_OPS);
+    emu_add_model(&I2C_MODEL);
+    emu_irq_level(I2C1_EV_IRQn, i2c_ev_irq);
+    emu_irq_level(I2C1_ER_IRQn, i2c_er_irq);
+    emu_dma_source(EMU_DREQ_I2C1_TX, i2c_dma_level, 0, dr_write);
+}
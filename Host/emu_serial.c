@@ -0,0 +1,150 @@
+/* ============================================================================
+ * Host Emulator: USART2
+ * 8N1 frames at PCLK1 / BRR through a one-byte TDR and the shift register.
+ * Each byte is handed to the capture callback when its stop bit ends.
+ * Received bytes arrive one frame apart and land in the RDR.
+ * DR reads back as 0xFFFFFF00 | RDR, which no byte write can match, so any
+ * write is visible on commit. RXNE clears on the access after it was shown.
+ * ============================================================================ */
+
+#include "emu.h"
+
+#define DR_SENTINEL     0xFFFFFF00u
+#define FRAME_BITS      10
+#define RX_QUEUE_LEN    256
+
+static USART_TypeDef s_usart;
+static uint32_t s_sr = USART_SR_TXE | USART_SR_TC;
+static uint8_t s_tdr;
+static uint8_t s_tdr_full = 0;
+static uint8_t s_shift;
+static emu_time_t s_shift_end = EMU_NEVER;      // stop bit of the byte on the wire
+static void (*s_capture)(uint8_t byte) = 0;
+
+static uint8_t s_rdr = 0;
+static uint8_t s_rxne_shown = 0;
+static uint8_t s_rx_queue[RX_QUEUE_LEN];
+static uint16_t s_rx_head = 0;
+static uint16_t s_rx_tail = 0;
+static emu_time_t s_rx_end = EMU_NEVER;         // stop bit of the byte being received
+
+void emu_uart_capture(void (*tx)(uint8_t byte)) {
+    s_capture = tx;
+}
+
+static emu_time_t frame_time(void) {
+    uint32_t brr = s_usart.BRR & 0xFFFFu;
+    if(brr == 0 || emu_pclk1() == 0) emu_fatal("USART2 transmitting with BRR unset");
+    uint32_t div = (s_usart.CR1 & USART_CR1_OVER8) ? ((brr & 0xFFF0u) | ((brr & 7u) << 1)) : brr;
+    return emu_ps((uint64_t)FRAME_BITS * div, emu_pclk1());
+}
+
+static void shift_start(uint8_t byte) {
+    s_shift = byte;
+    s_shift_end = emu_now + frame_time();
+}
+
+static void tx_write(uint32_t v) {
+    if((s_usart.CR1 & (USART_CR1_UE | USART_CR1_TE)) != (USART_CR1_UE | USART_CR1_TE)) return;
+    s_sr &= ~USART_SR_TC;
+    if(s_shift_end == EMU_NEVER) {
+        shift_start((uint8_t)v);
+    } else {
+        s_tdr = (uint8_t)v;
+        s_tdr_full = 1;
+        s_sr &= ~USART_SR_TXE;
+    }
+}
+
+// Queue bytes for the RX line; they follow each other back to back
+void emu_uart_send(const uint8_t* data, uint16_t n) {
+    for(uint16_t i = 0; i < n; i++) {
+        if((uint16_t)(s_rx_head - s_rx_tail) == RX_QUEUE_LEN) emu_fatal("USART2 RX queue full");
+        s_rx_queue[s_rx_head++ % RX_QUEUE_LEN] = data[i];
+    }
+    if(s_rx_end == EMU_NEVER && s_rx_head != s_rx_tail) s_rx_end = emu_now + frame_time();
+}
+
+/* ============================================================================
+ * Timed Model
+ * ============================================================================ */
+static emu_time_t tx_next(void) {
+    return s_shift_end;
+}
+
+static emu_time_t rx_next(void) {
+    return s_rx_end;
+}
+
+static void rx_run(void) {
+    uint8_t byte = s_rx_queue[s_rx_tail++ % RX_QUEUE_LEN];
+    if((s_usart.CR1 & (USART_CR1_UE | USART_CR1_RE)) == (USART_CR1_UE | USART_CR1_RE)) {
+        if(s_sr & USART_SR_RXNE) {
+            s_sr |= USART_SR_ORE;               // RDR not read in time: byte lost
+        } else {
+            s_rdr = byte;
+            s_sr |= USART_SR_RXNE;
+            s_rxne_shown = 0;
+        }
+    }
+    s_rx_end = (s_rx_head != s_rx_tail) ? emu_now + frame_time() : EMU_NEVER;
+}
+
+static void tx_run(void) {
+    if(s_capture) s_capture(s_shift);
+    s_shift_end = EMU_NEVER;
+    if(s_tdr_full) {
+        s_tdr_full = 0;
+        s_sr |= USART_SR_TXE;
+        shift_start(s_tdr);
+    } else {
+        s_sr |= USART_SR_TC;
+    }
+}
+
+/* ============================================================================
+ * Registers
+ * ============================================================================ */
+static void usart_commit(int id, const void* old) {
+    const USART_TypeDef* was = old;
+    (void)id;
+    s_sr &= ~(was->SR & ~s_usart.SR);           // rc_w0
+    if(s_usart.DR != was->DR) tx_write(s_usart.DR);
+}
+
+static void usart_present(int id) {
+    (void)id;
+    // The access after RXNE was seen stands in for the DR read that clears it
+    if(s_rxne_shown) s_sr &= ~(USART_SR_RXNE | USART_SR_ORE);
+    s_rxne_shown = (s_sr & USART_SR_RXNE) != 0;
+    s_usart.SR = s_sr;
+    s_usart.DR = DR_SENTINEL | s_rdr;
+}
+
+static uint8_t usart_irq(void) {
+    uint32_t cr1 = s_usart.CR1;
+    return ((s_sr & USART_SR_TXE) && (cr1 & USART_CR1_TXEIE)) ||
+           ((s_sr & USART_SR_TC) && (cr1 & USART_CR1_TCIE)) ||
+           ((s_sr & (USART_SR_RXNE | USART_SR_ORE)) && (cr1 & USART_CR1_RXNEIE));
+}
+
+static uint8_t usart_dma_level(void) {
+    return (s_usart.CR3 & USART_CR3_DMAT) && (s_sr & USART_SR_TXE);
+}
+
+/* ============================================================================
+ * Initialization
+ * ============================================================================ */
+void emu_serial_init(void) {
+    static const EMU_RegOps_t USART_OPS = { usart_commit, usart_present };
+    static const EMU_Model_t TX_MODEL = { tx_next, tx_run, 0 };
+    static const EMU_Model_t RX_MODEL = { rx_next, rx_run, 0 };
+
+    s_usart.SR = s_sr;
+    s_usart.DR = DR_SENTINEL;
+    emu_bind(EMU_USART2, &s_usart, sizeof(s_usart), &USART_OPS);
+    emu_add_model(&TX_MODEL);
+    emu_add_model(&RX_MODEL);
+    emu_irq_level(USART2_IRQn, usart_irq);
+    emu_dma_source(EMU_DREQ_USART2_TX, usart_dma_level, 0, tx_write);
+}
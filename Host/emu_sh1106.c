@@ -0,0 +1,121 @@
+/* ============================================================================
+ * Host Emulator: SH1106 Panel
+ * 132 x 64 display RAM fed by the I2C byte stream: a control byte after the
+ * address (Co, D/C#), then commands or data. Page addressing only; the
+ * panel shows RAM from column 2. Shared by the I2C1 model and the OLED
+ * benchmark's recording transport.
+ * ============================================================================ */
+
+#include "emu.h"
+#include <string.h>
+
+#define PANEL_COLS      132
+#define PANEL_PAGES     8
+#define PANEL_OFFSET    2           /* first visible RAM column */
+#define PANEL_WIDTH     128
+#define PANEL_HEIGHT    64
+
+static uint8_t s_ram[PANEL_PAGES][PANEL_COLS];
+static uint8_t s_page = 0, s_col = 0;
+static uint8_t s_first_byte = 0;        // next byte is a control byte
+static uint8_t s_ctrl_co = 0, s_ctrl_data = 0;
+static uint8_t s_cmd = 0, s_cmd_args = 0;
+static uint8_t s_on = 0, s_invert = 0, s_all_on = 0;
+
+/* ============================================================================
+ * Command / Data Stream
+ * ============================================================================ */
+static uint8_t cmd_arg_count(uint8_t c) {
+    switch(c) {
+        case 0x81: case 0x8D: case 0xA8: case 0xAD: case 0xD3:
+        case 0xD5: case 0xD9: case 0xDA: case 0xDB: case 0x20:
+            return 1;
+        case 0x21: case 0x22:
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+static void panel_cmd(uint8_t c) {
+    if(s_cmd_args) {
+        s_cmd_args--;                   // arguments only tune analog settings here
+        return;
+    }
+    s_cmd = c;
+    s_cmd_args = cmd_arg_count(c);
+    if(c <= 0x0F)                   s_col = (uint8_t)((s_col & 0xF0) | c);
+    else if(c <= 0x1F)              s_col = (uint8_t)((s_col & 0x0F) | ((c & 0x0F) << 4));
+    else if((c & 0xF8) == 0xB0)     s_page = c & 7;
+    else if(c == 0xAE || c == 0xAF) { s_on = c & 1; emu_trace("OLED display %s", s_on ? "on" : "off"); }
+    else if(c == 0xA6 || c == 0xA7) s_invert = c & 1;
+    else if(c == 0xA4 || c == 0xA5) s_all_on = c & 1;
+}
+
+static void panel_data(uint8_t d) {
+    if(s_col < PANEL_COLS) s_ram[s_page][s_col] = d;
+    s_col++;
+}
+
+void emu_sh1106_init(void) {
+    memset(s_ram, 0xA5, sizeof(s_ram));  // panel RAM is undefined at power-up
+    s_page = s_col = 0;
+    s_first_byte = s_ctrl_co = s_ctrl_data = 0;
+    s_cmd = s_cmd_args = 0;
+    s_on = s_invert = s_all_on = 0;
+}
+
+// Address ACKed: the next byte is a control byte
+void emu_sh1106_begin(void) {
+    s_first_byte = 1;
+}
+
+EMU_PanelByte_t emu_sh1106_byte(uint8_t b) {
+    if(s_first_byte) {
+        s_first_byte = 0;
+        s_ctrl_co = (b >> 7) & 1;
+        s_ctrl_data = (b >> 6) & 1;
+        return EMU_PANEL_CTRL;
+    }
+    EMU_PanelByte_t kind = s_ctrl_data ? EMU_PANEL_DATA : EMU_PANEL_CMD;
+    if(s_ctrl_data) panel_data(b);
+    else panel_cmd(b);
+    if(s_ctrl_co) s_first_byte = 1;     // Co=1: a control byte follows each byte
+    return kind;
+}
+
+/* ============================================================================
+ * Output
+ * ============================================================================ */
+uint8_t emu_oled_on(void) {
+    return s_on;
+}
+
+uint8_t emu_oled_pixel(uint8_t x, uint8_t y) {
+    if(x >= PANEL_WIDTH || y >= PANEL_HEIGHT || !s_on) return 0;
+    uint8_t on = s_all_on || ((s_ram[y / 8][x + PANEL_OFFSET] >> (y % 8)) & 1);
+    return on ^ s_invert;
+}
+
+void emu_oled_write_pbm(FILE* f) {
+    fprintf(f, "P4\n%d %d\n", PANEL_WIDTH, PANEL_HEIGHT);
+    for(uint8_t y = 0; y < PANEL_HEIGHT; y++) {
+        for(uint8_t x = 0; x < PANEL_WIDTH; x += 8) {
+            uint8_t bits = 0;
+            for(uint8_t i = 0; i < 8; i++) bits |= emu_oled_pixel(x + i, y) << (7 - i);
+            fputc(bits, f);
+        }
+    }
+}
+
+// Two pixel rows per line with half blocks
+void emu_oled_write_text(FILE* f) {
+    static const char* const CELL[4] = { " ", "\xE2\x96\x80", "\xE2\x96\x84", "\xE2\x96\x88" };
+    for(uint8_t y = 0; y < PANEL_HEIGHT; y += 2) {
+        fputc('|', f);
+        for(uint8_t x = 0; x < PANEL_WIDTH; x++) {
+            fputs(CELL[emu_oled_pixel(x, y) | (emu_oled_pixel(x, y + 1) << 1)], f);
+        }
+        fputs("|\n", f);
+    }
+}
@@ -0,0 +1,255 @@
+/* ============================================================================
+ * Host Emulator: General-Purpose Timers (TIM2..TIM5)
+ * Up-counting only. The counter is tracked as a count at an anchor time and
+ * derived on every read; update and compare events are scheduled exactly.
+ * PSC always, ARR with ARPE and CCRx with OCxPE load at the update event.
+ * ============================================================================ */
+
+#include "emu.h"
+#include <string.h>
+
+#define TIMERS  4               /* TIM2..TIM5 */
+
+typedef struct {
+    TIM_TypeDef regs;
+    uint32_t sr;                // status flags
+    uint32_t psc;               // active (shadow) values
+    uint32_t arr;
+    uint32_t ccr[4];
+    uint32_t cnt0;              // counter at anchor
+    emu_time_t anchor;
+    uint32_t clk;               // timer clock at anchor
+    uint8_t cc_done;            // compare events already raised this period
+    uint32_t pwm_freq;          // last traced output per channel
+    uint16_t pwm_duty[4];
+} Tim_t;
+
+static Tim_t s_tim[TIMERS];
+
+static const uint32_t WIDTH_MASK[TIMERS] = { 0xFFFFFFFFu, 0xFFFFu, 0xFFFFu, 0xFFFFFFFFu };
+
+/* ============================================================================
+ * Counter Arithmetic
+ * ============================================================================ */
+static uint8_t tim_running(const Tim_t* t) {
+    return (t->regs.CR1 & TIM_CR1_CEN) != 0;
+}
+
+// Time at which the counter has advanced by ticks since the anchor
+static emu_time_t tim_time_at(const Tim_t* t, uint64_t ticks) {
+    return t->anchor + emu_ps(ticks * (t->psc + 1), t->clk);
+}
+
+static uint64_t tim_ticks(const Tim_t* t) {
+    unsigned __int128 ps = emu_now - t->anchor;
+    return (uint64_t)(ps * t->clk / EMU_PS_PER_S / (t->psc + 1));
+}
+
+static uint32_t tim_count_if(const Tim_t* t, uint8_t running) {
+    if(!running) return t->cnt0;
+    return (uint32_t)(t->cnt0 + tim_ticks(t));  // the update event re-anchors first
+}
+
+static uint32_t tim_count(const Tim_t* t) {
+    return tim_count_if(t, tim_running(t));
+}
+
+static void tim_anchor(Tim_t* t, uint32_t cnt) {
+    t->anchor = emu_now;
+    t->clk = emu_timclk1();
+    t->cnt0 = cnt;
+    t->cc_done = 0;
+    for(uint8_t ch = 0; ch < 4; ch++) {
+        if(t->ccr[ch] < cnt) t->cc_done |= 1u << ch;
+    }
+}
+
+static uint32_t tim_oc_mode(const Tim_t* t, uint8_t ch) {
+    uint32_t ccmr = ch < 2 ? t->regs.CCMR1 : t->regs.CCMR2;
+    return (ccmr >> ((ch & 1) ? 12 : 4)) & 7u;
+}
+
+static uint8_t tim_oc_preload(const Tim_t* t, uint8_t ch) {
+    uint32_t ccmr = ch < 2 ? t->regs.CCMR1 : t->regs.CCMR2;
+    return (ccmr >> ((ch & 1) ? 11 : 3)) & 1u;
+}
+
+static uint32_t* tim_ccr_reg(Tim_t* t, uint8_t ch) {
+    return (uint32_t*)&(&t->regs.CCR1)[ch];
+}
+
+/* ============================================================================
+ * PWM Output
+ * ============================================================================ */
+uint16_t emu_tim_pwm(uint8_t tim, uint8_t ch, uint32_t* freq_hz) {
+    if(tim < 2 || tim > 5 || ch < 1 || ch > 4) emu_fatal("no TIM%u CH%u", tim, ch);
+    const Tim_t* t = &s_tim[tim - 2];
+    uint32_t mode = tim_oc_mode(t, ch - 1);
+    uint64_t period = (uint64_t)t->arr + 1;
+
+    if(freq_hz) *freq_hz = 0;
+    if(!tim_running(t) || !(t->regs.CCER & (TIM_CCER_CC1E << ((ch - 1) * 4)))) return 0;
+    if(mode != 6 && mode != 7) return 0;
+    if(freq_hz) *freq_hz = (uint32_t)(emu_timclk1() / ((uint64_t)t->psc + 1) / period);
+
+    uint64_t high = t->ccr[ch - 1] < period ? t->ccr[ch - 1] : period;
+    if(mode == 7) high = period - high;
+    return (uint16_t)(high * 1000 / period);
+}
+
+static void tim_trace_pwm(uint8_t idx) {
+    Tim_t* t = &s_tim[idx];
+    for(uint8_t ch = 0; ch < 4; ch++) {
+        if(!(t->regs.CCER & (TIM_CCER_CC1E << (ch * 4)))) continue;
+        uint32_t freq;
+        uint16_t duty = emu_tim_pwm(idx + 2, ch + 1, &freq);
+        if(duty == t->pwm_duty[ch] && freq == t->pwm_freq) continue;
+        t->pwm_duty[ch] = duty;
+        t->pwm_freq = freq;
+        emu_trace("TIM%u CH%u %lu Hz, %u.%u%%", idx + 2, ch + 1, (unsigned long)freq,
+                  duty / 10, duty % 10);
+    }
+}
+
+/* ============================================================================
+ * Events
+ * ============================================================================ */
+static void tim_update(uint8_t idx, uint8_t from_ug) {
+    Tim_t* t = &s_tim[idx];
+    t->psc = t->regs.PSC & 0xFFFFu;
+    t->arr = t->regs.ARR & WIDTH_MASK[idx];
+    for(uint8_t ch = 0; ch < 4; ch++) {
+        t->ccr[ch] = *tim_ccr_reg(t, ch) & WIDTH_MASK[idx];
+    }
+    tim_anchor(t, 0);
+    if(!(from_ug && (t->regs.CR1 & TIM_CR1_URS))) t->sr |= TIM_SR_UIF;
+
+    // TRGO on update; only TIM2 is wired to an ADC trigger here (EXTSEL 6)
+    if(((t->regs.CR2 & TIM_CR2_MMS) >> TIM_CR2_MMS_Pos) == 2 && idx == 0) emu_adc_trigger(6);
+    if(!from_ug && (t->regs.CR1 & TIM_CR1_OPM)) {
+        t->regs.CR1 &= ~TIM_CR1_CEN;
+    }
+    tim_trace_pwm(idx);
+}
+
+// Earliest pending update or compare event of one timer
+static emu_time_t tim_next_one(const Tim_t* t, uint8_t* what) {
+    if(!tim_running(t) || t->arr == 0) return EMU_NEVER;
+    uint64_t to_update = (uint64_t)t->arr - t->cnt0 + 1;
+    if(t->cnt0 > t->arr) to_update += (uint64_t)WIDTH_MASK[t - s_tim] + 1;  // ARR moved below CNT
+    emu_time_t best = tim_time_at(t, to_update);
+    *what = 4;
+    for(uint8_t ch = 0; ch < 4; ch++) {
+        if((t->cc_done & (1u << ch)) || t->ccr[ch] > t->arr) continue;
+        emu_time_t at = tim_time_at(t, t->ccr[ch] - t->cnt0);
+        if(at < best) { best = at; *what = ch; }
+    }
+    return best;
+}
+
+static emu_time_t tim_next(void) {
+    emu_time_t best = EMU_NEVER;
+    for(uint8_t i = 0; i < TIMERS; i++) {
+        uint8_t what;
+        emu_time_t at = tim_next_one(&s_tim[i], &what);
+        if(at < best) best = at;
+    }
+    return best;
+}
+
+static void tim_run(void) {
+    for(uint8_t i = 0; i < TIMERS; i++) {
+        Tim_t* t = &s_tim[i];
+        uint8_t what;
+        if(tim_next_one(t, &what) != emu_now) continue;
+        if(what == 4) {
+            tim_update(i, 0);
+        } else {
+            t->cc_done |= 1u << what;
+            t->sr |= TIM_SR_CC1IF << what;
+        }
+    }
+}
+
+// Timer clock changed: keep the count, continue at the new rate
+static void tim_rebase(void) {
+    for(uint8_t i = 0; i < TIMERS; i++) {
+        Tim_t* t = &s_tim[i];
+        uint8_t done = t->cc_done;
+        tim_anchor(t, tim_count(t));
+        t->cc_done |= done;
+    }
+}
+
+/* ============================================================================
+ * Registers
+ * ============================================================================ */
+static void tim_commit(int id, const void* old) {
+    uint8_t idx = (uint8_t)(id - EMU_TIM2);
+    Tim_t* t = &s_tim[idx];
+    const TIM_TypeDef* was = old;
+    TIM_TypeDef* r = &t->regs;
+
+    // Settle the count under the old configuration first
+    uint8_t was_on = (was->CR1 & TIM_CR1_CEN) != 0;
+    uint32_t cnt = tim_count_if(t, was_on);
+    if(r->CNT != was->CNT) cnt = r->CNT & WIDTH_MASK[idx];
+    if(r->CNT != was->CNT || was_on != tim_running(t)) tim_anchor(t, cnt);
+
+    // Status is rc_w0: bits shown set and written 0 are cleared
+    t->sr &= ~(was->SR & ~r->SR);
+
+    if(!(r->CR1 & TIM_CR1_ARPE)) t->arr = r->ARR & WIDTH_MASK[idx];
+    for(uint8_t ch = 0; ch < 4; ch++) {
+        if(tim_oc_preload(t, ch) || *tim_ccr_reg(t, ch) == t->ccr[ch]) continue;
+        t->ccr[ch] = *tim_ccr_reg(t, ch) & WIDTH_MASK[idx];
+        if(t->ccr[ch] < tim_count(t)) t->cc_done |= 1u << ch;
+        else t->cc_done &= ~(1u << ch);
+    }
+
+    if(r->EGR & TIM_EGR_UG) tim_update(idx, 1);
+    for(uint8_t ch = 0; ch < 4; ch++) {
+        if(r->EGR & (TIM_SR_CC1IF << ch)) t->sr |= TIM_SR_CC1IF << ch;
+    }
+    r->EGR = 0;
+    tim_trace_pwm(idx);
+}
+
+static void tim_present(int id) {
+    Tim_t* t = &s_tim[id - EMU_TIM2];
+    t->regs.CNT = tim_count(t);
+    t->regs.SR = t->sr;
+    t->regs.EGR = 0;
+}
+
+static uint8_t tim_irq(uint8_t idx) {
+    const Tim_t* t = &s_tim[idx];
+    return (t->sr & t->regs.DIER & 0x1Fu) != 0;
+}
+
+static uint8_t tim2_irq(void) { return tim_irq(0); }
+static uint8_t tim3_irq(void) { return tim_irq(1); }
+static uint8_t tim4_irq(void) { return tim_irq(2); }
+static uint8_t tim5_irq(void) { return tim_irq(3); }
+
+/* ============================================================================
+ * Initialization
+ * ============================================================================ */
+void emu_timers_init(void) {
+    static const EMU_RegOps_t TIM_OPS = { tim_commit, tim_present };
+    static const EMU_Model_t TIM_MODEL = { tim_next, tim_run, tim_rebase };
+
+    for(uint8_t i = 0; i < TIMERS; i++) {
+        Tim_t* t = &s_tim[i];
+        memset(t, 0, sizeof(*t));
+        t->regs.ARR = WIDTH_MASK[i];
+        t->arr = WIDTH_MASK[i];
+        emu_bind((EMU_Periph_t)(EMU_TIM2 + i), &t->regs, sizeof(t->regs), &TIM_OPS);
+    }
+    emu_add_model(&TIM_MODEL);
+
+    emu_irq_level(TIM2_IRQn, tim2_irq);
+    emu_irq_level(TIM3_IRQn, tim3_irq);
+    emu_irq_level(TIM4_IRQn, tim4_irq);
+    emu_irq_level(TIM5_IRQn, tim5_irq);
+}
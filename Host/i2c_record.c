@@ -0,0 +1,90 @@
+/* ============================================================================
+ * Recording I2C1 Transport Implementation
+ * Bus time is counted in SCL periods as the emulator's I2C1 model does: one
+ * for START, nine per byte, one for STOP. Gaps between transfers (interrupt
+ * latency, bus free time) are not included.
+ * ============================================================================ */
+
+#include "i2c_record.h"
+#include "i2c.h"
+#include "emu.h"
+#include <string.h>
+
+#define PANEL_ADDR      0x3C
+
+/* Global Variables */
+I2C_Stats_t g_i2c_stats;
+I2CRecord_t i2c_record;
+FILE* i2c_record_trace = 0;
+
+static void (*s_done_cb)(void) = 0;
+
+void i2c_record_reset(void) {
+    memset(&i2c_record, 0, sizeof(i2c_record));
+}
+
+static void record(uint8_t addr, uint8_t ctrl, const uint8_t* data, uint16_t n) {
+    I2CRecord_t* r = &i2c_record;
+    r->starts++;
+    g_i2c_stats.transfers++;
+    g_i2c_stats.bytes += n + 2;
+
+    if(i2c_record_trace) {
+        fprintf(i2c_record_trace, "i2c 0x%02X ctrl 0x%02X %3u:", addr, ctrl, n);
+        for(uint16_t i = 0; i < n && i < 16; i++) fprintf(i2c_record_trace, " %02X", data[i]);
+        fputs(n > 16 ? " ...\n" : "\n", i2c_record_trace);
+    }
+
+    if(addr != PANEL_ADDR) {
+        // NACK on the address byte: STOP follows at once
+        r->nacks++;
+        g_i2c_stats.errors++;
+        r->bytes++;
+        r->scl_periods += 1 + 9 + 1;
+        return;
+    }
+
+    r->bytes += n + 2;
+    r->scl_periods += 1 + 9 * (uint64_t)(n + 2) + 1;
+    emu_sh1106_begin();
+    emu_sh1106_byte(ctrl);
+    for(uint16_t i = 0; i < n; i++) {
+        EMU_PanelByte_t kind = emu_sh1106_byte(data[i]);
+        if(kind == EMU_PANEL_CMD) r->cmd_bytes++;
+        else if(kind == EMU_PANEL_DATA) r->data_bytes++;
+    }
+    if(s_done_cb) s_done_cb();
+}
+
+/* ============================================================================
+ * i2c.h
+ * ============================================================================ */
+void I2C1_Init(I2C_Speed_t speed) {
+    (void)speed;                // the report covers every bus speed
+}
+
+void I2C1_BusRecover(void) {
+}
+
+void I2C1_Write(uint8_t addr, uint8_t ctrl, const uint8_t* data, uint16_t n) {
+    record(addr, ctrl, data, n);
+}
+
+void I2C1_WriteRef(uint8_t addr, uint8_t ctrl, const uint8_t* data, uint16_t n) {
+    record(addr, ctrl, data, n);
+}
+
+uint8_t I2C1_Idle(void) {
+    return 1;
+}
+
+uint8_t I2C1_Free(void) {
+    return I2C_QUEUE_LEN;
+}
+
+void I2C1_WaitIdle(void) {
+}
+
+void I2C1_SetDoneCallback(void (*cb)(void)) {
+    s_done_cb = cb;
+}
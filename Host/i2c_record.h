@@ -0,0 +1,28 @@
+/* ============================================================================
+ * Recording I2C1 Transport
+ * Host stand-in for Src/i2c.c: the same API, but every transfer completes at
+ * once. Each one is tallied here and decoded into the SH1106 panel model, so
+ * emu_oled_write_pbm() shows what the wire carried.
+ * ============================================================================ */
+
+#ifndef I2C_RECORD_H
+#define I2C_RECORD_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+typedef struct {
+    uint32_t starts;            /* one START per transfer */
+    uint32_t bytes;             /* address + control + payload */
+    uint32_t cmd_bytes;         /* payload after a command control byte */
+    uint32_t data_bytes;        /* payload after a data control byte */
+    uint32_t nacks;             /* transfers to an address other than the panel */
+    uint64_t scl_periods;       /* START + 9 per byte + STOP */
+} I2CRecord_t;
+
+extern I2CRecord_t i2c_record;
+extern FILE* i2c_record_trace;  /* one line per transfer when set */
+
+void i2c_record_reset(void);
+
+#endif /* I2C_RECORD_H */
@@ -0,0 +1,244 @@
+/* ============================================================================
+ * I2C1 Transport Test
+ * Drives the unmodified Src/i2c.c through the emulator's I2C1 model and the
+ * SH1106 panel behind it, and checks what arrives:
+ *   - a full frame from I2C1_Write() (copied, more transfers than the queue
+ *     holds) and I2C1_WriteRef() (in place): the command/data byte split the
+ *     panel decoded and every pixel it now shows
+ *   - a transfer to another address NACKs, counts one error and the next
+ *     transfer still lands
+ *   - a slave that holds SCL mid-byte is given up on after I2C_TIMEOUT_MS;
+ *     the bus is recovered and the next transfer lands
+ *   - 255 or 256 transfers finishing between two looks by the watchdog (the
+ *     8-bit queue tail wraps) don't look like a stalled one
+ * `make check` builds it twice: with the DMA queue and with I2C_USE_DMA 0.
+ * The polled build blocks in every write, so its waits cost nothing.
+ *
+ *   i2c_test [-v]
+ * ============================================================================ */
+
+#include "emu.h"
+#include "i2c.h"
+#include "prof.h"
+#include <string.h>
+
+#define PANEL_ADDR      0x3C
+#define CTRL_CMD        0x00
+#define CTRL_DATA       0x40
+#define PANEL_COL0      2           /* first visible RAM column */
+#define PAGES           8
+#define WIDTH           128
+
+#if I2C_USE_DMA
+#define VARIANT         "dma"
+#else
+#define VARIANT         "polled"
+#endif
+
+static uint32_t s_checks = 0;
+static uint32_t s_failures = 0;
+static uint8_t s_verbose = 0;
+
+#define CHECK(cond, ...) do {                                           \
+        s_checks++;                                                     \
+        if(!(cond)) {                                                   \
+            s_failures++;                                               \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__);                 \
+            printf(__VA_ARGS__);                                        \
+            putchar('\n');                                              \
+        }                                                               \
+    } while(0)
+
+/* ============================================================================
+ * Firmware Stand-ins
+ * Src/i2c.c needs the tick and the APB1 clock; the core stays on the HSI.
+ * With PROF_ENABLE its ISR probes also need the cycle counter and a
+ * Prof_Record(), which drops the samples.
+ * ============================================================================ */
+uint32_t SystemCoreClock = EMU_HSI_HZ;
+static volatile uint32_t s_ticks = 0;
+
+uint32_t GetTick(void) {
+    return s_ticks;
+}
+
+void SysTick_Handler(void) {
+    s_ticks++;
+}
+
+uint32_t SystemClock_GetPCLK1(void) {
+    return emu_pclk1();
+}
+
+#if PROF_ENABLE
+uint32_t Cycle_Now(void) {
+    return DWT->CYCCNT;
+}
+
+void Prof_Record(ProfId_t id, uint32_t cycles) {
+}
+#endif
+
+/* ============================================================================
+ * Helpers
+ * ============================================================================ */
+static uint8_t s_frame[PAGES][WIDTH];
+
+static uint8_t frame_byte(uint8_t page, uint8_t col, uint8_t salt) {
+    return (uint8_t)(page * 37 + col * 5 + salt);
+}
+
+static void set_pos(uint8_t page, uint8_t col) {
+    col += PANEL_COL0;
+    const uint8_t c[3] = { 0xB0 | page, col & 0x0F, 0x10 | (col >> 4) };
+    I2C1_Write(PANEL_ADDR, CTRL_CMD, c, sizeof(c));
+}
+
+// Pixels the panel shows against s_frame; returns the mismatches
+static uint32_t frame_mismatches(void) {
+    uint32_t bad = 0;
+    for(uint8_t y = 0; y < PAGES * 8; y++) {
+        for(uint8_t x = 0; x < WIDTH; x++) {
+            uint8_t want = (s_frame[y / 8][x] >> (y % 8)) & 1;
+            if(emu_oled_pixel(x, y) != want) bad++;
+        }
+    }
+    return bad;
+}
+
+static void wait_ms(uint32_t ms) {
+    uint32_t start = GetTick();
+    while(GetTick() - start < ms) __WFI();
+}
+
+/* ============================================================================
+ * Tests
+ * ============================================================================ */
+// Page 0 in place from a static buffer, pages 1..7 in I2C_INLINE_MAX chunks
+// whose source is overwritten as soon as each call returns
+static void test_frame(void) {
+    static const uint8_t DISPLAY_ON = 0xAF;
+    static uint8_t page0[WIDTH];
+    EMU_I2CStats_t was = emu_i2c_stats;
+
+    I2C1_Write(PANEL_ADDR, CTRL_CMD, &DISPLAY_ON, 1);
+    for(uint8_t col = 0; col < WIDTH; col++) page0[col] = s_frame[0][col] = frame_byte(0, col, 1);
+    set_pos(0, 0);
+    I2C1_WriteRef(PANEL_ADDR, CTRL_DATA, page0, WIDTH);
+
+    uint8_t chunk[I2C_INLINE_MAX];
+    for(uint8_t page = 1; page < PAGES; page++) {
+        set_pos(page, 0);
+        for(uint8_t col = 0; col < WIDTH; col += I2C_INLINE_MAX) {
+            for(uint8_t i = 0; i < I2C_INLINE_MAX; i++) {
+                chunk[i] = s_frame[page][col + i] = frame_byte(page, col + i, 1);
+            }
+            I2C1_Write(PANEL_ADDR, CTRL_DATA, chunk, sizeof(chunk));
+            memset(chunk, 0xFF, sizeof(chunk));
+        }
+    }
+    I2C1_WaitIdle();
+
+    uint32_t transfers = 1 + PAGES + 1 + (PAGES - 1) * (WIDTH / I2C_INLINE_MAX);
+    CHECK(I2C1_Idle(), "queue not drained");
+    CHECK(emu_oled_on(), "display-on command lost");
+    CHECK(emu_i2c_stats.starts - was.starts == transfers, "%u STARTs, expected %u",
+          (unsigned)(emu_i2c_stats.starts - was.starts), (unsigned)transfers);
+    CHECK(emu_i2c_stats.data_bytes - was.data_bytes == PAGES * WIDTH, "%u data bytes decoded",
+          (unsigned)(emu_i2c_stats.data_bytes - was.data_bytes));
+    CHECK(emu_i2c_stats.cmd_bytes - was.cmd_bytes == 1 + 3 * PAGES, "%u command bytes decoded",
+          (unsigned)(emu_i2c_stats.cmd_bytes - was.cmd_bytes));
+    CHECK(g_i2c_stats.errors == 0, "%u errors", (unsigned)g_i2c_stats.errors);
+    uint32_t bad = frame_mismatches();
+    CHECK(bad == 0, "%u pixels differ from the frame sent", (unsigned)bad);
+}
+
+// Rewrite one page-0 chunk and check the panel shows it
+static void check_page0_chunk(uint8_t salt, const char* after) {
+    uint8_t chunk[I2C_INLINE_MAX];
+    for(uint8_t i = 0; i < I2C_INLINE_MAX; i++) chunk[i] = s_frame[0][i] = frame_byte(0, i, salt);
+    set_pos(0, 0);
+    I2C1_Write(PANEL_ADDR, CTRL_DATA, chunk, sizeof(chunk));
+    I2C1_WaitIdle();
+    uint32_t bad = frame_mismatches();
+    CHECK(bad == 0, "%u pixels wrong after %s", (unsigned)bad, after);
+}
+
+static void test_nack(void) {
+    static const uint8_t BYTE = 0x55;
+    uint32_t errors = g_i2c_stats.errors;
+    uint32_t nacks = emu_i2c_stats.nacks;
+
+    I2C1_Write(PANEL_ADDR + 1, CTRL_DATA, &BYTE, 1);
+    I2C1_WaitIdle();
+    CHECK(emu_i2c_stats.nacks - nacks == 1, "%u NACKs", (unsigned)(emu_i2c_stats.nacks - nacks));
+    CHECK(g_i2c_stats.errors - errors == 1, "%u errors counted for one NACK",
+          (unsigned)(g_i2c_stats.errors - errors));
+    check_page0_chunk(2, "a NACK");
+}
+
+static void test_stuck_bus(void) {
+    static const uint8_t BYTES[4] = { 1, 2, 3, 4 };
+    uint32_t errors = g_i2c_stats.errors;
+
+    emu_i2c_hang();
+    uint32_t start = GetTick();
+    I2C1_Write(PANEL_ADDR, CTRL_DATA, BYTES, sizeof(BYTES));
+    I2C1_WaitIdle();
+    uint32_t took = GetTick() - start;
+
+    CHECK(I2C1_Idle(), "stuck transfer still queued");
+    CHECK(g_i2c_stats.errors - errors == 1, "%u errors counted for one stuck transfer",
+          (unsigned)(g_i2c_stats.errors - errors));
+    CHECK(took >= I2C_TIMEOUT_MS && took <= 2 * I2C_TIMEOUT_MS + 2,
+          "gave up after %u ms, timeout is %u ms", (unsigned)took, I2C_TIMEOUT_MS);
+    check_page0_chunk(3, "bus recovery");
+}
+
+// A wait's last watchdog look sees the final transfer either in flight or
+// just finished. 255 or 256 more then finish with no wait loop watching, and
+// a pause longer than the timeout follows: whichever count matches, the next
+// transfer sits at the queue slot last seen and must not be taken for a
+// stalled one. Batches stay below the queue depth so no full-queue wait
+// looks in between.
+static void test_tail_wrap(void) {
+    static const uint8_t NOP = 0xE3;
+    uint32_t errors = g_i2c_stats.errors;
+
+    for(uint16_t gap = 255; gap <= 256; gap++) {
+        I2C1_Write(PANEL_ADDR, CTRL_CMD, &NOP, 1);
+        I2C1_WaitIdle();
+        for(uint16_t left = gap; left; ) {
+            uint8_t batch = left < I2C_QUEUE_LEN - 1 ? left : I2C_QUEUE_LEN - 1;
+            for(uint8_t i = 0; i < batch; i++) I2C1_Write(PANEL_ADDR, CTRL_CMD, &NOP, 1);
+            left -= batch;
+            while(!I2C1_Idle()) __WFI();
+        }
+        wait_ms(2 * I2C_TIMEOUT_MS);
+        I2C1_Write(PANEL_ADDR, CTRL_CMD, &NOP, 1);
+        I2C1_WaitIdle();
+    }
+    CHECK(g_i2c_stats.errors == errors, "%u healthy transfers reported as errors",
+          (unsigned)(g_i2c_stats.errors - errors));
+}
+
+/* ============================================================================
+ * Main
+ * ============================================================================ */
+int main(int argc, char** argv) {
+    if(argc > 1 && strcmp(argv[1], "-v") == 0) s_verbose = 1;
+
+    emu_init();
+    SysTick_Config(SystemCoreClock / 1000);
+    I2C1_Init(I2C_SPEED_FAST);
+
+    test_frame();
+    test_nack();
+    test_stuck_bus();
+    test_tail_wrap();
+
+    if(s_verbose) emu_oled_write_text(stdout);
+    printf("i2c_test (%s): %u checks, %u failed, %.1f ms simulated\n", VARIANT,
+           (unsigned)s_checks, (unsigned)s_failures, (double)emu_now / EMU_PS_PER_MS);
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,231 @@
+/* ============================================================================
+ * OLED Benchmark
+ * Runs representative screens through the unmodified Src/oled.c over the
+ * recording I2C transport and reports, per screen, the transfers, bytes and
+ * wire time at 100 kHz, 400 kHz and 1 MHz. The panel model decodes the
+ * same bytes, and its contents after each screen are written as a PBM so
+ * the numbers can be checked against what was actually drawn.
+ *
+ *   oled_bench [-o dir] [-v]
+ *
+ * Screens run in order, each starting from the panel the previous one left:
+ * boot (oled_init + oled_clear, as in main), OLED_ShowStatus() in every
+ * GameState_t, a level/score increment, the same increment in the other
+ * status layout (OLED_BIG_SCORE flipped), then a full clear. A second table
+ * times oled_text() on the host for a few strings, each render changing
+ * every column it covers, next to the size of the glyph atlas in flash.
+ * ============================================================================ */
+
+#include "emu.h"
+#include "i2c_record.h"
+#include "oled.h"
+#include "game.h"
+#include "prof.h"
+#include "store.h"
+#include "font5x7.h"
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_SCREENS     16
+#define TEXT_RENDERS    100000
+
+typedef struct {
+    char name[24];
+    void (*setup)(int arg);     // drawn first but not counted, may be NULL
+    void (*run)(int arg);
+    int arg;
+} Screen_t;
+
+static const uint32_t SCL_HZ[] = { 100000, 400000, 1000000 };
+static const char* const STATE_NAMES[] = {
+    "boot", "difficulty", "level_intro", "pattern", "input_wait", "result",
+    "victory", "game_death",
+};
+static const char* const TEXT_RUNS[] = {
+    "LEVEL", "SPPED-SELECT", "Score: 1234567", "The quick brown fox jumps!",
+};
+
+/* Game variables OLED_ShowStatus() reads (game.c is not linked) */
+GameState_t g_game_state = GAME_STATE_BOOT;
+uint8_t g_difficulty = 3;
+uint16_t g_level = 1;
+uint32_t g_score = 0;
+uint8_t g_lives = INITIAL_LIVES;
+Stats_t g_reaction_us;                  // empty: the intro shows its label
+
+/* The speed selection shows this table (store.c is not linked) */
+static const StoreScore_t TOP_SCORES[STORE_TOP_N] = { { 1250, 9 }, { 840, 7 }, { 90, 2 } };
+
+const StoreScore_t* Store_TopScores(uint8_t speed) {
+    (void)speed;
+    return TOP_SCORES;
+}
+
+static Screen_t s_screens[MAX_SCREENS];
+static uint8_t s_screen_count = 0;
+static uint8_t s_verbose = 0;
+
+/* The panel model reports display on/off through the emulator trace */
+void emu_trace(const char* fmt, ...) {
+    if(!s_verbose) return;
+    va_list args;
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+    putchar('\n');
+}
+
+#if PROF_ENABLE
+/* oled.c's probe; the bench measures the bus, not cycles (PROF_CYCLES is 0) */
+void Prof_Record(ProfId_t id, uint32_t cycles) {
+    (void)id;
+    (void)cycles;
+}
+#endif
+
+/* ============================================================================
+ * Screens
+ * ============================================================================ */
+static void screen_boot(int arg) {
+    (void)arg;
+    oled_init();
+    oled_clear();
+}
+
+static void screen_status(int state) {
+    g_game_state = (GameState_t)state;
+    OLED_ShowStatus();
+}
+
+// Same scoring as a cleared round in game.c
+static void screen_level_up(int arg) {
+    (void)arg;
+    g_score += 10 * g_level * g_difficulty;
+    g_level++;
+    OLED_ShowStatus();
+}
+
+// Redraw the status in the layout OLED_BIG_SCORE does not select
+static void screen_other_layout(int arg) {
+    (void)arg;
+    OLED_SetBigScore(!OLED_BIG_SCORE);
+    OLED_ShowStatus();
+}
+
+static void screen_clear(int arg) {
+    (void)arg;
+    oled_clear();
+}
+
+static void add_screen(const char* name, void (*setup)(int), void (*run)(int), int arg) {
+    Screen_t* s = &s_screens[s_screen_count++];
+    snprintf(s->name, sizeof(s->name), "%s", name);
+    s->setup = setup;
+    s->run = run;
+    s->arg = arg;
+}
+
+/* ============================================================================
+ * Text Runs
+ * ============================================================================ */
+static double now_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+// Alternate each string with blanks of the same length so every column changes
+static void bench_text(void) {
+    printf("\nfont5x7 atlas: %u glyphs, %u bytes flash\n",
+           (unsigned)(sizeof(FONT5X7) / sizeof(FONT5X7[0])), (unsigned)sizeof(FONT5X7));
+    printf("%-28s %6s %6s %10s\n", "text", "chars", "cols", "host ns");
+
+    for(size_t i = 0; i < sizeof(TEXT_RUNS) / sizeof(TEXT_RUNS[0]); i++) {
+        const char* s = TEXT_RUNS[i];
+        char blank[64];
+        size_t n = strlen(s);
+        memset(blank, ' ', n);
+        blank[n] = 0;
+
+        uint8_t cols = oled_text(0, 7, s);
+        double t0 = now_ns();
+        for(int k = 0; k < TEXT_RENDERS; k++) {
+            oled_text(0, 7, blank);
+            oled_text(0, 7, s);
+        }
+        double ns = (now_ns() - t0) / (2.0 * TEXT_RENDERS);
+        printf("%-28s %6zu %6u %10.1f\n", s, n, cols, ns);
+    }
+    oled_clear();
+}
+
+/* ============================================================================
+ * Main
+ * ============================================================================ */
+static void write_pbm(const char* dir, const char* name) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/oled_%s.pbm", dir, name);
+    FILE* f = fopen(path, "wb");
+    if(!f) {
+        perror(path);
+        exit(1);
+    }
+    emu_oled_write_pbm(f);
+    fclose(f);
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: oled_bench [-o dir] [-v]\n");
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    const char* dir = ".";
+
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-v") == 0) {
+            s_verbose = 1;
+            i2c_record_trace = stdout;
+        } else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            dir = argv[++i];
+        } else {
+            usage();
+        }
+    }
+
+    add_screen("boot", 0, screen_boot, 0);
+    for(int st = GAME_STATE_BOOT; st <= GAME_STATE_GAME_DEATH; st++) {
+        char name[24];
+        snprintf(name, sizeof(name), "status_%s", STATE_NAMES[st]);
+        add_screen(name, 0, screen_status, st);
+    }
+    add_screen("level_up", screen_status, screen_level_up, GAME_STATE_INPUT_WAIT);
+    add_screen("other_layout", 0, screen_other_layout, 0);
+    add_screen("level_up_other", 0, screen_level_up, 0);
+    add_screen("clear", 0, screen_clear, 0);
+
+    emu_sh1106_init();
+    printf("%-20s %6s %6s %6s %6s %10s %10s %10s\n", "screen", "starts", "bytes",
+           "cmd", "data", "100kHz us", "400kHz us", "1MHz us");
+
+    for(uint8_t i = 0; i < s_screen_count; i++) {
+        const Screen_t* s = &s_screens[i];
+        if(s->setup) s->setup(s->arg);
+        if(s_verbose) printf("--- %s\n", s->name);
+        i2c_record_reset();
+        s->run(s->arg);
+
+        const I2CRecord_t* r = &i2c_record;
+        printf("%-20s %6lu %6lu %6lu %6lu", s->name, (unsigned long)r->starts,
+               (unsigned long)r->bytes, (unsigned long)r->cmd_bytes, (unsigned long)r->data_bytes);
+        for(size_t k = 0; k < sizeof(SCL_HZ) / sizeof(SCL_HZ[0]); k++) {
+            printf(" %10.1f", (double)r->scl_periods * 1e6 / SCL_HZ[k]);
+        }
+        putchar('\n');
+        write_pbm(dir, s->name);
+    }
+    bench_text();
+    return 0;
+}
@@ -0,0 +1,277 @@
+/* ============================================================================
+ * Host Simulator
+ * Runs the unmodified firmware (Src/main.c built as firmware_main) on the
+ * peripheral emulator in virtual time. A script drives the buttons and
+ * analog inputs; the log goes to stdout and a summary to stderr at the end.
+ *
+ *   sim [-t ms] [-s script] [-o screen.pbm] [-T trace.txt] [-F flash.bin] [-q]
+ *
+ * Script lines are "<ms> <command> [args]", '#' starts a comment:
+ *   press <0..3>, release <0..3>, tap <0..3> [hold_ms]
+ *   adc <pot|temp|light|channel> <0..4095> [noise]
+ *   uart <text>, uartln <text> (CR LF added), snap <file.pbm>, screen
+ * ============================================================================ */
+
+#include "emu.h"
+#include "config.h"
+#include "ram.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#define MAX_EVENTS      1024
+#define DEFAULT_RUN_MS  10000
+
+typedef enum { CMD_PRESS, CMD_RELEASE, CMD_ADC, CMD_UART, CMD_SNAP, CMD_SCREEN } Cmd_t;
+
+typedef struct {
+    emu_time_t at;
+    Cmd_t cmd;
+    uint8_t arg;
+    uint16_t value;
+    uint16_t noise;
+    uint16_t order;             // script order among equal times
+    char path[96];              // snap file, or uart text
+} Event_t;
+
+/* Button wiring, as in Inc/config.h: BTN0 PA10, BTN1 PB3, BTN2 PB5, BTN3 PB4 */
+static const uint8_t BTN_PORT[4] = { 0, 1, 1, 1 };
+static const uint8_t BTN_PIN[4]  = { BTN0_PIN, BTN1_PIN, BTN2_PIN, BTN3_PIN };
+
+static Event_t s_events[MAX_EVENTS];
+static uint16_t s_event_count = 0;
+static uint16_t s_event_next = 0;
+static const char* s_pbm_path = 0;
+static const char* s_flash_path = 0;    // store sectors, loaded and saved back
+static uint8_t s_quiet = 0;
+static struct timespec s_wall_start;
+
+extern int firmware_main(void);
+
+/* ============================================================================
+ * Script
+ * ============================================================================ */
+static Event_t* add_event(double ms, Cmd_t cmd) {
+    if(s_event_count == MAX_EVENTS) emu_fatal("script has more than %d events", MAX_EVENTS);
+    Event_t* e = &s_events[s_event_count++];
+    memset(e, 0, sizeof(*e));
+    e->at = (emu_time_t)(ms * EMU_PS_PER_MS);
+    e->cmd = cmd;
+    e->order = (uint16_t)(s_event_count - 1);
+    return e;
+}
+
+static uint8_t adc_channel(const char* name) {
+    if(strcasecmp(name, "pot") == 0)   return POT_PIN;
+    if(strcasecmp(name, "temp") == 0)  return TEMP_PIN;
+    if(strcasecmp(name, "light") == 0) return LIGHT_PIN;
+    return (uint8_t)atoi(name);
+}
+
+static uint8_t button_arg(const char* s, const char* path, int line) {
+    int b = s ? atoi(s) : -1;
+    if(b < 0 || b > 3) {
+        fprintf(stderr, "%s:%d: button must be 0..3\n", path, line);
+        exit(2);
+    }
+    return (uint8_t)b;
+}
+
+static void load_script(const char* path) {
+    FILE* f = fopen(path, "r");
+    if(!f) {
+        perror(path);
+        exit(2);
+    }
+
+    char buf[256];
+    int line = 0;
+    while(fgets(buf, sizeof(buf), f)) {
+        line++;
+        char* hash = strchr(buf, '#');
+        if(hash) *hash = 0;
+        char* t = strtok(buf, " \t\r\n");
+        if(!t) continue;
+        double ms = atof(t);
+        char* cmd = strtok(0, " \t\r\n");
+        char* a1 = strtok(0, " \t\r\n");
+        char* a2 = strtok(0, " \t\r\n");
+        char* a3 = strtok(0, " \t\r\n");
+
+        if(!cmd) {
+            fprintf(stderr, "%s:%d: missing command\n", path, line);
+            exit(2);
+        } else if(strcmp(cmd, "press") == 0) {
+            add_event(ms, CMD_PRESS)->arg = button_arg(a1, path, line);
+        } else if(strcmp(cmd, "release") == 0) {
+            add_event(ms, CMD_RELEASE)->arg = button_arg(a1, path, line);
+        } else if(strcmp(cmd, "tap") == 0) {
+            uint8_t b = button_arg(a1, path, line);
+            double hold = a2 ? atof(a2) : 120;
+            add_event(ms, CMD_PRESS)->arg = b;
+            add_event(ms + hold, CMD_RELEASE)->arg = b;
+        } else if(strcmp(cmd, "adc") == 0 && a1 && a2) {
+            Event_t* e = add_event(ms, CMD_ADC);
+            e->arg = adc_channel(a1);
+            e->value = (uint16_t)atoi(a2);
+            e->noise = a3 ? (uint16_t)atoi(a3) : 0;
+        } else if(strcmp(cmd, "uart") == 0 && a1) {
+            snprintf(add_event(ms, CMD_UART)->path, sizeof(s_events[0].path), "%s", a1);
+        } else if(strcmp(cmd, "uartln") == 0 && a1) {
+            snprintf(add_event(ms, CMD_UART)->path, sizeof(s_events[0].path), "%s\r\n", a1);
+        } else if(strcmp(cmd, "snap") == 0 && a1) {
+            snprintf(add_event(ms, CMD_SNAP)->path, sizeof(s_events[0].path), "%s", a1);
+        } else if(strcmp(cmd, "screen") == 0) {
+            add_event(ms, CMD_SCREEN);
+        } else {
+            fprintf(stderr, "%s:%d: bad command '%s'\n", path, line, cmd);
+            exit(2);
+        }
+    }
+    fclose(f);
+}
+
+static int event_cmp(const void* a, const void* b) {
+    const Event_t* x = a;
+    const Event_t* y = b;
+    if(x->at != y->at) return x->at < y->at ? -1 : 1;
+    return (int)x->order - (int)y->order;
+}
+
+static void write_pbm(const char* path) {
+    FILE* f = fopen(path, "wb");
+    if(!f) {
+        perror(path);
+        return;
+    }
+    emu_oled_write_pbm(f);
+    fclose(f);
+}
+
+static emu_time_t script_next(void) {
+    return s_event_next < s_event_count ? s_events[s_event_next].at : EMU_NEVER;
+}
+
+static void script_run(void) {
+    const Event_t* e = &s_events[s_event_next++];
+    switch(e->cmd) {
+        case CMD_PRESS:   emu_button(BTN_PORT[e->arg], BTN_PIN[e->arg], 1); break;
+        case CMD_RELEASE: emu_button(BTN_PORT[e->arg], BTN_PIN[e->arg], 0); break;
+        case CMD_ADC:     emu_adc_set(e->arg, e->value, e->noise); break;
+        case CMD_UART:    emu_uart_send((const uint8_t*)e->path, (uint16_t)strlen(e->path)); break;
+        case CMD_SNAP:    write_pbm(e->path); break;
+        case CMD_SCREEN:
+            printf("--- screen at %.3f ms ---\n", (double)emu_now / EMU_PS_PER_MS);
+            emu_oled_write_text(stdout);
+            break;
+    }
+}
+
+/* ============================================================================
+ * Output
+ * ============================================================================ */
+static void uart_out(uint8_t byte) {
+    if(!s_quiet) fputc(byte, stdout);
+}
+
+static void report(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double wall = (double)(now.tv_sec - s_wall_start.tv_sec) +
+                  (double)(now.tv_nsec - s_wall_start.tv_nsec) / 1e9;
+    double virt = (double)emu_now / EMU_PS_PER_S;
+
+    fflush(stdout);
+    fprintf(stderr, "\n=== %.3f s simulated in %.3f s wall (%.1fx) ===\n",
+            virt, wall, wall > 0 ? virt / wall : 0.0);
+    fprintf(stderr, "core: %llu cycles at %lu Hz, asleep %.1f%%\n",
+            (unsigned long long)emu_cycles, (unsigned long)emu_hclk(),
+            emu_now ? 100.0 * (double)emu_sleep_time / (double)emu_now : 0.0);
+
+    fprintf(stderr, "interrupts:");
+    for(int irq = -1; irq < 96; irq++) {
+        uint32_t n = emu_irq_count((IRQn_Type)irq);
+        if(n) fprintf(stderr, " %s=%lu (%.0f/s)", emu_irq_name((IRQn_Type)irq),
+                      (unsigned long)n, virt > 0 ? n / virt : 0.0);
+    }
+    fputc('\n', stderr);
+
+    const EMU_I2CStats_t* s = &emu_i2c_stats;
+    fprintf(stderr, "i2c: %lu starts, %lu bytes (%lu cmd, %lu data), %lu NACKs, bus busy %.1f%%\n",
+            (unsigned long)s->starts, (unsigned long)s->bytes, (unsigned long)s->cmd_bytes,
+            (unsigned long)s->data_bytes, (unsigned long)s->nacks,
+            emu_now ? 100.0 * (double)s->busy / (double)emu_now : 0.0);
+
+    const EMU_FlashStats_t* fl = &emu_flash_stats;
+    if(fl->words || fl->erases) {
+        fprintf(stderr, "flash: %lu words programmed, %lu sector erases, core stalled %.1f ms\n",
+                (unsigned long)fl->words, (unsigned long)fl->erases,
+                (double)fl->stall / EMU_PS_PER_MS);
+    }
+
+    if(s_pbm_path) write_pbm(s_pbm_path);
+    if(s_flash_path) emu_flash_save(s_flash_path);
+    exit(0);
+}
+
+/* ============================================================================
+ * Firmware Stand-ins
+ * Src/ram.c reads the linker script's section symbols and paints the MSP
+ * stack. The firmware runs on the host thread's stack here and has no
+ * linker map, so that unit isn't built and the RAM report is empty.
+ * ============================================================================ */
+void Ram_Paint(void) {}
+uint32_t Ram_StackPeak(void) { return 0; }
+void Ram_Report(void) {}
+void Ram_Command(uint8_t c) {}
+void Ram_Poll(void) {}
+
+/* ============================================================================
+ * Main
+ * ============================================================================ */
+static void usage(void) {
+    fprintf(stderr, "usage: sim [-t ms] [-s script] [-o screen.pbm] [-T trace.txt] [-F flash.bin] [-q]\n");
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    static const EMU_Model_t SCRIPT_MODEL = { script_next, script_run, 0 };
+    double run_ms = DEFAULT_RUN_MS;
+
+    for(int i = 1; i < argc; i++) {
+        const char* opt = argv[i];
+        if(strcmp(opt, "-q") == 0) { s_quiet = 1; continue; }
+        if(i + 1 >= argc) usage();
+        const char* val = argv[++i];
+        if(strcmp(opt, "-t") == 0) {
+            run_ms = atof(val);
+        } else if(strcmp(opt, "-s") == 0) {
+            load_script(val);
+        } else if(strcmp(opt, "-o") == 0) {
+            s_pbm_path = val;
+        } else if(strcmp(opt, "-F") == 0) {
+            s_flash_path = val;
+        } else if(strcmp(opt, "-T") == 0) {
+            FILE* f = strcmp(val, "-") == 0 ? stderr : fopen(val, "w");
+            if(!f) {
+                perror(val);
+                return 2;
+            }
+            emu_trace_enable(f);
+        } else {
+            usage();
+        }
+    }
+    qsort(s_events, s_event_count, sizeof(Event_t), event_cmp);
+
+    clock_gettime(CLOCK_MONOTONIC, &s_wall_start);
+    emu_init();
+    if(s_flash_path) emu_flash_load(s_flash_path);
+    emu_add_model(&SCRIPT_MODEL);
+    emu_uart_capture(uart_out);
+    emu_set_end((emu_time_t)(run_ms * EMU_PS_PER_MS), report);
+
+    firmware_main();
+    emu_fatal("firmware_main returned");
+}
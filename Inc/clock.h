@@ -0,0 +1,32 @@
+/* ============================================================================
+ * Clock Profiles
+ * The system clock runs from one of a few fixed RCC/flash setups, all from
+ * the 16 MHz HSI. Every peripheral divisor (SysTick, USART2 baud, I2C1
+ * timing, TIM2/3/5 prescalers, ADC clock) is derived from the active
+ * profile, so Clock_SetProfile() can change it at run time: it waits for
+ * the I2C and UART to go quiet, reprograms the clock tree and then has each
+ * driver recompute its settings. Clock_Request() leaves the switch to
+ * Clock_Poll(), which makes it once the I2C queue has drained on its own.
+ * ============================================================================ */
+
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <stdint.h>
+
+typedef enum {
+    CLOCK_100MHZ,           /* PLL, regulator scale 1, 3 WS, ART prefetch and caches */
+    CLOCK_84MHZ,            /* PLL, regulator scale 2, 2 WS, ART prefetch and caches */
+    CLOCK_LOW_POWER,        /* HSI direct, PLL off, 0 WS, caches without prefetch */
+    CLOCK_PROFILE_COUNT
+} ClockProfile_t;
+
+/* Function Prototypes */
+void Clock_Init(void);                      /* CLOCK_PROFILE, before any peripheral */
+void Clock_SetProfile(ClockProfile_t p);    /* main loop only; blocks until I2C is idle */
+void Clock_Request(ClockProfile_t p);       /* switch at the next Clock_Poll() with I2C idle */
+void Clock_Poll(void);                      /* main loop */
+ClockProfile_t Clock_GetProfile(void);
+uint32_t Clock_LastSwitch(void);            /* Cycle_Now() when the last switch completed */
+
+#endif /* CLOCK_H */
@@ -46,8 +46,49 @@
 /* Game Configuration */
 #define BUTTON_DEBOUNCE_MS      50
 #define LONG_PRESS_DURATION_MS  2000
+#define BUTTON_EVENT_QUEUE_LEN  16      /* power of two */
 #define INITIAL_LIVES           4
-#define MAX_PATTERN_LENGTH      32
+#define MAX_PATTERN_LENGTH      1024    /* steps, packed 2 bits each */
+#define VICTORY_LEVEL           9       /* last level before the victory screen */
+#define GAME_ENDLESS            0       /* 1 = each level adds a step, no victory until the sequence is full */
+#define RNG_FIXED_SEED          0       /* nonzero = same patterns every boot, entropy ignored */
+
+/* Clock Profiles (Inc/clock.h): peripheral divisors follow the active one */
+#define CLOCK_PROFILE           CLOCK_100MHZ        /* while a game runs, and at boot */
+#define CLOCK_IDLE_PROFILE      CLOCK_LOW_POWER     /* during the speed selection; CLOCK_PROFILE = no switch, no profiler reset */
+
+/* Driver Configuration */
+#ifndef I2C_USE_DMA                 /* the host tests build both */
+#define I2C_USE_DMA             1   /* 0 = blocking polled I2C transfers */
+#endif
+#define OLED_I2C_SPEED          I2C_SPEED_FAST
+#define OLED_BIG_SCORE          1       /* status layout: 1 = 2x level/lives, 3x score */
+#define IDLE_MAX_SLEEP_MS       50      /* longest sleep; bounds Monitor_Buttons() reconcile latency */
+#define IDLE_REPORT_MS          10000   /* duty-cycle log interval */
+#define SOUND_QUEUE_LEN         4       /* effects waiting behind the one playing, power of two */
+#define LED_BAM_UNIT_US         16      /* shortest bit plane; a frame is 255 units (~245 Hz) */
+
+/* Analog Inputs: TIM2-triggered scan of POT/TEMP/LIGHT into a circular DMA buffer */
+#define ADC_SCAN_RATE_HZ        1000    /* scans per second */
+#define ADC_OVERSAMPLE          4       /* scans averaged per g_adc_values[] update */
+
+/* Log Transmit: USART2 TX ring drained by the TXE interrupt */
+#define LOG_TX_BUFFER_SIZE      1024    /* power of two */
+#define LOG_OVERFLOW_DROP       0       /* drop whole messages that don't fit, count bytes */
+#define LOG_OVERFLOW_BLOCK      1       /* wait for the ISR to make room */
+#define LOG_OVERFLOW_POLICY     LOG_OVERFLOW_DROP
+#define LOG_TOKENIZED           0       /* 1 = binary records, decode with tools/logdecode.py */
+
+/* Persistent Store: log-structured records in flash sectors 6-7 (Inc/store.h) */
+#define STORE_TOP_N             5       /* high scores kept per speed */
+#define STORE_COMPACT_PERCENT   75      /* Store_Maintain() compacts the log past this fill */
+
+/* Input Journal: games recorded to RAM, exported and replayed over USART2 (Inc/journal.h) */
+#define JOURNAL_SIZE            1024    /* bytes per ring, power of two; a game takes ~2 per edge */
+
+/* Cycle Profiler: DWT probes, table dumped when 'p' arrives on USART2 RX */
+#define PROF_ENABLE             0       /* 0 = probes compile to nothing */
+#define PROF_BUCKETS            24      /* log2 histogram, last bucket >= 2^22 cycles (~50 ms) */
 
 /* Type Definitions */
 typedef struct {
@@ -56,6 +97,14 @@ typedef struct {
     uint32_t last_change_time;
 } ButtonState_t;
 
+typedef struct {
+    uint8_t button;         /* 0..3 */
+    uint8_t pressed;        /* 1 = press, 0 = release */
+    uint32_t time;          /* GetTick() at the edge */
+    uint32_t cycles;        /* Cycle_Now() at the edge */
+    uint8_t used;           /* 1 = read by the game, 0 = flushed (a replay repeats it) */
+} ButtonEvent_t;
+
 typedef enum {
     GAME_STATE_BOOT,
     GAME_STATE_DIFFICULTY_SELECT,
@@ -64,7 +113,8 @@ typedef enum {
     GAME_STATE_INPUT_WAIT,
     GAME_STATE_RESULT_PROCESS,
     GAME_STATE_VICTORY,
-    GAME_STATE_GAME_DEATH
+    GAME_STATE_GAME_DEATH,
+    GAME_STATE_COUNT
 } GameState_t;
 
 #endif /* CONFIG_H */
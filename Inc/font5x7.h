@@ -0,0 +1,27 @@
+/* ============================================================================
+ * 5x7 Glyph Atlas
+ * Generated by tools/gen_font.py; edit the art there, not this file.
+ * Printable ASCII, 5 column bytes per glyph (bit 0 = top row); the
+ * spacing column after each glyph is implicit.
+ * ============================================================================ */
+
+#ifndef FONT5X7_H
+#define FONT5X7_H
+
+#include <stdint.h>
+
+#define FONT5X7_FIRST           0x20    /* ' ' */
+#define FONT5X7_LAST            0x7E    /* '~' */
+#define FONT5X7_COLS            5
+#define FONT5X7_PROPORTIONAL    0       /* 1 = FONT5X7_WIDTH[] holds each advance */
+
+extern const uint8_t FONT5X7[95][FONT5X7_COLS];
+#if FONT5X7_PROPORTIONAL
+extern const uint8_t FONT5X7_WIDTH[95];
+#endif
+
+/* Large digits: [digit][page][column], spacing of k columns implicit */
+extern const uint8_t FONT5X7_DIGIT_X2[10][2][10];
+extern const uint8_t FONT5X7_DIGIT_X3[10][3][15];
+
+#endif /* FONT5X7_H */
@@ -8,25 +8,29 @@
 
 #include <stdint.h>
 #include "config.h"
+#include "seq.h"
+#include "stats.h"
 
 /* Global Variables */
 extern GameState_t g_game_state;
 extern uint8_t g_difficulty;
-extern uint8_t g_level;
+extern uint16_t g_level;
 extern uint32_t g_score;
 extern uint8_t g_lives;
 extern uint32_t g_state_entry_time;
+extern uint8_t g_state_step;
 extern uint8_t g_difficulty_locked;
-extern uint8_t g_pattern[MAX_PATTERN_LENGTH];
-extern uint8_t g_pattern_length;
-extern uint8_t g_pattern_index;
-extern uint8_t g_input_index;
+extern Sequence_t g_pattern;
+extern uint16_t g_pattern_index;
+extern uint16_t g_input_index;
 extern uint8_t g_input_correct;
-extern GameState_t g_last_state_logged;
+extern uint32_t g_game_run_max_us;
+extern Stats_t g_reaction_us;          /* press reaction times, this game */
 
 /* Function Prototypes */
 void Game_Init(void);
 void Game_Run(void);
+uint32_t Game_NextDeadline(void);
 
 /* Difficulty Timing Functions */
 uint8_t clamp_u8(uint8_t v, uint8_t lo, uint8_t hi);
@@ -12,25 +12,32 @@
 /* Global Variables */
 extern uint32_t SystemCoreClock;
 extern ButtonState_t g_buttons[4];
+extern uint32_t g_button_events_dropped;
 extern uint16_t g_adc_values[3];
-extern uint8_t g_current_adc_channel;
+extern uint32_t g_adc_irq_count;
+extern uint32_t g_adc_irq_cycles;
 
 /* Function Prototypes */
-void SystemClock_Config(void);
+uint32_t SystemClock_GetPCLK1(void);
+uint32_t SystemClock_GetPCLK2(void);
+uint32_t SystemClock_GetTIMCLK1(void);
 void GPIO_Init(void);
 void ADC_Init(void);
 void USART2_Init(void);
+void USART2_ClockChanged(void);
 void NVIC_Init(void);
 void ADC_StartConversion(void);
+void ADC_ClockChanged(void);
+void ADC_SetBlockCallback(void (*cb)(const uint16_t* scans, uint8_t count));
+
+void Button_Init(void);
+uint8_t Button_GetEvent(ButtonEvent_t* ev);
+uint8_t Button_Pending(void);
+void Button_Flush(void);
+void Button_Replay(uint8_t i, uint8_t level, uint32_t tick, uint8_t used);
 
 void Monitor_Buttons(void);
 void Monitor_ADC(void);
-void LED_SetPattern(uint8_t pattern);
 void SevenSeg_Display(uint8_t digit);
 
-// hardware.h
-void Buzzer_Init(void);
-void Buzzer_Play(uint32_t freq_hz, uint8_t duty_percent);
-void Buzzer_Stop(void);
-
 #endif /* HARDWARE_H */
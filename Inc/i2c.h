@@ -0,0 +1,52 @@
+/* ============================================================================
+ * I2C1 Transport
+ * Queued master-transmit transfers on I2C1 (PB8=SCL, PB9=SDA), drained by
+ * DMA1 Stream 7 / Channel 1 so callers return before the bytes are on the bus
+ * ============================================================================ */
+
+#ifndef I2C_H
+#define I2C_H
+
+#include <stdint.h>
+#include "config.h"
+
+#define I2C_QUEUE_LEN   16  /* transfer descriptors, power of two */
+#define I2C_INLINE_MAX  8   /* bytes I2C1_Write() copies into the descriptor */
+#define I2C_TIMEOUT_MS  25  /* no bus progress for this long = hung bus */
+
+/* SCL Modes: CCR/TRISE are derived from the live APB1 clock */
+typedef enum {
+    I2C_SPEED_STANDARD,     /* 100 kHz */
+    I2C_SPEED_FAST,         /* 400 kHz, Tlow/Thigh = 2 */
+    I2C_SPEED_FAST_DUTY,    /* 400 kHz, Tlow/Thigh = 16/9, exact when APB1 is a multiple of 10 MHz */
+    I2C_SPEED_FAST_PLUS     /* 1 MHz target; beyond the F411 I2C spec, clamped by CCR >= 1 */
+} I2C_Speed_t;
+
+/* Bus Traffic Counters: one START per transfer; bytes include address and
+ * control byte, i.e. everything clocked onto the wire */
+typedef struct {
+    uint32_t transfers;
+    uint32_t bytes;
+    uint32_t errors;        /* NACKs, bus errors and timeouts */
+} I2C_Stats_t;
+
+extern I2C_Stats_t g_i2c_stats;
+
+/* Function Prototypes */
+void I2C1_Init(I2C_Speed_t speed);
+void I2C1_BusRecover(void);
+void I2C1_ClockChanged(void);      /* while I2C1_Idle() */
+
+/* Queue one transfer: START, addr, ctrl, n payload bytes, STOP.
+ * I2C1_Write() copies up to I2C_INLINE_MAX bytes so the caller's buffer may
+ * be reused at once; I2C1_WriteRef() sends straight from the caller's buffer,
+ * which must stay valid until I2C1_Idle() (flash tables, static buffers). */
+void I2C1_Write(uint8_t addr, uint8_t ctrl, const uint8_t* data, uint16_t n);
+void I2C1_WriteRef(uint8_t addr, uint8_t ctrl, const uint8_t* data, uint16_t n);
+
+uint8_t I2C1_Idle(void);
+uint8_t I2C1_Free(void);            /* descriptors a write can take without waiting */
+void I2C1_WaitIdle(void);
+void I2C1_SetDoneCallback(void (*cb)(void));
+
+#endif /* I2C_H */
@@ -0,0 +1,35 @@
+/* ============================================================================
+ * Input Journal
+ * Records each game as its PRNG seed, the locked speed and every button
+ * edge the game took from the queue (read or flushed), timed against the
+ * edge before. Games sit in a RAM ring, the oldest dropped first. A replay
+ * puts a journal back into the button queue at the recorded ticks, in place
+ * of the live buttons, so Game_Run() steps through the same states.
+ *
+ * USART2 RX: 'j' prints every complete game as "J<hex>" lines closed by a
+ * bare "J"; sending such lines back loads that game for replay, and 'g'
+ * loads the last one recorded. A loaded replay starts at the next speed
+ * selection; 'x' drops it, or hands the buttons back during one.
+ * ============================================================================ */
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+#include "config.h"
+
+/* Function Prototypes */
+void Journal_Init(void);
+void Journal_Command(uint8_t c);                /* from USART2_IRQHandler() */
+void Journal_Poll(void);                        /* main loop: commands, replayed edges */
+uint32_t Journal_Deadline(uint32_t wake);       /* wake, or the next replayed edge if sooner */
+
+void Journal_Begin(uint32_t seed, uint8_t speed);   /* speed locked, game starts */
+void Journal_Edge(const ButtonEvent_t* ev);         /* the game took ev off the queue */
+void Journal_End(void);                             /* game over or won */
+
+uint8_t Journal_Replaying(void);                    /* replayed edges stand in for the pins */
+uint8_t Journal_ReplayGame(void);                   /* this game started as a replay */
+uint8_t Journal_ReplayStart(uint32_t* seed, uint8_t* speed);   /* 1 = a loaded replay begins now */
+
+#endif /* JOURNAL_H */
@@ -0,0 +1,28 @@
+/* ============================================================================
+ * LED Brightness
+ * LED1..LED4 at 8-bit brightness by binary code modulation on TIM5: each
+ * frame shows the eight bits of every LED's duty for 1, 2, 4 .. 128 units.
+ * Fades and breathing advance once per frame in the same interrupt. While
+ * every LED is fully on or off the timer is stopped and the pins are static.
+ * ============================================================================ */
+
+#ifndef LED_H
+#define LED_H
+
+#include <stdint.h>
+#include "config.h"
+
+#define LED_COUNT   4
+#define LED_FULL    255
+
+/* Function Prototypes: mask bit n selects LED n+1. Levels are perceptual
+ * (squared to a duty). A cross-fade is two LED_Fade() calls. */
+void LED_Init(void);
+void LED_ClockChanged(void);
+void LED_SetPattern(uint8_t pattern);   /* mask LEDs full on, the rest off */
+void LED_SetLevel(uint8_t mask, uint8_t level);
+void LED_Fade(uint8_t mask, uint8_t level, uint16_t ms);
+void LED_Breathe(uint8_t mask, uint8_t lo, uint8_t hi, uint16_t period_ms);
+uint8_t LED_Busy(void);                 /* a fade is running; breathing never ends */
+
+#endif /* LED_H */
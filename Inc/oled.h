@@ -10,10 +10,27 @@
 
 #define OLED_ADDR       0x3C
 #define OLED_COL_OFFSET 2   /* SH1106 = 2, SSD1306 = 0 */
+#define OLED_WIDTH      128
+#define OLED_PAGES      8   /* 64 rows / 8 rows per page */
 
 /* Function Prototypes */
 void oled_init(void);
 void oled_clear(void);
+void oled_flush(void);                  /* dirty spans that fit the I2C queue; main loop retries */
+void oled_set_contrast(uint8_t level);
+
+/* Draw printable ASCII at column x of a page (8-row text line) into the
+ * framebuffer; returns the column after the run. Shown by oled_flush(). */
+uint8_t oled_text(uint8_t x, uint8_t page, const char* s);
+
+/* Draw v with 2x or 3x digits spanning scale pages from page, one run per
+ * page row; returns the column after the number */
+uint8_t oled_big_uint(uint8_t x, uint8_t page, unsigned v, uint8_t scale);
+
+/* Send a command table in one transaction; cmds must stay valid until the
+ * I2C queue drains, so pass const (flash) tables */
+void oled_cmd_list(const uint8_t* cmds, uint16_t n);
 void OLED_ShowStatus(void);
+void OLED_SetBigScore(uint8_t on);     /* 1 = large LEVEL/LIVES/SCORE layout */
 
 #endif /* OLED_H */
@@ -0,0 +1,22 @@
+/* ============================================================================
+ * Idle / Power Management
+ * Sleeps the core with WFI between main-loop passes, stretching SysTick
+ * across long idle periods, and keeps active/sleep accounting
+ * ============================================================================ */
+
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+
+/* Global Variables */
+extern uint32_t g_idle_sleep_cycles;    /* SysTick clocks spent in WFI */
+
+/* Function Prototypes */
+void Power_Init(void);
+void Power_ClockChanged(void);          /* reprograms SysTick for SystemCoreClock */
+void Power_Idle(uint32_t wake_tick);
+void Power_RequestWake(void);
+void Power_Report(void);
+
+#endif /* POWER_H */
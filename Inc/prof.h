@@ -0,0 +1,74 @@
+/* ============================================================================
+ * Cycle Profiler
+ * Begin/end probes on the DWT cycle counter. Each probe keeps count, min,
+ * max, mean and a log2 histogram in RAM; the table is printed over USART2
+ * when 'p' is received ('r' clears it, and so does a clock profile change,
+ * as cycles only convert to time at one rate). With PROF_ENABLE 0 every macro below
+ * expands to nothing and the module is not linked in.
+ * ============================================================================ */
+
+#ifndef PROF_H
+#define PROF_H
+
+#include <stdint.h>
+#include "config.h"
+
+/* Probe Slots: the state slots follow GameState_t order */
+typedef enum {
+    PROF_STATE,                             /* Game_Run() handler, per state */
+    PROF_OLED_STATUS = PROF_STATE + GAME_STATE_COUNT,
+    PROF_LOG_PRINT,
+    PROF_ISR_SYSTICK,
+    PROF_ISR_EXTI,
+    PROF_ISR_ADC_DMA,
+    PROF_ISR_I2C_EV,
+    PROF_ISR_I2C_ER,
+    PROF_ISR_I2C_DMA,
+    PROF_ISR_USART,
+    PROF_ISR_TIM3,
+    PROF_ISR_TIM5,
+    PROF_COUNT
+} ProfId_t;
+
+/* Cycle source. The host emulator serves DWT->CYCCNT, so Cycle_Now() works
+ * there too; a host harness without DWT defines PROF_CYCLES to its own counter. */
+#ifndef PROF_CYCLES
+#include "utils.h"
+#define PROF_CYCLES()   Cycle_Now()
+#endif
+
+#if PROF_ENABLE
+/* PROF_BEGIN(tag) opens a measurement in the current scope; PROF_END(tag)
+ * records it to slot tag, PROF_END_AS(tag, slot) to a computed slot.
+ * Interrupts taken in between are counted in the enclosing probe. */
+#define PROF_BEGIN(tag)         uint32_t prof_t0_##tag = PROF_CYCLES()
+#define PROF_END(tag)           PROF_END_AS(tag, tag)
+#define PROF_END_AS(tag, slot)  Prof_Record((slot), PROF_CYCLES() - prof_t0_##tag)
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t hist[PROF_BUCKETS];    /* [0] = 0 cycles, [b] = 2^(b-1) .. 2^b - 1 */
+} ProfStat_t;
+
+extern ProfStat_t g_prof[PROF_COUNT];
+
+void Prof_Init(void);
+void Prof_Record(ProfId_t id, uint32_t cycles);
+void Prof_Command(uint8_t c);
+void Prof_Poll(void);
+void Prof_Dump(void);
+void Prof_Reset(void);
+#else
+#define PROF_BEGIN(tag)         ((void)0)
+#define PROF_END(tag)           ((void)0)
+#define PROF_END_AS(tag, slot)  ((void)0)
+#define Prof_Init()             ((void)0)
+#define Prof_Command(c)         ((void)(c))
+#define Prof_Poll()             ((void)0)
+#define Prof_Reset()            ((void)0)
+#endif
+
+#endif /* PROF_H */
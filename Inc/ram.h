@@ -0,0 +1,26 @@
+/* ============================================================================
+ * RAM Budget
+ * Ram_Paint() fills the free RAM between the heap and the stack pointer
+ * with a pattern at boot; the deepest word that no longer holds it is the
+ * stack's high-water mark. Together with the section sizes from the linker
+ * script and the _sbrk() high-water mark (Src/sysmem.c) this gives a RAM
+ * map, printed after boot and again when 'm' arrives on USART2 RX.
+ * ============================================================================ */
+
+#ifndef RAM_H
+#define RAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Function Prototypes */
+void Ram_Paint(void);                   /* main(), after Clock_Init(), before any interrupt */
+uint32_t Ram_StackPeak(void);           /* bytes below _estack the stack has reached */
+void Ram_Report(void);
+void Ram_Command(uint8_t c);            /* from USART2_IRQHandler() */
+void Ram_Poll(void);                    /* main loop: prints a requested report */
+
+/* Src/sysmem.c */
+size_t _sbrk_high_water(void);          /* most heap _sbrk() has handed out, in bytes */
+
+#endif /* RAM_H */
@@ -0,0 +1,25 @@
+/* ============================================================================
+ * Random Numbers
+ * xoshiro128** generator with an entropy pool. The pool keeps absorbing the
+ * low bits of every TEMP/LIGHT ADC scan and the cycle count of every button
+ * edge; Rng_Stir() folds it into the generator. Rng_Seed() restarts the
+ * sequence, so a game seeded the same way draws the same pattern. With
+ * RNG_FIXED_SEED set the pool is ignored and every boot draws the same
+ * sequence.
+ * ============================================================================ */
+
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+#include "config.h"
+
+/* Function Prototypes */
+void Rng_Init(void);
+void Rng_Seed(uint32_t seed);           /* same seed, same draws until the next stir */
+void Rng_AddEntropy(uint32_t x);        /* ISR-safe */
+uint32_t Rng_Stir(void);                /* returns the pool folded in, 0 if fixed */
+uint32_t Rng_Next(void);
+uint8_t Rng_Bits(uint8_t n);            /* n = 1..8 unbiased bits */
+
+#endif /* RNG_H */
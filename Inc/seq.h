@@ -0,0 +1,41 @@
+/* ============================================================================
+ * Packed Step Sequence
+ * Steps of 0..3 stored four to a byte: step i sits in bits 2*(i%4) of byte
+ * i/4, so MAX_PATTERN_LENGTH steps take MAX_PATTERN_LENGTH/4 bytes. Reading
+ * a step and appending one are both O(1).
+ * ============================================================================ */
+
+#ifndef SEQ_H
+#define SEQ_H
+
+#include <stdint.h>
+#include "config.h"
+
+#if MAX_PATTERN_LENGTH > 65535
+#error "MAX_PATTERN_LENGTH must fit the uint16_t length"
+#endif
+
+typedef struct {
+    uint8_t packed[(MAX_PATTERN_LENGTH + 3) / 4];
+    uint16_t length;
+} Sequence_t;
+
+static inline void Seq_Clear(Sequence_t* s) {
+    s->length = 0;
+}
+
+static inline uint8_t Seq_Get(const Sequence_t* s, uint16_t i) {
+    return (s->packed[i >> 2] >> ((i & 3u) * 2)) & 3u;
+}
+
+// Returns 0 when the sequence is full
+static inline uint8_t Seq_Append(Sequence_t* s, uint8_t v) {
+    if(s->length >= MAX_PATTERN_LENGTH) return 0;
+    uint8_t* b = &s->packed[s->length >> 2];
+    uint8_t shift = (uint8_t)((s->length & 3u) * 2);
+    *b = (uint8_t)((*b & ~(3u << shift)) | ((v & 3u) << shift));
+    s->length++;
+    return 1;
+}
+
+#endif /* SEQ_H */
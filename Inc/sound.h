@@ -0,0 +1,37 @@
+/* ============================================================================
+ * Buzzer / Sound Sequencer
+ * PC9 = TIM3_CH4 PWM. Sound_Play() queues a const table of notes that the
+ * TIM3 update interrupt steps through, one PWM period at a time, while the
+ * main loop keeps running
+ * ============================================================================ */
+
+#ifndef SOUND_H
+#define SOUND_H
+
+#include <stdint.h>
+#include "config.h"
+
+typedef struct {
+    uint16_t freq_hz;       /* 0 = rest */
+    uint8_t duty;           /* percent */
+    uint16_t ms;
+} Note_t;
+
+/* An effect: notes play back to back. A higher priority cuts off whatever
+ * is playing and drops the queue; equal or lower waits its turn. */
+typedef struct {
+    const Note_t* notes;
+    uint8_t count;
+    uint8_t priority;
+} Sound_t;
+
+#define SOUND(notes, prio)  { (notes), sizeof(notes) / sizeof((notes)[0]), (prio) }
+
+/* Function Prototypes */
+void Sound_Init(void);
+void Sound_ClockChanged(void);
+uint8_t Sound_Play(const Sound_t* s);   /* 0 = queue full, dropped */
+void Sound_Stop(void);
+uint8_t Sound_Busy(void);
+
+#endif /* SOUND_H */
@@ -0,0 +1,30 @@
+/* ============================================================================
+ * Streaming Statistics
+ * Count, minimum, mean and an estimate of the 95th percentile of a stream
+ * of samples, in constant memory. The percentile uses the P-square method
+ * (Jain & Chlamtac): five markers whose heights move along a piecewise
+ * parabola as samples arrive, so no samples are kept. The first five
+ * samples are exact.
+ * ============================================================================ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint64_t sum;
+    float q[5];                 /* marker heights */
+    int32_t n[5];               /* marker positions, 1-based */
+    float want[5];              /* desired marker positions */
+} Stats_t;
+
+/* Function Prototypes */
+void Stats_Reset(Stats_t* s);
+void Stats_Add(Stats_t* s, uint32_t x);
+uint32_t Stats_Mean(const Stats_t* s);
+uint32_t Stats_P95(const Stats_t* s);      /* 0 before the first sample */
+
+#endif /* STATS_H */
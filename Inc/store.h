@@ -0,0 +1,31 @@
+/* ============================================================================
+ * Persistent Store
+ * Log-structured records in flash sectors 6 and 7 (the STORE region of the
+ * linker script). Writes append a 16-byte CRC-checked record to the active
+ * sector; Store_Init() builds the RAM index in one pass over it. When the
+ * active sector fills up, the live records move to the other one, and the
+ * old sector is erased when Store_Maintain() runs.
+ * ============================================================================ */
+
+#ifndef STORE_H
+#define STORE_H
+
+#include <stdint.h>
+#include "config.h"
+
+#define STORE_SPEEDS    5       /* difficulty 1..5, one high-score table each */
+
+typedef struct {
+    uint32_t score;             /* 0 = empty entry */
+    uint16_t level;             /* level reached */
+} StoreScore_t;
+
+/* Function Prototypes */
+void Store_Init(void);
+void Store_Maintain(void);      /* may erase a sector (~1 s stall): call while idle */
+uint8_t Store_GetSpeed(void);   /* last speed saved, 0 = none */
+void Store_SetSpeed(uint8_t speed);
+uint8_t Store_AddScore(uint8_t speed, uint32_t score, uint16_t level);  /* rank 1..N, 0 = not placed */
+const StoreScore_t* Store_TopScores(uint8_t speed);     /* STORE_TOP_N entries, best first */
+
+#endif /* STORE_H */
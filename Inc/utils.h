@@ -7,14 +7,43 @@
 #define UTILS_H
 
 #include <stdint.h>
+#include "config.h"
+
+/* Logging
+ * LOG() is the call-site macro. In ASCII mode it is Log_Print(). With
+ * LOG_TOKENIZED the format string is placed in the non-loaded .logstr
+ * section, whose offset is the message ID, and only the ID, a tick delta
+ * and the integer arguments go out as a framed record:
+ *   0xA5, len, id_lo, id_hi, varint dt_ms, varint arg..., sum8
+ * Arguments must be integers (no %s / %f). */
+#define LOG_FRAME_SYNC  0xA5
+#define LOG_MAX_ARGS    6
+
+#define LOG_NARGS(...)  LOG_NARGS_(0, ##__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, N, ...) N
+
+#if LOG_TOKENIZED
+#define LOG(fmt, ...) do { \
+        static const char log_fmt_[] __attribute__((section(".logstr"), used)) = fmt; \
+        Log_Token(log_fmt_, LOG_NARGS(__VA_ARGS__), \
+                  (const uint32_t[]){ 0, ##__VA_ARGS__ } + 1); \
+    } while(0)
+#else
+#define LOG(fmt, ...) Log_Print(fmt, ##__VA_ARGS__)
+#endif
 
 /* Global Variables */
 extern volatile uint32_t g_tick_counter;
 extern uint8_t g_system_initialized;
+extern volatile uint32_t g_log_dropped_bytes;
 
 /* Function Prototypes */
 void Delay_ms(uint32_t ms);
 uint32_t GetTick(void);
+void Cycle_Init(void);
+uint32_t Cycle_Now(void);
 void Log_Print(const char* format, ...);
+void Log_Token(const char* fmt, uint8_t nargs, const uint32_t* args);
+void Log_Flush(void);
 
 #endif /* UTILS_H */
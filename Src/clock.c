@@ -0,0 +1,137 @@
+/* ============================================================================
+ * Clock Profiles Implementation
+ * PLL profiles divide the HSI to 1 MHz (PLLM = 16), multiply by PLLN and
+ * halve (PLLP = 2). The regulator scale and PLLCFGR only take effect while
+ * the PLL is stopped, so every switch passes through the HSI: wait states
+ * go up before the clock does and come down after it. Limits are those for
+ * a 2.7-3.6 V supply.
+ * ============================================================================ */
+
+#include "clock.h"
+#include "config.h"
+#include "hardware.h"
+#include "utils.h"
+#include "power.h"
+#include "i2c.h"
+#include "sound.h"
+#include "led.h"
+#include "prof.h"
+
+#define STM32F411xE
+#include "stm32f4xx.h"
+
+#define HSI_HZ          16000000u
+#define ART_ALL         (FLASH_ACR_PRFTEN | FLASH_ACR_ICEN | FLASH_ACR_DCEN)
+
+typedef struct {
+    uint32_t hz;
+    uint16_t plln;          // 0 = PLL off, SYSCLK = HSI
+    uint8_t vos;            // PWR_CR VOS: 3 = scale 1 (100 MHz), 2 = scale 2 (84 MHz)
+    uint32_t ppre1;         // APB1 stays at or below 50 MHz
+    uint32_t latency;
+    uint32_t art;
+} ClockProfileDesc_t;
+
+static const ClockProfileDesc_t PROFILES[CLOCK_PROFILE_COUNT] = {
+    [CLOCK_100MHZ]    = { 100000000u, 200, 3, RCC_CFGR_PPRE1_DIV2, FLASH_ACR_LATENCY_3WS, ART_ALL },
+    [CLOCK_84MHZ]     = {  84000000u, 168, 2, RCC_CFGR_PPRE1_DIV2, FLASH_ACR_LATENCY_2WS, ART_ALL },
+    // Prefetch costs current on every fetch and buys nothing at 0 WS
+    [CLOCK_LOW_POWER] = {     HSI_HZ,   0, 0, RCC_CFGR_PPRE1_DIV1, FLASH_ACR_LATENCY_0WS,
+                          FLASH_ACR_ICEN | FLASH_ACR_DCEN },
+};
+
+static ClockProfile_t s_profile = CLOCK_PROFILE_COUNT;     // none until Clock_Init()
+static ClockProfile_t s_wanted = CLOCK_PROFILE_COUNT;      // Clock_Request(), applied by Clock_Poll()
+static uint32_t s_switched = 0;                             // Cycle_Now() after the last switch
+
+/* ============================================================================
+ * RCC and Flash
+ * ============================================================================ */
+static void clock_program(const ClockProfileDesc_t* c) {
+    RCC->CR |= RCC_CR_HSION;
+    while(!(RCC->CR & RCC_CR_HSIRDY));
+
+    if(c->latency > (FLASH->ACR & FLASH_ACR_LATENCY))
+        FLASH->ACR = (FLASH->ACR & ~FLASH_ACR_LATENCY) | c->latency;
+
+    RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | RCC_CFGR_SW_HSI;
+    while((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_HSI);
+    RCC->CFGR = (RCC->CFGR & ~(RCC_CFGR_HPRE | RCC_CFGR_PPRE1 | RCC_CFGR_PPRE2)) |
+                RCC_CFGR_HPRE_DIV1 | c->ppre1 | RCC_CFGR_PPRE2_DIV1;
+    RCC->CR &= ~RCC_CR_PLLON;
+    while(RCC->CR & RCC_CR_PLLRDY);
+
+    if(c->plln) {
+        RCC->APB1ENR |= RCC_APB1ENR_PWREN;
+        PWR->CR = (PWR->CR & ~PWR_CR_VOS) | ((uint32_t)c->vos << PWR_CR_VOS_Pos);
+        RCC->PLLCFGR = RCC_PLLCFGR_PLLSRC_HSI |
+                       (16 << RCC_PLLCFGR_PLLM_Pos) |
+                       ((uint32_t)c->plln << RCC_PLLCFGR_PLLN_Pos) |
+                       (0 << RCC_PLLCFGR_PLLP_Pos) |             // /2
+                       (4 << RCC_PLLCFGR_PLLQ_Pos);              // reset value, USB unused
+        RCC->CR |= RCC_CR_PLLON;
+        while(!(RCC->CR & RCC_CR_PLLRDY));
+        while(!(PWR->CSR & PWR_CSR_VOSRDY));
+
+        RCC->CFGR |= RCC_CFGR_SW_PLL;
+        while((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_PLL);
+    }
+
+    FLASH->ACR = c->latency | c->art;
+    SystemCoreClock = c->hz;
+}
+
+/* ============================================================================
+ * Public Functions
+ * ============================================================================ */
+void Clock_Init(void) {
+    s_profile = CLOCK_PROFILE;
+    s_wanted = s_profile;
+    clock_program(&PROFILES[s_profile]);
+}
+
+// Game hooks ask here instead of waiting out the OLED queue themselves
+void Clock_Request(ClockProfile_t p) {
+    if(p < CLOCK_PROFILE_COUNT) s_wanted = p;
+}
+
+void Clock_Poll(void) {
+    if(s_wanted != s_profile && I2C1_Idle()) Clock_SetProfile(s_wanted);
+}
+
+void Clock_SetProfile(ClockProfile_t p) {
+    if(p == s_profile || p >= CLOCK_PROFILE_COUNT) return;
+    s_wanted = p;
+    uint32_t was_hz = SystemCoreClock;
+
+    // An I2C transfer or a UART frame must not straddle the change
+    I2C1_WaitIdle();
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    while(!(USART2->SR & USART_SR_TC));
+
+    uint32_t t0 = Cycle_Now();
+    s_profile = p;
+    clock_program(&PROFILES[p]);
+    s_switched = Cycle_Now();
+    Power_ClockChanged();
+    USART2_ClockChanged();
+    ADC_ClockChanged();
+    I2C1_ClockChanged();
+    Sound_ClockChanged();
+    LED_ClockChanged();
+    __set_PRIMASK(primask);
+    Prof_Reset();                       // its cycles were counted at the old rate
+
+    // Cycles counted at both rates; the HSI is the slowest, so this bounds it
+    LOG("[CLOCK] %lu -> %lu MHz in under %lu us\r\n", was_hz / 1000000,
+        SystemCoreClock / 1000000, (Cycle_Now() - t0) / (HSI_HZ / 1000000));
+}
+
+ClockProfile_t Clock_GetProfile(void) {
+    return s_profile;
+}
+
+uint32_t Clock_LastSwitch(void) {
+    return s_switched;
+}
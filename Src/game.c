@@ -7,25 +7,68 @@
 #include "hardware.h"
 #include "utils.h"
 #include "oled.h"
-#include <stdlib.h>
+#include "prof.h"
+#include "sound.h"
+#include "led.h"
+#include "rng.h"
+#include "store.h"
+#include "journal.h"
+#include "clock.h"
 
 /* Global Variables */
 GameState_t g_game_state;
 uint8_t g_difficulty;
-uint8_t g_level;
+uint16_t g_level;
 uint32_t g_score;
 uint8_t g_lives;
 uint32_t g_state_entry_time;
 uint8_t g_difficulty_locked = 0;
 
 const uint8_t button_to_led_map[4] = {0, 1, 2, 3};
-uint8_t g_pattern[MAX_PATTERN_LENGTH] = {0};
-uint8_t g_pattern_length = 0;
-uint8_t g_pattern_index = 0;
-uint8_t g_input_index = 0;
+Sequence_t g_pattern;
+uint16_t g_pattern_index = 0;
+uint16_t g_input_index = 0;
 uint8_t g_input_correct = 1;
 
-GameState_t g_last_state_logged = (GameState_t)-1;
+uint8_t g_state_step = 0;
+uint32_t g_game_run_max_us = 0;
+Stats_t g_reaction_us;              // this game's press reaction times
+
+static uint32_t s_step_time = 0;    // tick the current sub-step started
+static uint32_t s_next_wake = 0;    // earliest tick a pending wait ends
+static uint8_t s_input_polled = 0;  // this pass's handler consumes button events
+static uint8_t s_last_difficulty = 0;
+static uint8_t s_entry_pot_difficulty = 0;  // pot setting when the selection opened
+static uint8_t s_pot_turned = 0;            // the pot overrides the saved speed
+static ButtonEvent_t s_press;               // the press pressed_button() returned
+static uint32_t s_cue_cycles;               // pattern end, then each press
+static uint32_t s_cue_tick;
+
+/* State Descriptors */
+typedef struct {
+    const char* name;               // for the transition log
+    void (*on_enter)(void);
+    void (*on_tick)(void);
+    void (*on_exit)(void);
+} GameStateDesc_t;
+
+static const GameStateDesc_t* s_current = 0;   // entered state, 0 before boot
+static GameState_t s_next_state;                // queued by set_game_state()
+static uint8_t s_state_queued = 0;
+
+/* Sound Effects: the victory tune cuts off the last result beep, the rest queue */
+static const Note_t NOTES_BOOT[]  = { {800, 50, 100} };
+static const Note_t NOTES_RIGHT[] = { {1200, 40, 80} };
+static const Note_t NOTES_WRONG[] = { {300, 40, 150} };
+// 🎵 ทำนองชนะสั้นๆ: C5, E5, G5, 150 ms per note + 50 ms gap
+static const Note_t NOTES_VICTORY[] = {
+    {523, 40, 150}, {0, 0, 50}, {659, 40, 150}, {0, 0, 50}, {784, 40, 150}
+};
+
+static const Sound_t SFX_BOOT    = SOUND(NOTES_BOOT, 1);
+static const Sound_t SFX_RIGHT   = SOUND(NOTES_RIGHT, 1);
+static const Sound_t SFX_WRONG   = SOUND(NOTES_WRONG, 1);
+static const Sound_t SFX_VICTORY = SOUND(NOTES_VICTORY, 2);
 
 /* ============================================================================
  * Difficulty Timing Functions
@@ -49,15 +92,41 @@ uint16_t diff_off_ms(uint8_t diff) {
 /* ============================================================================
  * Internal Helper Functions
  * ============================================================================ */
+// Queue a transition; Game_Run() applies it at the start of its next pass,
+// which it makes at once. The last request of a pass wins.
 static void set_game_state(GameState_t new_state) {
-    g_game_state = new_state;
-    g_state_entry_time = GetTick();
+    s_next_state = new_state;
+    s_state_queued = 1;
+    s_next_wake = GetTick();            // run the new state without sleeping
+}
+
+// Ask the idle loop to come back no later than ms from now
+static void wake_in(uint32_t ms) {
+    uint32_t t = GetTick() + ms;
+    if ((int32_t)(t - s_next_wake) < 0) s_next_wake = t;
+}
+
+// Advance to the next sub-step of the current state and restart its timer
+static void next_step(void) {
+    g_state_step++;
+    s_step_time = GetTick();
+}
+
+// True once the current sub-step has lasted at least ms; until then the
+// remaining time becomes a wakeup deadline for the idle loop
+static uint8_t step_done(uint32_t ms) {
+    uint32_t elapsed = GetTick() - s_step_time;
+    if (elapsed >= ms) return 1;
+    wake_in(ms - elapsed);
+    return 0;
 }
 
-static void generate_pattern(uint8_t length) {
-    for (uint8_t i = 0; i < length; i++)
-        g_pattern[i] = rand() % 4;
-    g_pattern_length = length;
+// Bring the pattern to length steps. Endless play keeps what was shown and
+// appends (a retry replays it); otherwise every round draws a fresh pattern.
+// Draws follow from the game's seed alone, so a journal replays them.
+static void generate_pattern(uint16_t length) {
+    if (!GAME_ENDLESS) Seq_Clear(&g_pattern);
+    while (g_pattern.length < length && Seq_Append(&g_pattern, Rng_Bits(2)));
 }
 
 static void show_led(uint8_t idx) {
@@ -68,41 +137,119 @@ static void clear_leds(void) {
     LED_SetPattern(0);
 }
 
+// Next queued press, skipping releases; one per call so each is handled in turn
+static int8_t pressed_button(void) {
+    s_input_polled = 1;
+    while (Button_GetEvent(&s_press)) {
+        if (s_press.pressed) return s_press.button;
+    }
+    return -1;
+}
+
+// Time from the cue (pattern end or the last press) to this press, from
+// the edge timestamps the EXTI took. The cycle counter wraps after ~43 s
+// at 100 MHz; waits of 40 s or more fall back to the tick.
+static void time_press(void) {
+    uint32_t us;
+    if (s_press.time - s_cue_tick < 40000)
+        us = (s_press.cycles - s_cue_cycles) / (SystemCoreClock / 1000000);
+    else
+        us = (s_press.time - s_cue_tick) * 1000;
+    Stats_Add(&g_reaction_us, us);
+    s_cue_cycles = s_press.cycles;
+    s_cue_tick = s_press.time;
+}
+
+static void log_reaction(void) {
+    LOG("[REACT] %lu presses: min %lu us, mean %lu us, p95 %lu us\r\n",
+        g_reaction_us.count, g_reaction_us.min, Stats_Mean(&g_reaction_us),
+        Stats_P95(&g_reaction_us));
+}
+
 /* ============================================================================
- * State Handler Functions
+ * State Hooks
+ * on_enter runs once when a state is entered, on_exit once when it is left,
+ * on_tick on every Game_Run() pass in between. Ticks return at once; waits
+ * are sub-steps (g_state_step) that complete once step_done() says their
+ * time has passed.
  * ============================================================================ */
-static void handle_boot(void) {
+static void enter_boot(void) {
+    Sound_Play(&SFX_BOOT);
+    set_game_state(GAME_STATE_DIFFICULTY_SELECT);
+}
+
+static uint8_t pot_difficulty(void) {
+    return (uint32_t)(g_adc_values[0] * 5) / 1024 + 1;  // 1..5
+}
+
+// Finished game into the high-score table; a replay only closes its journal
+static void save_score(void) {
+    uint8_t replay = Journal_ReplayGame();
+    Journal_End();
+    if (replay) return;
+    uint8_t rank = Store_AddScore(g_difficulty, g_score, g_level);
+    if (rank) LOG("[STORE] High score #%u at speed %u: %lu\r\n", rank, g_difficulty, g_score);
+}
+
+// Every game, the first one included, starts here. The last speed played
+// is offered until the pot is turned.
+static void enter_difficulty_select(void) {
     g_level = 1;
     g_score = 0;
+    Seq_Clear(&g_pattern);
     g_lives = INITIAL_LIVES;
-    set_game_state(GAME_STATE_DIFFICULTY_SELECT);
-    Buzzer_Play(800, 50);
-    Delay_ms(100);
-    Buzzer_Stop();
+    Stats_Reset(&g_reaction_us);
+    g_difficulty_locked = 0;
+    s_last_difficulty = 0;              // log the pot on the first tick
+    s_entry_pot_difficulty = pot_difficulty();
+    s_pot_turned = !Store_GetSpeed();
+    Clock_Request(CLOCK_IDLE_PROFILE);  // nothing here needs speed
+    Store_Maintain();                   // flash erase stalls are harmless here
 }
 
-static void handle_difficulty_select(void) {
+// One seed per game, drawn when the speed locks and kept in the journal
+static void lock_speed(uint32_t seed) {
+    Clock_Request(CLOCK_PROFILE);       // in place long before the first cue
+    g_difficulty_locked = 1;
+    Rng_Seed(seed);
+    Journal_Begin(seed, g_difficulty);
+    set_game_state(GAME_STATE_LEVEL_INTRO);
+}
+
+static void tick_difficulty_select(void) {
     uint32_t current_time = GetTick();
     static uint32_t last_log_time = 0;
-    static uint8_t last_difficulty = 0;
+    uint32_t seed;
+
+    // Only the held level counts here (long press); discard the edges
+    Button_Flush();
+
+    if (!g_difficulty_locked && Journal_ReplayStart(&seed, &g_difficulty)) {
+        SevenSeg_Display(g_difficulty);
+        lock_speed(seed);
+        return;
+    }
 
     if (!g_difficulty_locked) {
         uint16_t pot_value = g_adc_values[0];
-        g_difficulty = (uint32_t)(pot_value * 5) / 1024 + 1;  // 1..5
+        uint8_t pot_diff = pot_difficulty();
+        if (pot_diff != s_entry_pot_difficulty) s_pot_turned = 1;
+        g_difficulty = s_pot_turned ? pot_diff : Store_GetSpeed();
         SevenSeg_Display(g_difficulty);
 
-        if (g_difficulty != last_difficulty || (current_time - last_log_time) > 1000) {
-            Log_Print("[CURRENT SPEED] Pot:%u -> Diff:%u\r\n", pot_value, g_difficulty);
+        if (g_difficulty != s_last_difficulty || (current_time - last_log_time) > 1000) {
+            LOG("[CURRENT SPEED] Pot:%u -> Diff:%u\r\n", pot_value, g_difficulty);
             last_log_time = current_time;
-            last_difficulty = g_difficulty;
+            s_last_difficulty = g_difficulty;
             OLED_ShowStatus();
         }
 
         for (int i = 0; i < 4; i++) {
             if (g_buttons[i].current_state == 1 &&
                (current_time - g_buttons[i].last_change_time) >= LONG_PRESS_DURATION_MS) {
-                g_difficulty_locked = 1;
-                set_game_state(GAME_STATE_LEVEL_INTRO);
+                Store_SetSpeed(g_difficulty);
+                Rng_Stir();             // no-op with RNG_FIXED_SEED
+                lock_speed(Rng_Next());
                 return;
             }
         }
@@ -111,162 +258,207 @@ static void handle_difficulty_select(void) {
     }
 }
 
-static void handle_level_intro(void) {
-    Log_Print("Level %u. Lives: %u. Score: %lu\r\n", g_level, g_lives, g_score);
-    OLED_ShowStatus();
-    Delay_ms(800);
+static void enter_level_intro(void) {
+    LOG("Level %u. Lives: %u. Score: %lu\r\n", g_level, g_lives, g_score);
+}
 
-    // Back-and-forth LED animation only for first level
-    if (g_level == 1) {
-        // Forward: LED0 -> LED1 -> LED2 -> LED3
-        for (int i = 0; i < 4; i++) {
-            show_led(i);
-            Delay_ms(150);
-        }
-        // Backward: LED3 -> LED2 -> LED1 -> LED0
-        for (int i = 2; i >= 0; i--) {
-            show_led(i);
-            Delay_ms(150);
+static void tick_level_intro(void) {
+    // Back-and-forth sweep LED0 -> LED3 -> LED0, first level only
+    static const uint8_t SWEEP[] = {0, 1, 2, 3, 2, 1, 0};
+    const uint8_t sweep_first = 1;
+    const uint8_t sweep_end = sweep_first + sizeof(SWEEP);
+
+    if (g_state_step == 0) {
+        if (!step_done(800)) return;
+        if (g_level != 1) {
+            set_game_state(GAME_STATE_PATTERN_DISPLAY);
+            return;
         }
-        clear_leds();
-        Delay_ms(200);
+        show_led(SWEEP[0]);
+        next_step();
+    } else if (g_state_step < sweep_end) {
+        if (!step_done(150)) return;
+        uint8_t k = g_state_step - sweep_first + 1;
+        if (k < sizeof(SWEEP)) show_led(SWEEP[k]);
+        else clear_leds();
+        next_step();
+    } else if (step_done(200)) {
+        set_game_state(GAME_STATE_PATTERN_DISPLAY);
     }
+}
 
+static void enter_pattern_display(void) {
     generate_pattern(g_level);
     g_pattern_index = 0;
-    set_game_state(GAME_STATE_PATTERN_DISPLAY);
 }
 
-static void handle_pattern_display(void) {
-    uint16_t t_on  = diff_on_ms(g_difficulty);
-    uint16_t t_off = diff_off_ms(g_difficulty);
+static void tick_pattern_display(void) {
+    switch (g_state_step) {
+        case 0:     // next LED on, or hand over to the player
+            if (g_pattern_index < g_pattern.length) {
+                show_led(Seq_Get(&g_pattern, g_pattern_index));
+                next_step();
+            } else {
+                s_cue_cycles = Cycle_Now();     // reaction times count from here
+                s_cue_tick = GetTick();
+                set_game_state(GAME_STATE_INPUT_WAIT);
+            }
+            break;
+        case 1:     // LED on time
+            if (step_done(diff_on_ms(g_difficulty))) {
+                clear_leds();
+                next_step();
+            }
+            break;
+        default:    // gap before the next LED
+            if (step_done(diff_off_ms(g_difficulty))) {
+                g_pattern_index++;
+                g_state_step = 0;
+            }
+            break;
+    }
+}
 
-    if (g_pattern_index < g_pattern_length) {
-        show_led(g_pattern[g_pattern_index]);
-        Delay_ms(t_on);
+static void enter_input_wait(void) {
+    g_pattern_index = 0;
+    g_input_index = 0;
+    g_input_correct = 1;
+}
+
+static void tick_input_wait(void) {
+    // Step 1 = LED echo of the last press is lit
+    if (g_state_step == 1 && step_done(diff_on_ms(g_difficulty) / 2)) {
         clear_leds();
-        Delay_ms(t_off);
-        g_pattern_index++;
-    } else {
-        g_pattern_index = 0;
-        g_input_index = 0;
-        g_input_correct = 1;
-        set_game_state(GAME_STATE_INPUT_WAIT);
+        g_state_step = 0;
     }
-}
 
-static void handle_input_wait(void) {
-    if (g_input_index < g_pattern_length) {
-        for (int i = 0; i < 4; i++) {
-            if (g_buttons[i].current_state == 1 && g_buttons[i].previous_state == 0) {
-                show_led(i);
-                Delay_ms(diff_on_ms(g_difficulty) / 2);
-                clear_leds();
-                if (i != g_pattern[g_input_index]) {
-                    g_input_correct = 0;
-                }
-                g_input_index++;
-                break;
+    if (g_input_index < g_pattern.length) {
+        int8_t i = pressed_button();
+        if (i >= 0) {
+            time_press();
+            show_led(i);
+            g_state_step = 0;
+            next_step();
+            if (i != Seq_Get(&g_pattern, g_input_index)) {
+                g_input_correct = 0;
             }
+            g_input_index++;
         }
-    } else {
+    } else if (g_state_step == 0) {
         set_game_state(GAME_STATE_RESULT_PROCESS);
     }
 }
 
-static void handle_result_process(void) {
+// Scores the round and moves on; the transition redraws the status, which
+// shows the reaction times during the next level intro
+static void enter_result_process(void) {
+    log_reaction();
     if (g_input_correct) {
-        Buzzer_Play(1200, 40);
-        Delay_ms(80);
-        Buzzer_Stop();
+        Sound_Play(&SFX_RIGHT);
         g_score += 10 * g_level * g_difficulty;
         g_level++;
-        OLED_ShowStatus();
-        if (g_level > 9)
+        if (g_level > (GAME_ENDLESS ? MAX_PATTERN_LENGTH : VICTORY_LEVEL))
             set_game_state(GAME_STATE_VICTORY);
         else
             set_game_state(GAME_STATE_LEVEL_INTRO);
     } else {
-        Buzzer_Play(300, 40);
-        Delay_ms(150);
-        Buzzer_Stop();
+        Sound_Play(&SFX_WRONG);
         if (g_lives > 0) g_lives--;
-        OLED_ShowStatus();
         if (g_lives == 0)
             set_game_state(GAME_STATE_GAME_DEATH);
         else {
-            Log_Print("Try again!\r\n");
+            LOG("Try again!\r\n");
             set_game_state(GAME_STATE_LEVEL_INTRO);
         }
     }
 }
 
-static void handle_victory(void) {
-    Log_Print("Congratulations! Final Score: %lu\r\n", g_score);
-    OLED_ShowStatus();
-
-    // 🎵 เล่นทำนองชนะสั้นๆ
-    uint32_t melody[] = {523, 659, 784}; // C5, E5, G5
-    for (int i = 0; i < 3; i++) {
-        Buzzer_Play(melody[i], 40);   // ความดัง 40%
-        Delay_ms(150);                // โน้ตละ 150 ms
-        Buzzer_Stop();
-        Delay_ms(50);                 // เว้นจังหวะนิดหน่อย
-    }
+static void enter_victory(void) {
+    LOG("Congratulations! Final Score: %lu\r\n", g_score);
+    save_score();
+    Sound_Play(&SFX_VICTORY);
+}
 
-    for (int i = 0; i < 4; i++) {
-        if (g_buttons[i].current_state == 1 && g_buttons[i].previous_state == 0) {
-            g_level = 1;
-            g_score = 0;
-            g_lives = INITIAL_LIVES;
-            g_difficulty_locked = 0;
-            set_game_state(GAME_STATE_DIFFICULTY_SELECT);
-            break;
-        }
+static void tick_victory(void) {
+    if (g_state_step == 0) {
+        if (Sound_Busy()) return;       // the sequencer wakes us when it ends
+        Button_Flush();                 // only presses after the tune restart
+        LED_Breathe(0x0F, 0, LED_FULL, 2000);
+        next_step();
+    } else if (pressed_button() >= 0) {
+        // Wait for button press to restart
+        set_game_state(GAME_STATE_DIFFICULTY_SELECT);
     }
 }
 
-static void handle_game_death(void) {
-    static uint8_t animation_played = 0;
-
-    // Play game over animation once upon entering this state
-    if (!animation_played) {
-        Log_Print("Game Over! Final Score: %lu\r\n", g_score);
-
-        // Rapid blink: 3 cycles
-        for (int cycle = 0; cycle < 3; cycle++) {
-            LED_SetPattern(0x0F);  // All LEDs on
-            Delay_ms(150);
-            LED_SetPattern(0x00);  // All LEDs off
-            Delay_ms(150);
-        }
-
-        // Gradual fade out simulation
-        for (int brightness = 10; brightness > 0; brightness--) {
-            for (int pulse = 0; pulse < 20; pulse++) {
-                LED_SetPattern(0x0F);
-                Delay_ms(brightness);
-                LED_SetPattern(0x00);
-                Delay_ms(11 - brightness);
-            }
-        }
+static void enter_game_death(void) {
+    LOG("Game Over! Final Score: %lu\r\n", g_score);
+    save_score();
+    LED_SetPattern(0x0F);
+}
 
-        LED_SetPattern(0x00);  // Ensure all off
+static void tick_game_death(void) {
+    const uint8_t blink_steps = 6;      // 3 on/off cycles, 150 ms each half
+    const uint16_t fade_ms = 2200;
+
+    if (g_state_step < blink_steps) {
+        // Rapid blink
+        if (!step_done(150)) return;
+        LED_SetPattern((g_state_step & 1) ? 0x0F : 0x00);
+        next_step();
+    } else if (g_state_step == blink_steps) {
+        // Gradual fade out, run by the LED timer
+        LED_Fade(0x0F, 0, fade_ms);
+        next_step();
+    } else if (g_state_step == blink_steps + 1) {
+        if (LED_Busy()) return;         // the LED driver wakes us when it ends
         OLED_ShowStatus();
-        animation_played = 1;
+        Button_Flush();                 // only presses after the fade restart
+        next_step();
+    } else if (pressed_button() >= 0) {
+        // Wait for button press to restart
+        set_game_state(GAME_STATE_DIFFICULTY_SELECT);
     }
+}
 
-    // Wait for button press to restart
-    for (int i = 0; i < 4; i++) {
-        if (g_buttons[i].current_state == 1 && g_buttons[i].previous_state == 0) {
-            g_level = 1;
-            g_score = 0;
-            g_lives = INITIAL_LIVES;
-            g_difficulty_locked = 0;
-            animation_played = 0;  // Reset for next game over
-            set_game_state(GAME_STATE_DIFFICULTY_SELECT);
-            break;
-        }
+/* State Table: indexed by GameState_t, a null hook does nothing */
+static const GameStateDesc_t STATES[GAME_STATE_COUNT] = {
+    [GAME_STATE_BOOT]              = { "BOOT",              enter_boot,              0,                      0 },
+    [GAME_STATE_DIFFICULTY_SELECT] = { "DIFFICULTY_SELECT", enter_difficulty_select, tick_difficulty_select, 0 },
+    [GAME_STATE_LEVEL_INTRO]       = { "LEVEL_INTRO",       enter_level_intro,       tick_level_intro,       0 },
+    [GAME_STATE_PATTERN_DISPLAY]   = { "PATTERN_DISPLAY",   enter_pattern_display,   tick_pattern_display,   clear_leds },
+    [GAME_STATE_INPUT_WAIT]        = { "INPUT_WAIT",        enter_input_wait,        tick_input_wait,        clear_leds },
+    [GAME_STATE_RESULT_PROCESS]    = { "RESULT_PROCESS",    enter_result_process,    0,                      0 },
+    [GAME_STATE_VICTORY]           = { "VICTORY",           enter_victory,           tick_victory,           clear_leds },
+    [GAME_STATE_GAME_DEATH]        = { "GAME_DEATH",        enter_game_death,        tick_game_death,        clear_leds },
+};
+
+// Leave the current state and enter the queued one
+static void apply_transition(void) {
+    static uint32_t reported_max_us = 0;
+    GameState_t next = s_next_state;
+    s_state_queued = 0;
+    if (next >= GAME_STATE_COUNT) next = GAME_STATE_DIFFICULTY_SELECT;
+
+    if (s_current && s_current->on_exit) s_current->on_exit();
+    s_current = &STATES[next];
+    g_game_state = next;
+    g_state_entry_time = GetTick();
+    g_state_step = 0;
+    s_step_time = g_state_entry_time;
+    Button_Flush();                     // presses belong to the state they were made in
+
+#if LOG_TOKENIZED
+    LOG("[STATE] -> %u\r\n", next);     // records carry integers only
+#else
+    LOG("[STATE] -> %s\r\n", s_current->name);
+#endif
+    if (s_current->on_enter) s_current->on_enter();
+    OLED_ShowStatus();
+
+    if (g_game_run_max_us != reported_max_us) {
+        reported_max_us = g_game_run_max_us;
+        LOG("[PERF] Game_Run worst case: %lu us\r\n", reported_max_us);
     }
 }
 
@@ -274,75 +466,44 @@ static void handle_game_death(void) {
  * Public Functions
  * ============================================================================ */
 void Game_Init(void) {
-    Log_Print("\r\n[GAME] Initializing Simon Game...\r\n");
-    uint32_t seed = g_adc_values[1] + g_adc_values[2] + GetTick();
-    srand(seed);
-    Log_Print("[GAME] Random seed set to: %lu\r\n", seed);
+    LOG("\r\n[GAME] Initializing Simon Game...\r\n");
+#if RNG_FIXED_SEED
+    LOG("[GAME] Fixed random seed: %lu\r\n", (uint32_t)RNG_FIXED_SEED);
+#else
+    LOG("[GAME] Random pool: %lu\r\n", Rng_Stir());
+#endif
     set_game_state(GAME_STATE_BOOT);
 }
 
 void Game_Run(void) {
-    // Log state transitions
-    if (g_last_state_logged != g_game_state) {
-        switch(g_game_state) {
-            case GAME_STATE_BOOT:
-                Log_Print("[STATE] -> BOOT\r\n");
-                break;
-            case GAME_STATE_DIFFICULTY_SELECT:
-                Log_Print("[STATE] -> DIFFICULTY_SELECT\r\n");
-                break;
-            case GAME_STATE_LEVEL_INTRO:
-                Log_Print("[STATE] -> LEVEL_INTRO\r\n");
-                break;
-            case GAME_STATE_PATTERN_DISPLAY:
-                Log_Print("[STATE] -> PATTERN_DISPLAY\r\n");
-                break;
-            case GAME_STATE_INPUT_WAIT:
-                Log_Print("[STATE] -> INPUT_WAIT\r\n");
-                break;
-            case GAME_STATE_RESULT_PROCESS:
-                Log_Print("[STATE] -> RESULT_PROCESS\r\n");
-                break;
-            case GAME_STATE_VICTORY:
-                Log_Print("[STATE] -> VICTORY\r\n");
-                break;
-            case GAME_STATE_GAME_DEATH:
-                Log_Print("[STATE] -> GAME_DEATH\r\n");
-                break;
-        }
-        g_last_state_logged = g_game_state;
-        OLED_ShowStatus();
+    uint32_t t0 = Cycle_Now();
+    uint32_t mhz0 = SystemCoreClock / 1000000;
+    s_next_wake = GetTick() + IDLE_MAX_SLEEP_MS;
+    s_input_polled = 0;
+
+    // At most one transition per pass; hooks that ask for another queue it
+    if (s_state_queued) apply_transition();
+
+    // Execute current state handler; g_game_state holds until the next pass
+    PROF_BEGIN(PROF_STATE);
+    if (s_current->on_tick) s_current->on_tick();
+    PROF_END_AS(PROF_STATE, PROF_STATE + g_game_state);
+
+    // Cycles convert at the rate they were counted; a hook may have switched it
+    uint32_t now = Cycle_Now();
+    uint32_t mhz = SystemCoreClock / 1000000;
+    uint32_t us;
+    if (mhz == mhz0) {
+        us = (now - t0) / mhz;
+    } else {
+        uint32_t at = Clock_LastSwitch();
+        us = (at - t0) / mhz0 + (now - at) / mhz;
     }
+    if (us > g_game_run_max_us) g_game_run_max_us = us;
+}
 
-    // Execute current state handler
-    switch(g_game_state) {
-        case GAME_STATE_BOOT:
-            handle_boot();
-            break;
-        case GAME_STATE_DIFFICULTY_SELECT:
-            handle_difficulty_select();
-            break;
-        case GAME_STATE_LEVEL_INTRO:
-            handle_level_intro();
-            break;
-        case GAME_STATE_PATTERN_DISPLAY:
-            handle_pattern_display();
-            break;
-        case GAME_STATE_INPUT_WAIT:
-            handle_input_wait();
-            break;
-        case GAME_STATE_RESULT_PROCESS:
-            handle_result_process();
-            break;
-        case GAME_STATE_VICTORY:
-            handle_victory();
-            break;
-        case GAME_STATE_GAME_DEATH:
-            handle_game_death();
-            break;
-        default:
-            set_game_state(GAME_STATE_DIFFICULTY_SELECT);
-            Delay_ms(1000);
-            break;
-    }
+// Tick by which Game_Run() next has work to do
+uint32_t Game_NextDeadline(void) {
+    if (s_input_polled && Button_Pending()) return GetTick();
+    return s_next_wake;
 }
@@ -4,40 +4,62 @@
 
 #include "hardware.h"
 #include "utils.h"
+#include "power.h"
+#include "prof.h"
+#include "rng.h"
+#include "journal.h"
 
 #define STM32F411xE
 #include "stm32f4xx.h"
 
-#define BUZZER_PORT GPIOC
-#define BUZZER_PIN  9
+#define ADC_CHANNELS    3   /* scan order = g_adc_values[] index: POT, TEMP, LIGHT */
+#define ADC_DMA_LEN     (2 * ADC_OVERSAMPLE * ADC_CHANNELS)
+
+#define USART2_BAUD     115200
+#define ADCCLK_MAX_HZ   36000000u   /* 2.4-3.6 V */
 
 /* Global Variables */
-uint32_t SystemCoreClock = 84000000;
+uint32_t SystemCoreClock = 16000000;    // HSI until Clock_Init()
 ButtonState_t g_buttons[4];
+uint32_t g_button_events_dropped = 0;
 uint16_t g_adc_values[3] = {0};
-uint8_t g_current_adc_channel = 0;
+uint32_t g_adc_irq_count = 0;
+uint32_t g_adc_irq_cycles = 0;
+
+// Two halves of ADC_OVERSAMPLE scans each; DMA fills one while the other is averaged
+static uint16_t s_adc_dma[ADC_DMA_LEN];
+static void (*s_adc_block_cb)(const uint16_t* scans, uint8_t count);
+
+// Button edges, pushed by the EXTI ISRs and by Monitor_Buttons()
+static ButtonEvent_t s_btn_queue[BUTTON_EVENT_QUEUE_LEN];
+static volatile uint8_t s_btn_head = 0;
+static volatile uint8_t s_btn_tail = 0;
 
 /* ============================================================================
  * System Initialization
+ * The clock tree itself is set by Clock_Init()/Clock_SetProfile() (clock.c)
  * ============================================================================ */
-void SystemClock_Config(void) {
-    RCC->CR |= RCC_CR_HSION;
-    while(!(RCC->CR & RCC_CR_HSIRDY));
+static const uint8_t APB_SHIFT[8] = {0,0,0,0,1,2,3,4};
 
-    RCC->PLLCFGR = (RCC_PLLCFGR_PLLSRC_HSI) |
-                   (16 << RCC_PLLCFGR_PLLM_Pos) |
-                   (168 << RCC_PLLCFGR_PLLN_Pos) |
-                   (0 << RCC_PLLCFGR_PLLP_Pos);
+// AHB clock as currently programmed in RCC->CFGR
+static uint32_t hclk(void) {
+    static const uint8_t AHB_SHIFT[16] = {0,0,0,0,0,0,0,0,1,2,3,4,6,7,8,9};
+    return SystemCoreClock >> AHB_SHIFT[(RCC->CFGR & RCC_CFGR_HPRE) >> RCC_CFGR_HPRE_Pos];
+}
 
-    RCC->CR |= RCC_CR_PLLON;
-    while(!(RCC->CR & RCC_CR_PLLRDY));
+// APB1 and APB2 clocks, from the same register
+uint32_t SystemClock_GetPCLK1(void) {
+    return hclk() >> APB_SHIFT[(RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos];
+}
 
-    FLASH->ACR = FLASH_ACR_LATENCY_2WS;
-    RCC->CFGR |= RCC_CFGR_HPRE_DIV1 | RCC_CFGR_PPRE1_DIV2 | RCC_CFGR_PPRE2_DIV1;
-    RCC->CFGR |= RCC_CFGR_SW_PLL;
-    while((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_PLL);
+uint32_t SystemClock_GetPCLK2(void) {
+    return hclk() >> APB_SHIFT[(RCC->CFGR & RCC_CFGR_PPRE2) >> RCC_CFGR_PPRE2_Pos];
+}
 
-    SystemCoreClock = 84000000;
+// APB1 timer clock: twice PCLK1 whenever the APB1 prescaler is not 1
+uint32_t SystemClock_GetTIMCLK1(void) {
+    uint32_t ppre1 = (RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos;
+    return (ppre1 >= 4) ? 2 * SystemClock_GetPCLK1() : SystemClock_GetPCLK1();
 }
 
 void GPIO_Init(void) {
@@ -65,75 +87,267 @@ void GPIO_Init(void) {
     GPIOB->MODER = (GPIOB->MODER & ~(3U << (BCD_2_2_PIN*2))) | (1U << (BCD_2_2_PIN*2));
 }
 
+// (Re)arm DMA2 Stream 0 / Channel 0 over the whole circular buffer
+static void adc_dma_start(void) {
+    DMA2_Stream0->CR &= ~DMA_SxCR_EN;
+    while(DMA2_Stream0->CR & DMA_SxCR_EN);
+    DMA2->LIFCR = DMA_LIFCR_CFEIF0 | DMA_LIFCR_CDMEIF0 | DMA_LIFCR_CTEIF0 |
+                  DMA_LIFCR_CHTIF0 | DMA_LIFCR_CTCIF0;
+
+    DMA2_Stream0->PAR  = (uintptr_t)&ADC1->DR;
+    DMA2_Stream0->M0AR = (uintptr_t)s_adc_dma;
+    DMA2_Stream0->NDTR = ADC_DMA_LEN;
+    DMA2_Stream0->CR = (0 << DMA_SxCR_CHSEL_Pos) |        // ADC1
+                       DMA_SxCR_MSIZE_0 | DMA_SxCR_PSIZE_0 | // 16-bit both sides
+                       DMA_SxCR_MINC | DMA_SxCR_CIRC |
+                       DMA_SxCR_HTIE | DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+    DMA2_Stream0->CR |= DMA_SxCR_EN;
+
+    // Toggling DMA restarts the ADC's request sequence after an overrun
+    ADC1->SR &= ~ADC_SR_OVR;
+    ADC1->CR2 &= ~ADC_CR2_DMA;
+    ADC1->CR2 |= ADC_CR2_DMA;
+}
+
 void ADC_Init(void) {
     RCC->APB2ENR |= RCC_APB2ENR_ADC1EN;
-    ADC1->CR2 |= ADC_CR2_ADON;
-    ADC1->CR1 |= ADC_CR1_EOCIE;
-    ADC1->CR1 |= (1 << ADC_CR1_RES_Pos); // 10-bit resolution
+    RCC->AHB1ENR |= RCC_AHB1ENR_DMA2EN;
+    RCC->APB1ENR |= RCC_APB1ENR_TIM2EN;
+
+    // Scan POT -> TEMP -> LIGHT once per TIM2 TRGO rising edge, results via DMA
+    ADC1->CR1 = (1 << ADC_CR1_RES_Pos) | ADC_CR1_SCAN;   // 10-bit resolution
     ADC1->SMPR2 |= (7 << ADC_SMPR2_SMP0_Pos) |
                    (7 << ADC_SMPR2_SMP1_Pos) |
                    (7 << ADC_SMPR2_SMP4_Pos);
+    ADC1->SQR1 = ((ADC_CHANNELS - 1) << ADC_SQR1_L_Pos);
+    ADC1->SQR3 = (POT_PIN   << ADC_SQR3_SQ1_Pos) |
+                 (TEMP_PIN  << ADC_SQR3_SQ2_Pos) |
+                 (LIGHT_PIN << ADC_SQR3_SQ3_Pos);
+    ADC1->CR2 = (1 << ADC_CR2_EXTEN_Pos) |      // rising edge
+                (6 << ADC_CR2_EXTSEL_Pos) |     // TIM2 TRGO
+                ADC_CR2_DDS | ADC_CR2_ADON;
+
+    // TIM2 at 1 MHz, update event every scan period drives TRGO
+    TIM2->CR1 = 0;
+    ADC_ClockChanged();
+    TIM2->ARR = 1000000 / ADC_SCAN_RATE_HZ - 1;
+    TIM2->CR2 = (TIM2->CR2 & ~TIM_CR2_MMS) | TIM_CR2_MMS_1;   // TRGO = update
+    TIM2->EGR = TIM_EGR_UG;
+
+    adc_dma_start();
     Delay_ms(2);
 }
 
+// ADCCLK = PCLK2 / 2, 4, 6 or 8, the fastest within spec; TIM2 keeps 1 MHz
+void ADC_ClockChanged(void) {
+    uint32_t pclk2 = SystemClock_GetPCLK2();
+    uint32_t pre = 0;
+    while(pre < 3 && pclk2 / (2 * (pre + 1)) > ADCCLK_MAX_HZ) pre++;
+    ADC123_COMMON->CCR = (ADC123_COMMON->CCR & ~ADC_CCR_ADCPRE) | (pre << ADC_CCR_ADCPRE_Pos);
+    TIM2->PSC = SystemClock_GetTIMCLK1() / 1000000 - 1;
+}
+
 void USART2_Init(void) {
     RCC->APB1ENR |= RCC_APB1ENR_USART2EN;
-    USART2->BRR = 0x16C; // 115200 @ 42MHz
+    USART2_ClockChanged();
     USART2->CR1 |= USART_CR1_TE | USART_CR1_RE | USART_CR1_UE;
 }
 
+// 16x oversampling: BRR = PCLK1 / baud, rounded to the nearest step
+void USART2_ClockChanged(void) {
+    USART2->BRR = (SystemClock_GetPCLK1() + USART2_BAUD / 2) / USART2_BAUD;
+}
+
 void NVIC_Init(void) {
-    NVIC_EnableIRQ(ADC_IRQn);
-    NVIC_SetPriority(ADC_IRQn, 1);
+    NVIC_SetPriority(DMA2_Stream0_IRQn, 1);
+    NVIC_EnableIRQ(DMA2_Stream0_IRQn);
+    NVIC_SetPriority(EXTI15_10_IRQn, 1);     // BTN0
+    NVIC_SetPriority(EXTI3_IRQn, 1);         // BTN1
+    NVIC_SetPriority(EXTI9_5_IRQn, 1);       // BTN2
+    NVIC_SetPriority(EXTI4_IRQn, 1);         // BTN3
+    NVIC_EnableIRQ(EXTI15_10_IRQn);
+    NVIC_EnableIRQ(EXTI3_IRQn);
+    NVIC_EnableIRQ(EXTI9_5_IRQn);
+    NVIC_EnableIRQ(EXTI4_IRQn);
+    NVIC_SetPriority(TIM5_IRQn, 1);          // LED bit planes, short ones are 16 us
+    NVIC_EnableIRQ(TIM5_IRQn);
+    NVIC_SetPriority(TIM3_IRQn, 2);          // buzzer sequencer, once per PWM period
+    NVIC_EnableIRQ(TIM3_IRQn);
     NVIC_SetPriority(SysTick_IRQn, 0);
+    NVIC_SetPriority(USART2_IRQn, 3);
+    NVIC_EnableIRQ(USART2_IRQn);
 }
 
 void ADC_StartConversion(void) {
-    ADC1->SQR3 = (ADC1->SQR3 & ~ADC_SQR3_SQ1) | POT_PIN;
-    ADC1->CR2 |= ADC_CR2_SWSTART;
+    TIM2->CR1 |= TIM_CR1_CEN;
+}
+
+// Called from the DMA ISR with ADC_OVERSAMPLE raw scans (ADC_CHANNELS samples
+// each) after g_adc_values[] has been updated from them
+void ADC_SetBlockCallback(void (*cb)(const uint16_t* scans, uint8_t count)) {
+    s_adc_block_cb = cb;
+}
+
+/* ============================================================================
+ * Button Events
+ * Both edges of BTN0..BTN3 raise EXTI interrupts. The first edge of a change
+ * is accepted at once and further edges are ignored for BUTTON_DEBOUNCE_MS;
+ * Monitor_Buttons() catches any final level the lockout hid. During a
+ * journal replay the pins are ignored and Button_Replay() queues the edges,
+ * each marked with whether the recorded game read it or flushed it; reads
+ * and flushes repeat those marks rather than the replay's own timing.
+ * ============================================================================ */
+static uint8_t button_level(uint8_t i) {
+    switch(i) {
+        case 0:  return !(BTN0_PORT->IDR & (1 << BTN0_PIN));
+        case 1:  return !(BTN1_PORT->IDR & (1 << BTN1_PIN));
+        case 2:  return !(BTN2_PORT->IDR & (1 << BTN2_PIN));
+        default: return !(BTN3_PORT->IDR & (1 << BTN3_PIN));
+    }
+}
+
+// Record a debounced change and queue its event; call with IRQs masked or from the EXTI ISR
+static void button_change(uint8_t i, uint8_t level, uint32_t now, uint8_t used) {
+    ButtonState_t* b = &g_buttons[i];
+    b->previous_state = b->current_state;
+    b->current_state = level;
+    b->last_change_time = now;
+
+    uint8_t next = (s_btn_head + 1) & (BUTTON_EVENT_QUEUE_LEN - 1);
+    if(next == s_btn_tail) {
+        g_button_events_dropped++;
+        return;
+    }
+    uint32_t cycles = Cycle_Now();
+    Rng_AddEntropy(cycles);             // edge timing jitter
+    s_btn_queue[s_btn_head] = (ButtonEvent_t){ i, level, now, cycles, used };
+    s_btn_head = next;
+    Power_RequestWake();
+}
+
+static void button_exti(void) {
+    static const uint8_t LINE[4] = { BTN0_PIN, BTN1_PIN, BTN2_PIN, BTN3_PIN };
+    PROF_BEGIN(PROF_ISR_EXTI);
+    uint32_t pending = EXTI->PR;
+    uint32_t now = GetTick();
+
+    for(uint8_t i = 0; i < 4; i++) {
+        if(!(pending & (1u << LINE[i]))) continue;
+        EXTI->PR = 1u << LINE[i];
+        if(Journal_Replaying()) continue;
+
+        uint8_t level = button_level(i);
+        if(level == g_buttons[i].current_state) continue;           // bounced back
+        if(now - g_buttons[i].last_change_time < BUTTON_DEBOUNCE_MS) continue;
+        button_change(i, level, now, 1);
+    }
+    PROF_END(PROF_ISR_EXTI);
+}
+
+void Button_Init(void) {
+    RCC->APB2ENR |= RCC_APB2ENR_SYSCFGEN;
+
+    SYSCFG->EXTICR[2] = (SYSCFG->EXTICR[2] & ~(0xFu << SYSCFG_EXTICR3_EXTI10_Pos)) |
+                        (0u << SYSCFG_EXTICR3_EXTI10_Pos);             // PA10
+    SYSCFG->EXTICR[0] = (SYSCFG->EXTICR[0] & ~(0xFu << SYSCFG_EXTICR1_EXTI3_Pos)) |
+                        (1u << SYSCFG_EXTICR1_EXTI3_Pos);              // PB3
+    SYSCFG->EXTICR[1] = (SYSCFG->EXTICR[1] & ~((0xFu << SYSCFG_EXTICR2_EXTI4_Pos) |
+                                               (0xFu << SYSCFG_EXTICR2_EXTI5_Pos))) |
+                        (1u << SYSCFG_EXTICR2_EXTI4_Pos) |             // PB4
+                        (1u << SYSCFG_EXTICR2_EXTI5_Pos);              // PB5
+
+    uint32_t lines = (1u << BTN0_PIN) | (1u << BTN1_PIN) | (1u << BTN2_PIN) | (1u << BTN3_PIN);
+    for(uint8_t i = 0; i < 4; i++) g_buttons[i].current_state = button_level(i);
+    EXTI->PR = lines;
+    EXTI->RTSR |= lines;
+    EXTI->FTSR |= lines;
+    EXTI->IMR |= lines;
+}
+
+static void button_pop(ButtonEvent_t* ev, uint8_t used) {
+    *ev = s_btn_queue[s_btn_tail];
+    s_btn_tail = (s_btn_tail + 1) & (BUTTON_EVENT_QUEUE_LEN - 1);
+    ev->used = used;
+    Journal_Edge(ev);
+}
+
+// Pop the oldest button event; 0 when the queue is empty. Every event the
+// game takes, read or flushed, goes into the journal. A replayed edge the
+// recorded game flushed is flushed here too, unseen.
+uint8_t Button_GetEvent(ButtonEvent_t* ev) {
+    while(s_btn_tail != s_btn_head) {
+        uint8_t used = s_btn_queue[s_btn_tail].used;
+        button_pop(ev, used);
+        if(used) return 1;
+    }
+    return 0;
+}
+
+uint8_t Button_Pending(void) {
+    return s_btn_tail != s_btn_head;
+}
+
+// A replayed edge the recorded game read stays queued for the next read
+void Button_Flush(void) {
+    ButtonEvent_t ev;
+    while(s_btn_tail != s_btn_head &&
+          !(Journal_Replaying() && s_btn_queue[s_btn_tail].used)) {
+        button_pop(&ev, 0);
+    }
+}
+
+// A journaled edge, queued as though the EXTI had seen it at tick
+void Button_Replay(uint8_t i, uint8_t level, uint32_t tick, uint8_t used) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    button_change(i, level, tick, used);
+    __set_PRIMASK(primask);
 }
 
 /* ============================================================================
  * Hardware Monitoring
  * ============================================================================ */
+// Reconcile: once a button's lockout has expired, a level that differs from
+// the debounced state is a change whose edge was ignored; emit it now
 void Monitor_Buttons(void) {
-    uint32_t current_time = GetTick();
-    uint8_t readings[4] = {
-        !(BTN0_PORT->IDR & (1 << BTN0_PIN)),
-        !(BTN1_PORT->IDR & (1 << BTN1_PIN)),
-        !(BTN2_PORT->IDR & (1 << BTN2_PIN)),
-        !(BTN3_PORT->IDR & (1 << BTN3_PIN))
-    };
-
-    for(int i = 0; i < 4; i++) {
-        g_buttons[i].previous_state = g_buttons[i].current_state;
-        g_buttons[i].current_state = readings[i];
-        if(g_buttons[i].current_state != g_buttons[i].previous_state) {
-            if((current_time - g_buttons[i].last_change_time) >= BUTTON_DEBOUNCE_MS) {
-                g_buttons[i].last_change_time = current_time;
-            }
+    if(Journal_Replaying()) return;
+    for(uint8_t i = 0; i < 4; i++) {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        uint32_t now = GetTick();
+        uint8_t level = button_level(i);
+        if(level != g_buttons[i].current_state &&
+           now - g_buttons[i].last_change_time >= BUTTON_DEBOUNCE_MS) {
+            button_change(i, level, now, 1);
         }
+        __set_PRIMASK(primask);
     }
 }
 
 void Monitor_ADC(void) {
-    /* ADC handled via interrupt */
+    static uint32_t last_report = 0, last_count = 0, last_cycles = 0;
+
+    // An overrun or DMA error stops the transfer; re-arm and carry on
+    if((ADC1->SR & ADC_SR_OVR) || !(DMA2_Stream0->CR & DMA_SxCR_EN)) {
+        adc_dma_start();
+        LOG("[ADC] DMA restarted after overrun\r\n");
+    }
+
+    uint32_t now = GetTick();
+    if(now - last_report >= IDLE_REPORT_MS) {
+        uint32_t secs = (now - last_report) / 1000;
+        LOG("[ADC] %lu IRQ/s, %lu cycles/s in ISR\r\n",
+            (g_adc_irq_count - last_count) / secs,
+            (g_adc_irq_cycles - last_cycles) / secs);
+        last_report = now;
+        last_count = g_adc_irq_count;
+        last_cycles = g_adc_irq_cycles;
+    }
 }
 
 /* ============================================================================
  * Hardware Control
  * ============================================================================ */
-void LED_SetPattern(uint8_t pattern) {
-    (pattern & 0x01) ? (LED1_PORT->BSRR = (1 << LED1_PIN)) :
-                       (LED1_PORT->BSRR = (1 << (LED1_PIN + 16)));
-    (pattern & 0x02) ? (LED2_PORT->BSRR = (1 << LED2_PIN)) :
-                       (LED2_PORT->BSRR = (1 << (LED2_PIN + 16)));
-    (pattern & 0x04) ? (LED3_PORT->BSRR = (1 << LED3_PIN)) :
-                       (LED3_PORT->BSRR = (1 << (LED3_PIN + 16)));
-    (pattern & 0x08) ? (LED4_PORT->BSRR = (1 << LED4_PIN)) :
-                       (LED4_PORT->BSRR = (1 << (LED4_PIN + 16)));
-}
-
 void SevenSeg_Display(uint8_t digit) {
     if(digit > 9) return;
     (digit & 0x01) ? (BCD_2_0_PORT->BSRR = (1 << BCD_2_0_PIN)) :
@@ -149,49 +363,37 @@ void SevenSeg_Display(uint8_t digit) {
 /* ============================================================================
  * Interrupt Handler
  * ============================================================================ */
-void ADC_IRQHandler(void) {
-    if(ADC1->SR & ADC_SR_EOC) {
-        g_adc_values[g_current_adc_channel] = ADC1->DR;
-        g_current_adc_channel = (g_current_adc_channel + 1) % 3;
-        ADC1->SQR3 = (ADC1->SQR3 & ~ADC_SQR3_SQ1) |
-                     (g_current_adc_channel == 0 ? POT_PIN :
-                     (g_current_adc_channel == 1 ? TEMP_PIN : LIGHT_PIN));
-        ADC1->CR2 |= ADC_CR2_SWSTART;
+// Average one finished half of the buffer into g_adc_values[]
+static void adc_block_done(const uint16_t* block) {
+    uint32_t sum[ADC_CHANNELS] = {0};
+    for(int s = 0; s < ADC_OVERSAMPLE; s++) {
+        for(int ch = 0; ch < ADC_CHANNELS; ch++) {
+            sum[ch] += block[s * ADC_CHANNELS + ch];
+        }
     }
+    for(int ch = 0; ch < ADC_CHANNELS; ch++) {
+        g_adc_values[ch] = sum[ch] / ADC_OVERSAMPLE;
+    }
+    if(s_adc_block_cb) s_adc_block_cb(block, ADC_OVERSAMPLE);
 }
 
-void Buzzer_Init(void) {
-    RCC->AHB1ENR |= RCC_AHB1ENR_GPIOCEN;  // เปิด clock ของพอร์ต C
-    RCC->APB1ENR |= RCC_APB1ENR_TIM3EN;   // ใช้ TIM3 เหมือนเดิม
-
-    // PC9 -> AF2 (TIM3_CH4)
-    GPIOC->MODER &= ~(3u << (BUZZER_PIN * 2));
-    GPIOC->MODER |=  (2u << (BUZZER_PIN * 2));    // Alternate function
-    GPIOC->AFR[1] &= ~(0xFu << ((BUZZER_PIN - 8) * 4));
-    GPIOC->AFR[1] |=  (2u   << ((BUZZER_PIN - 8) * 4)); // AF2 = TIM3
-
-    // ตั้งค่า Timer3 channel 4 เป็น PWM
-    TIM3->PSC  = 83;        // 1 MHz tick (84MHz / 84)
-    TIM3->ARR  = 1000;      // ค่าเริ่มต้น ~1kHz
-    TIM3->CCR4 = 0;         // duty 0% (เงียบ)
-
-    TIM3->CCMR2 &= ~(7u << 12);          // เคลียร์ OC4M
-    TIM3->CCMR2 |=  (6u << 12);          // PWM mode 1
-    TIM3->CCMR2 |=  TIM_CCMR2_OC4PE;     // preload enable
-
-    TIM3->CCER  |=  TIM_CCER_CC4E;       // เปิด channel 4 output
-    TIM3->CR1   |=  TIM_CR1_ARPE | TIM_CR1_CEN;
-}
+void DMA2_Stream0_IRQHandler(void) {
+    PROF_BEGIN(PROF_ISR_ADC_DMA);
+    uint32_t start = Cycle_Now();
+    uint32_t isr = DMA2->LISR;
+    DMA2->LIFCR = isr & (DMA_LIFCR_CFEIF0 | DMA_LIFCR_CDMEIF0 | DMA_LIFCR_CTEIF0 |
+                         DMA_LIFCR_CHTIF0 | DMA_LIFCR_CTCIF0);
 
+    if(isr & DMA_LISR_HTIF0) adc_block_done(&s_adc_dma[0]);
+    if(isr & DMA_LISR_TCIF0) adc_block_done(&s_adc_dma[ADC_DMA_LEN / 2]);
+    // DMA_LISR_TEIF0 leaves the stream disabled; Monitor_ADC() re-arms it
 
-void Buzzer_Play(uint32_t freq_hz, uint8_t duty_percent) {
-    if (freq_hz == 0 || duty_percent == 0) { TIM3->CCR4 = 0; return; }
-    uint32_t arr = (1000000 / freq_hz) - 1;     // 1 MHz base
-    if (arr > 65535) arr = 65535;
-    TIM3->ARR  = arr;
-    TIM3->CCR4 = (arr + 1) * duty_percent / 100;
+    g_adc_irq_count++;
+    g_adc_irq_cycles += Cycle_Now() - start;
+    PROF_END(PROF_ISR_ADC_DMA);
 }
 
-void Buzzer_Stop(void) {
-    TIM3->CCR4 = 0;
-}
\ No newline at end of file
+void EXTI3_IRQHandler(void)     { button_exti(); }
+void EXTI4_IRQHandler(void)     { button_exti(); }
+void EXTI9_5_IRQHandler(void)   { button_exti(); }
+void EXTI15_10_IRQHandler(void) { button_exti(); }
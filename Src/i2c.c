@@ -0,0 +1,402 @@
+/* ============================================================================
+ * I2C1 Transport Implementation
+ * Master transmit over I2C1 with a descriptor queue. With I2C_USE_DMA the
+ * event/error interrupts walk START -> address -> control byte, DMA1 Stream 7
+ * feeds the payload, and the BTF event issues STOP and starts the next
+ * descriptor. Without it every transfer is sent synchronously by polling.
+ * ============================================================================ */
+
+#include "i2c.h"
+#include "hardware.h"
+#include "utils.h"
+#include "prof.h"
+#include <string.h>
+
+#define STM32F411xE
+#include "stm32f4xx.h"
+
+#define I2C_DMA_STREAM  DMA1_Stream7
+#define I2C_DMA_CHANNEL 1u
+#define I2C_DMA_FLAGS   (DMA_HIFCR_CTCIF7 | DMA_HIFCR_CHTIF7 | DMA_HIFCR_CTEIF7 | \
+                         DMA_HIFCR_CDMEIF7 | DMA_HIFCR_CFEIF7)
+#define I2C_STOP_SPIN   1000u   /* STOP clears within one SCL period */
+
+typedef struct {
+    uint8_t addr;
+    uint8_t ctrl;
+    uint16_t len;
+    const uint8_t* data;
+    uint8_t buf[I2C_INLINE_MAX];
+} I2C_Xfer_t;
+
+I2C_Stats_t g_i2c_stats = {0};
+static void (*s_done_cb)(void) = 0;
+static I2C_Speed_t s_speed = I2C_SPEED_STANDARD;
+
+/* ============================================================================
+ * Bus Setup and Recovery
+ * ============================================================================ */
+static uint32_t div_ceil(uint32_t a, uint32_t b) {
+    return (a + b - 1) / b;
+}
+
+// Reset the peripheral and program FREQ/CCR/TRISE for s_speed
+static void i2c_configure(void) {
+    uint32_t pclk = SystemClock_GetPCLK1();
+    uint32_t mhz  = pclk / 1000000;
+    uint32_t ccr, trise;
+
+    // Round CCR up so SCL never runs faster than the selected mode
+    switch(s_speed) {
+        case I2C_SPEED_FAST:
+            ccr   = I2C_CCR_FS | div_ceil(pclk, 3 * 400000);
+            trise = mhz * 300 / 1000 + 1;       // 300 ns max rise
+            break;
+        case I2C_SPEED_FAST_DUTY:
+            ccr   = I2C_CCR_FS | I2C_CCR_DUTY | div_ceil(pclk, 25 * 400000);
+            trise = mhz * 300 / 1000 + 1;
+            break;
+        case I2C_SPEED_FAST_PLUS:
+            ccr   = I2C_CCR_FS | I2C_CCR_DUTY | div_ceil(pclk, 25 * 1000000);
+            trise = mhz * 120 / 1000 + 1;       // 120 ns max rise
+            break;
+        default:
+            ccr   = div_ceil(pclk, 2 * 100000);
+            if(ccr < 4) ccr = 4;                // minimum in standard mode
+            trise = mhz + 1;                    // 1000 ns max rise
+            break;
+    }
+
+    RCC->APB1RSTR |= RCC_APB1RSTR_I2C1RST;
+    RCC->APB1RSTR &= ~RCC_APB1RSTR_I2C1RST;
+
+    I2C1->CR1 = 0;
+    I2C1->CR2 = mhz & I2C_CR2_FREQ;
+    I2C1->CCR = ccr;
+    I2C1->TRISE = trise;
+    I2C1->CR1 = I2C_CR1_PE;
+}
+
+static void i2c_pins_af(void) {
+    GPIOB->MODER &= ~((3u<<(8*2))|(3u<<(9*2)));
+    GPIOB->MODER |=  ((2u<<(8*2))|(2u<<(9*2)));
+}
+
+// About 5 us, half an SCL period at 100 kHz
+static void i2c_bit_delay(void) {
+    for(volatile uint32_t n = SystemCoreClock / 1000000; n; n--);
+}
+
+#if !I2C_USE_DMA
+/* ============================================================================
+ * Polled Transfer (synchronous fallback)
+ * ============================================================================ */
+static uint8_t i2c_wait_sr1(uint32_t flag) {
+    uint32_t start = GetTick();
+    while(!(I2C1->SR1 & flag)) {
+        if((GetTick() - start) > I2C_TIMEOUT_MS) return 0;
+    }
+    return 1;
+}
+
+static uint8_t i2c_start(uint8_t addr) {
+    I2C1->CR1 |= I2C_CR1_START;
+    if(!i2c_wait_sr1(I2C_SR1_SB)) return 0;
+    (void)I2C1->SR1;
+    I2C1->DR = addr<<1;
+    if(!i2c_wait_sr1(I2C_SR1_ADDR)) return 0;
+    (void)I2C1->SR1;
+    (void)I2C1->SR2;
+    return 1;
+}
+
+static uint8_t i2c_w(uint8_t b) {
+    if(!i2c_wait_sr1(I2C_SR1_TXE)) return 0;
+    I2C1->DR = b;
+    return i2c_wait_sr1(I2C_SR1_BTF);
+}
+
+static void i2c_stop(void) {
+    I2C1->CR1 |= I2C_CR1_STOP;
+}
+
+static void i2c_write_polled(uint8_t addr, uint8_t ctrl, const uint8_t* data, uint16_t n) {
+    g_i2c_stats.transfers++;
+    g_i2c_stats.bytes += n + 2;
+
+    uint8_t ok = i2c_start(addr) && i2c_w(ctrl);
+    while(ok && n--) ok = i2c_w(*data++);
+    i2c_stop();
+
+    if(!ok) {
+        // NACK or stuck bus: free SDA and start over from a clean peripheral
+        g_i2c_stats.errors++;
+        I2C1_BusRecover();
+        i2c_configure();
+    }
+}
+
+#else
+/* ============================================================================
+ * Queued Transfer (DMA)
+ * ============================================================================ */
+/* Transfer Queue: head is advanced by the caller, tail by the ISR */
+static I2C_Xfer_t s_queue[I2C_QUEUE_LEN];
+static volatile uint8_t s_head = 0;
+static volatile uint8_t s_tail = 0;
+static volatile uint8_t s_busy = 0;
+static volatile uint32_t s_start_tick = 0;  // watchdog: when the in-flight transfer began
+
+static inline I2C_Xfer_t* queue_tail(void) {
+    return &s_queue[s_tail & (I2C_QUEUE_LEN - 1)];
+}
+
+// Start the descriptor at the tail, or go idle; called with IRQs masked
+static void i2c_begin_next(void) {
+    if(s_tail == s_head) {
+        s_busy = 0;
+        if(s_done_cb) s_done_cb();
+        return;
+    }
+    s_busy = 1;
+    s_start_tick = GetTick();
+    I2C1->CR2 |= I2C_CR2_ITEVTEN | I2C_CR2_ITERREN;
+    I2C1->CR1 |= I2C_CR1_START;
+}
+
+static void i2c_finish(void) {
+    I2C1->CR1 |= I2C_CR1_STOP;
+    I2C1->CR2 &= ~(I2C_CR2_ITEVTEN | I2C_CR2_ITERREN | I2C_CR2_DMAEN);
+    for(uint32_t n = 0; (I2C1->CR1 & I2C_CR1_STOP) && n < I2C_STOP_SPIN; n++);
+    s_tail++;
+    i2c_begin_next();
+}
+
+// Called from every wait loop: if the in-flight transfer has not finished
+// within I2C_TIMEOUT_MS of its START the bus is hung, so drop it and recover
+static void i2c_watchdog(void) {
+    if(!s_busy || (GetTick() - s_start_tick) <= I2C_TIMEOUT_MS) return;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    // The ISR may have finished it between the check and the mask
+    if(!s_busy || (GetTick() - s_start_tick) <= I2C_TIMEOUT_MS) {
+        __set_PRIMASK(primask);
+        return;
+    }
+    I2C_DMA_STREAM->CR &= ~DMA_SxCR_EN;
+    DMA1->HIFCR = I2C_DMA_FLAGS;
+    I2C1->CR2 &= ~(I2C_CR2_ITEVTEN | I2C_CR2_ITERREN | I2C_CR2_DMAEN);
+    I2C1_BusRecover();
+    i2c_configure();
+    g_i2c_stats.errors++;
+    s_tail++;
+    i2c_begin_next();
+    __set_PRIMASK(primask);
+}
+
+static void i2c_enqueue(uint8_t addr, uint8_t ctrl, const uint8_t* data, uint16_t n, uint8_t copy) {
+    // Wait for a free slot; the ISR keeps draining meanwhile
+    while((uint8_t)(s_head - s_tail) >= I2C_QUEUE_LEN) i2c_watchdog();
+
+    I2C_Xfer_t* x = &s_queue[s_head & (I2C_QUEUE_LEN - 1)];
+    x->addr = addr;
+    x->ctrl = ctrl;
+    x->len  = n;
+    if(copy) {
+        memcpy(x->buf, data, n);
+        x->data = x->buf;
+    } else {
+        x->data = data;
+    }
+
+    g_i2c_stats.transfers++;
+    g_i2c_stats.bytes += n + 2;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    s_head++;
+    if(!s_busy) i2c_begin_next();
+    __set_PRIMASK(primask);
+}
+#endif /* I2C_USE_DMA */
+
+/* ============================================================================
+ * Public Functions
+ * ============================================================================ */
+void I2C1_Init(I2C_Speed_t speed) {
+    RCC->AHB1ENR |= RCC_AHB1ENR_GPIOBEN;
+    s_speed = speed;
+
+    // PB8, PB9 AF4, Open-Drain, Pull-Up, High speed
+    GPIOB->OTYPER |=  (1u<<8)|(1u<<9);
+    GPIOB->OSPEEDR|=  (3u<<(8*2))|(3u<<(9*2));
+    GPIOB->PUPDR  &= ~((3u<<(8*2))|(3u<<(9*2)));
+    GPIOB->PUPDR  |=  ((1u<<(8*2))|(1u<<(9*2)));
+    GPIOB->AFR[1] &= ~((0xFu<<0)|(0xFu<<4));
+    GPIOB->AFR[1] |=  ((4u<<0) |(4u<<4));
+
+    // A panel reset mid-byte can leave SDA held low across our reset
+    I2C1_BusRecover();
+
+    RCC->APB1ENR |= RCC_APB1ENR_I2C1EN;
+    i2c_configure();
+
+#if I2C_USE_DMA
+    // DMA1 Stream 7 / Channel 1 = I2C1_TX, memory -> DR, byte wide
+    RCC->AHB1ENR |= RCC_AHB1ENR_DMA1EN;
+    I2C_DMA_STREAM->CR = 0;
+    while(I2C_DMA_STREAM->CR & DMA_SxCR_EN);
+    DMA1->HIFCR = I2C_DMA_FLAGS;
+    I2C_DMA_STREAM->PAR = (uintptr_t)&I2C1->DR;
+    I2C_DMA_STREAM->CR = (I2C_DMA_CHANNEL << DMA_SxCR_CHSEL_Pos) |
+                         DMA_SxCR_MINC | DMA_SxCR_DIR_0 |
+                         DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+
+    NVIC_SetPriority(I2C1_EV_IRQn, 2);
+    NVIC_SetPriority(I2C1_ER_IRQn, 2);
+    NVIC_SetPriority(DMA1_Stream7_IRQn, 2);
+    NVIC_EnableIRQ(I2C1_EV_IRQn);
+    NVIC_EnableIRQ(I2C1_ER_IRQn);
+    NVIC_EnableIRQ(DMA1_Stream7_IRQn);
+#endif
+}
+
+void I2C1_Write(uint8_t addr, uint8_t ctrl, const uint8_t* data, uint16_t n) {
+#if I2C_USE_DMA
+    if(n > I2C_INLINE_MAX) {
+        // Too long to copy: send in place and hold the caller until it is out
+        i2c_enqueue(addr, ctrl, data, n, 0);
+        I2C1_WaitIdle();
+        return;
+    }
+    i2c_enqueue(addr, ctrl, data, n, 1);
+#else
+    i2c_write_polled(addr, ctrl, data, n);
+    if(s_done_cb) s_done_cb();
+#endif
+}
+
+void I2C1_WriteRef(uint8_t addr, uint8_t ctrl, const uint8_t* data, uint16_t n) {
+#if I2C_USE_DMA
+    i2c_enqueue(addr, ctrl, data, n, 0);
+#else
+    i2c_write_polled(addr, ctrl, data, n);
+    if(s_done_cb) s_done_cb();
+#endif
+}
+
+uint8_t I2C1_Idle(void) {
+#if I2C_USE_DMA
+    return !s_busy && s_head == s_tail;
+#else
+    return 1;
+#endif
+}
+
+uint8_t I2C1_Free(void) {
+#if I2C_USE_DMA
+    return I2C_QUEUE_LEN - (uint8_t)(s_head - s_tail);
+#else
+    return I2C_QUEUE_LEN;
+#endif
+}
+
+void I2C1_WaitIdle(void) {
+#if I2C_USE_DMA
+    while(!I2C1_Idle()) i2c_watchdog();
+#endif
+}
+
+// Bit-bang up to 9 SCL pulses until the slave releases SDA, then a STOP,
+// leaving PB8/PB9 back on AF4
+void I2C1_BusRecover(void) {
+    GPIOB->BSRR = (1u<<8)|(1u<<9);
+    GPIOB->MODER = (GPIOB->MODER & ~((3u<<(8*2))|(3u<<(9*2)))) |
+                   (1u<<(8*2)) | (1u<<(9*2));
+    i2c_bit_delay();
+
+    for(uint8_t i = 0; i < 9 && !(GPIOB->IDR & (1u<<9)); i++) {
+        GPIOB->BSRR = (1u<<(8+16));     // SCL low
+        i2c_bit_delay();
+        GPIOB->BSRR = (1u<<8);          // SCL high
+        i2c_bit_delay();
+    }
+
+    // STOP: SDA rises while SCL is high
+    GPIOB->BSRR = (1u<<(8+16));
+    i2c_bit_delay();
+    GPIOB->BSRR = (1u<<(9+16));
+    i2c_bit_delay();
+    GPIOB->BSRR = (1u<<8);
+    i2c_bit_delay();
+    GPIOB->BSRR = (1u<<9);
+    i2c_bit_delay();
+
+    i2c_pins_af();
+}
+
+// New APB1 clock: reprogram the timing; only while I2C1_Idle()
+void I2C1_ClockChanged(void) {
+    i2c_configure();
+}
+
+void I2C1_SetDoneCallback(void (*cb)(void)) {
+    s_done_cb = cb;
+}
+
+#if I2C_USE_DMA
+/* ============================================================================
+ * Interrupt Handlers
+ * ============================================================================ */
+void I2C1_EV_IRQHandler(void) {
+    PROF_BEGIN(PROF_ISR_I2C_EV);
+    uint32_t sr1 = I2C1->SR1;
+    const I2C_Xfer_t* x = queue_tail();
+
+    if(sr1 & I2C_SR1_SB) {
+        I2C1->DR = (uint32_t)x->addr << 1;
+    } else if(sr1 & I2C_SR1_ADDR) {
+        (void)I2C1->SR2;
+        I2C1->DR = x->ctrl;
+        if(x->len) {
+            // Hand the payload to DMA; the BTF event is re-armed on TC
+            DMA1->HIFCR = I2C_DMA_FLAGS;
+            I2C_DMA_STREAM->M0AR = (uintptr_t)x->data;
+            I2C_DMA_STREAM->NDTR = x->len;
+            I2C_DMA_STREAM->CR |= DMA_SxCR_EN;
+            I2C1->CR2 = (I2C1->CR2 & ~I2C_CR2_ITEVTEN) | I2C_CR2_DMAEN;
+        }
+    } else if(sr1 & I2C_SR1_BTF) {
+        i2c_finish();
+    }
+    PROF_END(PROF_ISR_I2C_EV);
+}
+
+void I2C1_ER_IRQHandler(void) {
+    // NACK, bus error or lost arbitration: drop the transfer and move on
+    PROF_BEGIN(PROF_ISR_I2C_ER);
+    g_i2c_stats.errors++;
+    I2C1->SR1 &= ~(I2C_SR1_AF | I2C_SR1_BERR | I2C_SR1_ARLO | I2C_SR1_OVR);
+    I2C_DMA_STREAM->CR &= ~DMA_SxCR_EN;
+    DMA1->HIFCR = I2C_DMA_FLAGS;
+    i2c_finish();
+    PROF_END(PROF_ISR_I2C_ER);
+}
+
+void DMA1_Stream7_IRQHandler(void) {
+    PROF_BEGIN(PROF_ISR_I2C_DMA);
+    uint32_t hisr = DMA1->HISR;
+    DMA1->HIFCR = I2C_DMA_FLAGS;
+    I2C_DMA_STREAM->CR &= ~DMA_SxCR_EN;
+
+    if(hisr & DMA_HISR_TEIF7) {
+        g_i2c_stats.errors++;
+        i2c_finish();
+    } else {
+        // Last byte is in the shifter: wait for BTF before STOP
+        I2C1->CR2 = (I2C1->CR2 & ~I2C_CR2_DMAEN) | I2C_CR2_ITEVTEN;
+    }
+    PROF_END(PROF_ISR_I2C_DMA);
+}
+#endif /* I2C_USE_DMA */
@@ -0,0 +1,321 @@
+/* ============================================================================
+ * Input Journal Implementation
+ * A game record is the seed (4 bytes, little endian), the speed (1 byte),
+ * one varint per edge and a 0 byte. An edge encodes as
+ *   ((delta_ms << 4) | (used << 3) | (pressed << 2) | button) + 1
+ * so only the terminator is ever 0; used is 1 when the game read the edge
+ * and 0 when it flushed it. Recording runs in the main loop alone, which
+ * is where the game takes events off the queue.
+ *
+ * A replay plays from s_replay, filled by 'g' in the main loop or by the
+ * USART2 ISR while it parses "J<hex>" lines; the ISR only writes there
+ * while no replay is loaded. Once its edges run out (or on 'x') the pins
+ * are live again for the rest of that game, which still isn't scored.
+ * ============================================================================ */
+
+#include "journal.h"
+#include "hardware.h"
+#include "power.h"
+#include "utils.h"
+
+#define STM32F411xE
+#include "stm32f4xx.h"
+
+#define HEADER_BYTES    5               /* seed, speed */
+#define LINE_BYTES      32              /* hex bytes per exported line */
+#define RING(i)         s_ring[(uint16_t)(i) & (JOURNAL_SIZE - 1)]
+
+typedef enum {
+    REPLAY_IDLE,
+    REPLAY_LOADED,                      // waiting for the speed selection
+    REPLAY_RUNNING,
+    REPLAY_LIVE                         // edges used up or aborted, the game goes on
+} ReplayState_t;
+
+/* Recording: games from s_tail to s_head, the last one open while recording */
+static uint8_t s_ring[JOURNAL_SIZE];
+static uint16_t s_head = 0;
+static uint16_t s_tail = 0;
+static uint16_t s_game = 0;             // start of the open game
+static uint8_t s_recording = 0;
+static uint8_t s_overflow = 0;          // open game outgrew the ring
+static uint32_t s_game_start;           // tick the speed locked
+static uint32_t s_last_edge;            // tick of the previous edge
+static uint16_t s_edges;
+static uint16_t s_games = 0;            // games recorded since boot
+
+/* Replay */
+static uint8_t s_replay[JOURNAL_SIZE];
+static volatile uint16_t s_replay_len = 0;
+static volatile uint8_t s_replay_state = REPLAY_IDLE;
+static uint16_t s_replay_pos;
+static uint32_t s_replay_due;           // tick of the next edge
+static uint32_t s_replay_value;         // that edge, decoded
+
+/* USART2 RX (ISR) */
+static volatile uint8_t s_request = 0;  // 'j', 'g' or 'J' (import complete)
+static uint8_t s_rx_line = 0;           // inside a "J..." line
+static uint8_t s_rx_importing = 0;      // a "J<hex>" line came, no bare "J" yet
+static uint8_t s_rx_digits = 0;
+static uint8_t s_rx_byte = 0;
+
+/* ============================================================================
+ * Encoding
+ * ============================================================================ */
+// Append one byte; evicts whole games, oldest first, to make room
+static uint8_t put(uint8_t b) {
+    if((uint16_t)(s_head - s_tail) == JOURNAL_SIZE) {
+        if(s_tail == s_game) return 0;  // the open game fills the ring
+        uint16_t i = s_tail + HEADER_BYTES;
+        while(RING(i) != 0) i++;
+        s_tail = i + 1;
+    }
+    RING(s_head++) = b;
+    return 1;
+}
+
+static void put_varint(uint32_t v) {
+    while(v >= 0x80 && s_recording) {
+        if(!put((uint8_t)v | 0x80)) s_recording = 0;
+        v >>= 7;
+    }
+    if(s_recording && !put((uint8_t)v)) s_recording = 0;
+}
+
+// Next varint from buf at *pos (bounded by len); 0 = terminator or end
+static uint32_t get_varint(const uint8_t* buf, uint16_t len, uint16_t* pos) {
+    uint32_t v = 0;
+    for(uint8_t shift = 0; *pos < len && shift < 32; shift += 7) {
+        uint8_t b = buf[(*pos)++];
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if(!(b & 0x80)) return v;
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * Recording
+ * ============================================================================ */
+void Journal_Begin(uint32_t seed, uint8_t speed) {
+    if(s_replay_state >= REPLAY_RUNNING) return;
+    s_game = s_head;
+    s_recording = 1;
+    s_overflow = 0;
+    for(uint8_t i = 0; i < 4; i++) put((uint8_t)(seed >> (8 * i)));
+    put(speed);
+    s_game_start = s_last_edge = GetTick();
+    s_edges = 0;
+}
+
+void Journal_Edge(const ButtonEvent_t* ev) {
+    if(!s_recording) return;
+    uint32_t delta = ev->time - s_last_edge;
+    if((int32_t)delta < 0) delta = 0;   // queued before the speed locked
+    else s_last_edge = ev->time;
+    s_edges++;
+    put_varint(((delta << 4) | ((uint32_t)ev->used << 3) |
+                ((uint32_t)ev->pressed << 2) | ev->button) + 1);
+    if(!s_recording) s_overflow = 1;
+}
+
+void Journal_End(void) {
+    uint32_t ms = GetTick() - s_game_start;
+    if(s_replay_state >= REPLAY_RUNNING) {
+        s_replay_state = REPLAY_IDLE;
+        LOG("[JOURNAL] Replay ended: %u edges, %lu ms\r\n", s_edges, ms);
+        return;
+    }
+    if(s_recording && put(0)) {
+        s_games++;
+        LOG("[JOURNAL] Game %u recorded: %u edges, %lu ms, %u bytes\r\n",
+            s_games, s_edges, ms, (uint16_t)(s_head - s_game));
+    } else if(s_recording || s_overflow) {
+        s_head = s_game;                // drop the partial game
+        LOG("[JOURNAL] Game too long for the %u byte ring, not kept\r\n", JOURNAL_SIZE);
+    }
+    s_recording = 0;
+}
+
+/* ============================================================================
+ * Export
+ * ============================================================================ */
+// Length of the complete game at ring position i, terminator included
+static uint16_t game_length(uint16_t i) {
+    uint16_t n = HEADER_BYTES;
+    while(RING(i + n) != 0) n++;
+    return n + 1;
+}
+
+static void export_all(void) {
+    static const char HEX[] = "0123456789ABCDEF";
+    uint16_t end = s_recording ? s_game : s_head;
+    uint16_t number = 0;
+
+    for(uint16_t i = s_tail; i != end; i += game_length(i)) {
+        uint16_t len = game_length(i);
+        uint32_t seed = 0;
+        for(uint8_t k = 0; k < 4; k++) seed |= (uint32_t)RING(i + k) << (8 * k);
+        uint16_t edges = 0;
+        for(uint16_t k = HEADER_BYTES; k < len - 1; k++) {
+            if(!(RING(i + k) & 0x80)) edges++;
+        }
+        Log_Print("[JOURNAL] Game %u: seed %08lX, speed %u, %u edges\r\n",
+                  ++number, seed, RING(i + 4), edges);
+
+        char line[2 + 2 * LINE_BYTES + 2];
+        for(uint16_t k = 0; k < len; k += LINE_BYTES) {
+            char* p = line;
+            *p++ = 'J';
+            for(uint16_t b = k; b < len && b < k + LINE_BYTES; b++) {
+                *p++ = HEX[RING(i + b) >> 4];
+                *p++ = HEX[RING(i + b) & 15];
+            }
+            *p = 0;
+            Log_Print("%s\r\n", line);
+            Log_Flush();
+        }
+        Log_Print("J\r\n");
+    }
+    if(!number) Log_Print("[JOURNAL] No complete games\r\n");
+}
+
+/* ============================================================================
+ * Replay
+ * ============================================================================ */
+// Decode the next edge; 0 once the record is used up
+static uint8_t replay_next(void) {
+    uint32_t v = get_varint(s_replay, s_replay_len, &s_replay_pos);
+    if(v == 0) return 0;
+    s_replay_value = v - 1;
+    s_replay_due += s_replay_value >> 4;
+    return 1;
+}
+
+static void load_last(void) {
+    uint16_t end = s_recording ? s_game : s_head;
+    if(s_tail == end) {
+        LOG("[JOURNAL] Nothing recorded to replay\r\n");
+        return;
+    }
+    uint16_t last = s_tail;
+    for(uint16_t i = s_tail; i != end; i += game_length(i)) last = i;
+    uint16_t len = game_length(last);
+    for(uint16_t k = 0; k < len; k++) s_replay[k] = RING(last + k);
+    s_replay_len = len;
+    s_replay_state = REPLAY_LOADED;
+}
+
+uint8_t Journal_ReplayStart(uint32_t* seed, uint8_t* speed) {
+    if(s_replay_state != REPLAY_LOADED) return 0;
+    *seed = 0;
+    for(uint8_t k = 0; k < 4; k++) *seed |= (uint32_t)s_replay[k] << (8 * k);
+    *speed = s_replay[4];
+    s_replay_pos = HEADER_BYTES;
+    s_game_start = s_replay_due = GetTick();
+    s_edges = 0;
+    s_replay_state = REPLAY_RUNNING;
+    if(!replay_next()) s_replay_pos = s_replay_len;
+    LOG("[JOURNAL] Replay: seed %08lX, speed %u\r\n", *seed, *speed);
+    return 1;
+}
+
+uint8_t Journal_Replaying(void) {
+    return s_replay_state == REPLAY_RUNNING;
+}
+
+uint8_t Journal_ReplayGame(void) {
+    return s_replay_state >= REPLAY_RUNNING;
+}
+
+// Hand the buttons back; the game in progress finishes unscored
+static void replay_stop(void) {
+    s_replay_state = REPLAY_LIVE;
+    LOG("[JOURNAL] Replay stopped after %u edges, buttons live\r\n", s_edges);
+}
+
+uint32_t Journal_Deadline(uint32_t wake) {
+    if(s_replay_state != REPLAY_RUNNING || s_replay_pos >= s_replay_len) return wake;
+    return ((int32_t)(s_replay_due - wake) < 0) ? s_replay_due : wake;
+}
+
+/* ============================================================================
+ * Commands and Polling
+ * ============================================================================ */
+void Journal_Init(void) {
+    USART2->CR1 |= USART_CR1_RXNEIE;
+}
+
+static int8_t hex_value(uint8_t c) {
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// "J<hex>" lines append to the replay buffer, a bare "J" line loads it
+void Journal_Command(uint8_t c) {
+    if(s_rx_line) {
+        int8_t h = hex_value(c);
+        if(h >= 0) {
+            if(s_replay_state != REPLAY_IDLE) return;
+            if(!s_rx_importing) {
+                s_rx_importing = 1;
+                s_replay_len = 0;
+            }
+            s_rx_byte = (uint8_t)(s_rx_byte << 4) | (uint8_t)h;
+            if(++s_rx_digits % 2 == 0 && s_replay_len < JOURNAL_SIZE)
+                s_replay[s_replay_len++] = s_rx_byte;
+        } else {
+            if((c == '\r' || c == '\n') && s_rx_digits == 0 && s_rx_importing) {
+                s_rx_importing = 0;
+                s_request = 'J';
+                Power_RequestWake();
+            }
+            s_rx_line = 0;
+        }
+        return;
+    }
+    if(c == 'J') {
+        s_rx_line = 1;
+        s_rx_digits = 0;
+    } else if(c == 'j' || c == 'g' || c == 'x') {
+        s_request = c;
+        Power_RequestWake();
+    }
+}
+
+void Journal_Poll(void) {
+    uint8_t c = s_request;
+    if(c) {
+        s_request = 0;
+        if(c == 'j') {
+            export_all();
+        } else if(c == 'x') {
+            if(s_replay_state == REPLAY_RUNNING) replay_stop();
+            else if(s_replay_state == REPLAY_LOADED) {
+                s_replay_state = REPLAY_IDLE;
+                LOG("[JOURNAL] Loaded replay dropped\r\n");
+            }
+        } else if(s_replay_state >= REPLAY_RUNNING) {
+            LOG("[JOURNAL] Replay already running\r\n");
+        } else {
+            if(c == 'g') load_last();
+            else if(s_replay_len > HEADER_BYTES && s_replay[s_replay_len - 1] == 0)
+                s_replay_state = REPLAY_LOADED;
+            else LOG("[JOURNAL] Import rejected: %u bytes, no terminator\r\n", s_replay_len);
+            if(s_replay_state == REPLAY_LOADED)
+                LOG("[JOURNAL] Replay loaded (%u bytes), starts at the speed selection\r\n",
+                    s_replay_len);
+        }
+    }
+
+    // Edges that are due go into the button queue as if the EXTI saw them
+    while(s_replay_state == REPLAY_RUNNING && s_replay_pos < s_replay_len &&
+          (int32_t)(GetTick() - s_replay_due) >= 0) {
+        Button_Replay(s_replay_value & 3, (s_replay_value >> 2) & 1, s_replay_due,
+                      (s_replay_value >> 3) & 1);
+        s_edges++;
+        if(!replay_next()) s_replay_pos = s_replay_len;
+    }
+    if(s_replay_state == REPLAY_RUNNING && s_replay_pos >= s_replay_len) replay_stop();
+}
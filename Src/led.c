@@ -0,0 +1,262 @@
+/* ============================================================================
+ * LED Brightness Implementation
+ * TIM5 counts microseconds and its update interrupt steps through the bit
+ * planes: plane b is shown for LED_BAM_UNIT_US << b, so over a frame of 255
+ * units each LED is on for exactly its duty. ARR is preloaded, so the ISR
+ * that starts plane b writes the length of plane b+1. The BSRR words for
+ * all planes are rebuilt whenever a level changes, never per plane.
+ * ============================================================================ */
+
+#include "led.h"
+#include "hardware.h"
+#include "power.h"
+#include "prof.h"
+
+#define STM32F411xE
+#include "stm32f4xx.h"
+
+#define LED_TICK_HZ     1000000u                /* TIM5 counter clock */
+#define LED_PLANES      8
+#define FRAME_US        (255u * LED_BAM_UNIT_US)
+
+typedef enum {
+    LED_STILL,
+    LED_FADING,
+    LED_BREATHING
+} LedMode_t;
+
+typedef struct {
+    uint32_t level;         // 16.16 fixed point
+    int32_t step;           // per frame
+    uint8_t target;
+    uint8_t lo, hi;         // breathing bounds
+    uint8_t mode;           // LedMode_t
+} Led_t;
+
+/* BSRR slot 0 is LED1_PORT, shared by LED1..3; slot 1 is LED4_PORT */
+static const uint8_t LED_PORT_OF[LED_COUNT] = { 0, 0, 0, 1 };
+static const uint8_t LED_PIN_OF[LED_COUNT]  = { LED1_PIN, LED2_PIN, LED3_PIN, LED4_PIN };
+
+static Led_t s_led[LED_COUNT];
+static uint32_t s_plane_bsrr[LED_PLANES][2];    // BSRR word per plane and port
+static uint8_t s_plane = 0;                     // plane the next update starts
+static volatile uint8_t s_running = 0;          // TIM5 stepping planes
+static volatile uint8_t s_fading = 0;           // LEDs in LED_FADING
+
+/* ============================================================================
+ * Planes (called with TIM5 unable to interrupt)
+ * ============================================================================ */
+// Perceived brightness is roughly the square of the duty; keep 1 visible
+static uint8_t level_to_duty(uint8_t level) {
+    return (uint8_t)(((uint32_t)level * level + 254) / 255);
+}
+
+// Returns 1 if every duty is 0 or 255, i.e. all planes are the same
+static uint8_t rebuild_planes(void) {
+    uint8_t duty[LED_COUNT];
+    uint8_t still = 1;
+    for(uint8_t i = 0; i < LED_COUNT; i++) {
+        duty[i] = level_to_duty((uint8_t)(s_led[i].level >> 16));
+        if(duty[i] != 0 && duty[i] != 255) still = 0;
+    }
+
+    for(uint8_t b = 0; b < LED_PLANES; b++) {
+        uint32_t bsrr[2] = { 0, 0 };
+        for(uint8_t i = 0; i < LED_COUNT; i++) {
+            uint8_t pin = LED_PIN_OF[i];
+            bsrr[LED_PORT_OF[i]] |= ((duty[i] >> b) & 1u) ? (1u << pin) : (1u << (pin + 16));
+        }
+        s_plane_bsrr[b][0] = bsrr[0];
+        s_plane_bsrr[b][1] = bsrr[1];
+    }
+    return still;
+}
+
+static void write_plane(uint8_t b) {
+    LED1_PORT->BSRR = s_plane_bsrr[b][0];
+    LED4_PORT->BSRR = s_plane_bsrr[b][1];
+}
+
+static void timer_stop(void) {
+    TIM5->CR1 &= ~TIM_CR1_CEN;
+    TIM5->DIER &= ~TIM_DIER_UIE;
+    TIM5->SR = ~TIM_SR_UIF;
+    s_running = 0;
+}
+
+// Levels changed: pins go static once nothing is in between or moving,
+// otherwise plane stepping (re)starts
+static void apply_levels(void) {
+    uint8_t moving = 0;
+    for(uint8_t i = 0; i < LED_COUNT; i++) {
+        if(s_led[i].mode != LED_STILL) moving = 1;
+    }
+    if(rebuild_planes() && !moving) {
+        if(s_running) timer_stop();
+        write_plane(0);
+    } else if(!s_running) {
+        s_plane = 0;
+        TIM5->ARR = LED_BAM_UNIT_US - 1;
+        TIM5->SR = ~TIM_SR_UIF;
+        TIM5->DIER |= TIM_DIER_UIE;
+        TIM5->EGR = TIM_EGR_UG;         // plane 0 starts in the ISR right away
+        TIM5->CR1 |= TIM_CR1_CEN;
+        s_running = 1;
+    }
+}
+
+/* ============================================================================
+ * Envelopes (once per frame, from the ISR)
+ * ============================================================================ */
+// Move one LED a frame along its fade; returns 1 if it is still moving
+static uint8_t envelope_step(Led_t* l) {
+    if(l->mode == LED_STILL) return 0;
+
+    int32_t next = (int32_t)l->level + l->step;
+    int32_t end = (int32_t)l->target << 16;
+    if((l->step >= 0) ? (next < end) : (next > end)) {
+        l->level = (uint32_t)next;
+        return 1;
+    }
+
+    l->level = (uint32_t)end;
+    if(l->mode == LED_BREATHING) {
+        int32_t rate = (l->step < 0) ? -l->step : l->step;
+        l->target = (l->target == l->hi) ? l->lo : l->hi;
+        l->step = (l->target == l->hi) ? rate : -rate;
+        return 1;
+    }
+    l->mode = LED_STILL;
+    return 0;
+}
+
+static void frame_start(void) {
+    uint8_t moving = 0, fading = 0;
+    for(uint8_t i = 0; i < LED_COUNT; i++) {
+        moving |= envelope_step(&s_led[i]);
+        if(s_led[i].mode == LED_FADING) fading = 1;
+    }
+    if(s_fading && !fading) Power_RequestWake();    // LED_Busy() just went false
+    s_fading = fading;
+    if(!moving) {
+        apply_levels();
+        return;
+    }
+    rebuild_planes();
+}
+
+void TIM5_IRQHandler(void) {
+    PROF_BEGIN(PROF_ISR_TIM5);
+    TIM5->SR = ~TIM_SR_UIF;
+    if(s_running) {
+        uint8_t b = s_plane;
+        if(b == 0) frame_start();
+        if(s_running) {
+            write_plane(b);
+            s_plane = (b + 1) % LED_PLANES;
+            TIM5->ARR = (LED_BAM_UNIT_US << s_plane) - 1;
+        }
+    }
+    PROF_END(PROF_ISR_TIM5);
+}
+
+/* ============================================================================
+ * Public Functions (main loop)
+ * ============================================================================ */
+void LED_Init(void) {
+    RCC->APB1ENR |= RCC_APB1ENR_TIM5EN;
+    LED_ClockChanged();
+    TIM5->ARR = LED_BAM_UNIT_US - 1;
+    TIM5->CR1 = TIM_CR1_ARPE;
+    LED_SetPattern(0);
+}
+
+// Keeps the 1 MHz tick across clock profiles; PSC loads at the next update
+void LED_ClockChanged(void) {
+    TIM5->PSC = SystemClock_GetTIMCLK1() / LED_TICK_HZ - 1;
+}
+
+static uint32_t ms_to_frames(uint32_t ms) {
+    uint32_t frames = ms * 1000u / FRAME_US;
+    return frames ? frames : 1;
+}
+
+// Called with IRQs masked after the envelopes changed
+static void envelopes_changed(void) {
+    uint8_t fading = 0;
+    for(uint8_t i = 0; i < LED_COUNT; i++) {
+        if(s_led[i].mode == LED_FADING) fading = 1;
+    }
+    s_fading = fading;
+    apply_levels();
+}
+
+// Head the selected LEDs for level over frames (0 = jump there)
+static void set_fade(uint8_t mask, uint8_t level, uint32_t frames) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for(uint8_t i = 0; i < LED_COUNT; i++) {
+        if(!(mask & (1u << i))) continue;
+        Led_t* l = &s_led[i];
+        int32_t span = ((int32_t)level << 16) - (int32_t)l->level;
+        l->target = level;
+        if(frames == 0 || span == 0) {
+            l->level = (uint32_t)level << 16;
+            l->mode = LED_STILL;
+        } else {
+            l->step = span / (int32_t)frames;
+            if(l->step == 0) l->step = (span > 0) ? 1 : -1;
+            l->mode = LED_FADING;
+        }
+    }
+    envelopes_changed();
+    __set_PRIMASK(primask);
+}
+
+void LED_SetPattern(uint8_t pattern) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for(uint8_t i = 0; i < LED_COUNT; i++) {
+        s_led[i].level = (pattern & (1u << i)) ? ((uint32_t)LED_FULL << 16) : 0;
+        s_led[i].mode = LED_STILL;
+    }
+    envelopes_changed();
+    __set_PRIMASK(primask);
+}
+
+void LED_SetLevel(uint8_t mask, uint8_t level) {
+    set_fade(mask, level, 0);
+}
+
+void LED_Fade(uint8_t mask, uint8_t level, uint16_t ms) {
+    set_fade(mask, level, ms ? ms_to_frames(ms) : 0);
+}
+
+// Triangle between lo and hi, period_ms per round trip, until the next call;
+// each LED first heads for hi from wherever it is at the same rate
+void LED_Breathe(uint8_t mask, uint8_t lo, uint8_t hi, uint16_t period_ms) {
+    if(lo >= hi) {
+        LED_SetLevel(mask, lo);
+        return;
+    }
+    int32_t rate = (((int32_t)hi - lo) << 16) / (int32_t)ms_to_frames(period_ms / 2);
+    if(rate == 0) rate = 1;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for(uint8_t i = 0; i < LED_COUNT; i++) {
+        if(!(mask & (1u << i))) continue;
+        Led_t* l = &s_led[i];
+        l->lo = lo;
+        l->hi = hi;
+        l->target = hi;
+        l->step = (l->level <= ((uint32_t)hi << 16)) ? rate : -rate;
+        l->mode = LED_BREATHING;
+    }
+    envelopes_changed();
+    __set_PRIMASK(primask);
+}
+
+uint8_t LED_Busy(void) {
+    return s_fading;
+}
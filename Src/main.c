@@ -13,39 +13,70 @@
 #include "oled.h"
 #include "game.h"
 #include "utils.h"
+#include "i2c.h"
+#include "power.h"
+#include "prof.h"
+#include "sound.h"
+#include "led.h"
+#include "rng.h"
+#include "store.h"
+#include "journal.h"
+#include "clock.h"
+#include "ram.h"
 
 /* ============================================================================
  * Main Function
  * ============================================================================ */
 int main(void) {
     // Initialize hardware
-    SystemClock_Config();
+    Clock_Init();
+    Ram_Paint();                        // stack watermark, before anything runs deep
     GPIO_Init();
+    Button_Init();
     USART2_Init();
     SysTick_Config(SystemCoreClock / 1000); // 1ms ticks
+    Cycle_Init();
+    Prof_Init();
+    Journal_Init();
+    Power_Init();
     NVIC_Init();
     ADC_Init();
-    Buzzer_Init();
+    Rng_Init();
+    Sound_Init();
+    LED_Init();
 
     // Initialize OLED display
     oled_init();
     oled_clear();
+    I2C1_SetDoneCallback(Power_RequestWake);    // a drained queue may unblock deferred work
 
     // Mark system as initialized
     g_system_initialized = 1;
+    LOG("[OLED] Boot: %lu transfers, %lu bytes on I2C\r\n",
+              g_i2c_stats.transfers, g_i2c_stats.bytes);
 
     // Start ADC conversions
     ADC_StartConversion();
     Delay_ms(10);
 
+    // Saved speed and high scores (may erase a stale sector)
+    Store_Init();
+
     // Initialize game
     Game_Init();
+    Ram_Report();
 
     // Main loop
     while(1) {
         Monitor_Buttons();
+        Journal_Poll();                 // replayed edges, due ones first
         Monitor_ADC();
         Game_Run();
-        Delay_ms(5);
+        oled_flush();                   // spans a full I2C queue held back
+        Clock_Poll();                   // a requested profile, once I2C is idle
+        Power_Report();
+        Prof_Poll();
+        Ram_Poll();
+        Power_Idle(Journal_Deadline(Game_NextDeadline()));
     }
 }
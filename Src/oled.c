@@ -5,222 +5,375 @@
 
 #include "oled.h"
 #include "game.h"
-
-#define STM32F411xE
-#include "stm32f4xx.h"
+#include "i2c.h"
+#include "prof.h"
+#include "store.h"
+#include "font5x7.h"
+#include <string.h>
 
 /* ============================================================================
- * I2C Low-Level Functions
+ * OLED Command/Data Functions
  * ============================================================================ */
-static void I2C1_Init_OLED(void) {
-    RCC->AHB1ENR |= RCC_AHB1ENR_GPIOBEN;
-
-    // PB8, PB9 AF4, Open-Drain, Pull-Up, High speed
-    GPIOB->MODER &= ~((3u<<(8*2))|(3u<<(9*2)));
-    GPIOB->MODER |=  ((2u<<(8*2))|(2u<<(9*2)));
-    GPIOB->OTYPER |=  (1u<<8)|(1u<<9);
-    GPIOB->OSPEEDR|=  (3u<<(8*2))|(3u<<(9*2));
-    GPIOB->PUPDR  &= ~((3u<<(8*2))|(3u<<(9*2)));
-    GPIOB->PUPDR  |=  ((1u<<(8*2))|(1u<<(9*2)));
-    GPIOB->AFR[1] &= ~((0xFu<<0)|(0xFu<<4));
-    GPIOB->AFR[1] |=  ((4u<<0) |(4u<<4));
-
-    RCC->APB1ENR |= RCC_APB1ENR_I2C1EN;
-    RCC->APB1RSTR |= RCC_APB1RSTR_I2C1RST;
-    RCC->APB1RSTR &= ~RCC_APB1RSTR_I2C1RST;
-
-    I2C1->CR1 = 0;
-    I2C1->CR2 = 42;          // APB1=42MHz
-    I2C1->CCR = 210;         // 100kHz
-    I2C1->TRISE = 43;
-    I2C1->CR1 = I2C_CR1_PE;
-}
+// Power-up sequence, sent as one command run after a single 0x00 control byte
+static const uint8_t OLED_INIT_SEQ[] = {
+    0xAE,               // display off
+    0xD5, 0x80,         // clock divide / oscillator
+    0xA8, 0x3F,         // multiplex 1/64
+    0xD3, 0x00,         // display offset 0
+    0x40,               // start line 0
+    0x8D, 0x14,         // charge pump on
+    0x20, 0x00,         // horizontal addressing
+    0xA1, 0xC8,         // segment remap, COM scan reversed
+    0xDA, 0x12,         // COM pin config
+    0x81, 0x7F,         // contrast
+    0xD9, 0xF1,         // pre-charge period
+    0xDB, 0x40,         // VCOMH level
+    0xA4, 0xA6, 0xAF    // follow RAM, normal polarity, display on
+};
 
-static void i2c_start(uint8_t addr) {
-    I2C1->CR1 |= I2C_CR1_START;
-    while(!(I2C1->SR1 & I2C_SR1_SB));
-    (void)I2C1->SR1;
-    I2C1->DR = addr<<1;
-    while(!(I2C1->SR1 & I2C_SR1_ADDR));
-    (void)I2C1->SR1;
-    (void)I2C1->SR2;
+// Short command runs built on the stack are copied into the I2C queue
+static void oled_cmds(const uint8_t* c, uint8_t n) {
+    I2C1_Write(OLED_ADDR, 0x00, c, n);
 }
 
-static void i2c_w(uint8_t b) {
-    while(!(I2C1->SR1 & I2C_SR1_TXE));
-    I2C1->DR = b;
-    while(!(I2C1->SR1 & I2C_SR1_BTF));
+// p must stay valid until the transfer drains (framebuffer rows, flash)
+static void oled_data(const uint8_t* p, uint16_t n) {
+    I2C1_WriteRef(OLED_ADDR, 0x40, p, n);
 }
 
-static void i2c_stop(void) {
-    I2C1->CR1 |= I2C_CR1_STOP;
+static void oled_setpos(uint8_t page, uint8_t col) {
+    col += OLED_COL_OFFSET;
+    const uint8_t c[3] = {
+        0xB0 | (page & 7),      // page address
+        0x00 | (col & 0x0F),    // column low nibble
+        0x10 | (col >> 4)       // column high nibble
+    };
+    oled_cmds(c, sizeof(c));
 }
 
 /* ============================================================================
- * OLED Command/Data Functions
+ * Framebuffer
+ * The text routines draw into a RAM copy of the panel. Every byte that
+ * actually changes widens that page's dirty column span, and oled_flush()
+ * sends only those spans, so a redraw that leaves most of the screen alone
+ * costs only the changed columns on the wire. The main loop flushes again
+ * on every pass, so spans a full I2C queue held back go out once it drains.
  * ============================================================================ */
-static void oled_cmd(uint8_t c) {
-    i2c_start(OLED_ADDR);
-    i2c_w(0x00);
-    i2c_w(c);
-    i2c_stop();
+static uint8_t s_fb[OLED_PAGES][OLED_WIDTH];
+static uint8_t s_dirty_lo[OLED_PAGES];
+static uint8_t s_dirty_hi[OLED_PAGES];
+static uint8_t s_big_score = OLED_BIG_SCORE;
+static uint8_t s_table_shown = 0;       // high-score table on pages 0..6
+
+static void fb_mark(uint8_t page, uint8_t lo, uint8_t hi) {
+    if(s_dirty_lo[page] > s_dirty_hi[page]) {
+        s_dirty_lo[page] = lo;
+        s_dirty_hi[page] = hi;
+    } else {
+        if(lo < s_dirty_lo[page]) s_dirty_lo[page] = lo;
+        if(hi > s_dirty_hi[page]) s_dirty_hi[page] = hi;
+    }
 }
 
-static void oled_data(const uint8_t* p, uint16_t n) {
-    i2c_start(OLED_ADDR);
-    i2c_w(0x40);
-    while(n--) i2c_w(*p++);
-    i2c_stop();
+static void fb_clean(uint8_t page) {
+    s_dirty_lo[page] = OLED_WIDTH - 1;
+    s_dirty_hi[page] = 0;
 }
 
-static void oled_setpos(uint8_t page, uint8_t col) {
-    col += OLED_COL_OFFSET;
-    oled_cmd(0xB0 | (page & 7));
-    oled_cmd(0x00 | (col & 0x0F));
-    oled_cmd(0x10 | (col >> 4));
+// Blank columns x .. end-1 of a page
+static void fb_clear_span(uint8_t x, uint8_t end, uint8_t page) {
+    if(page >= OLED_PAGES) return;
+    uint8_t* row = s_fb[page];
+    for(; x < end && x < OLED_WIDTH; x++) {
+        if(row[x]) {
+            row[x] = 0;
+            fb_mark(page, x, x);
+        }
+    }
+}
+
+static void fb_clear_to_eol(uint8_t x, uint8_t page) {
+    fb_clear_span(x, OLED_WIDTH, page);
 }
 
 /* ============================================================================
- * Font Data
+ * Column Runs
+ * Text is composed glyph by glyph straight into its framebuffer row, and a
+ * run marks one dirty span however many glyphs it holds. oled_flush() then
+ * sends each page's span as a single data transfer.
  * ============================================================================ */
-static const uint8_t FONT5x7_DIGIT[10][6] = {
-    {0x3E,0x51,0x49,0x45,0x3E,0x00},{0x00,0x42,0x7F,0x40,0x00,0x00},
-    {0x42,0x61,0x51,0x49,0x46,0x00},{0x21,0x41,0x45,0x4B,0x31,0x00},
-    {0x18,0x14,0x12,0x7F,0x10,0x00},{0x27,0x45,0x45,0x45,0x39,0x00},
-    {0x3C,0x4A,0x49,0x49,0x30,0x00},{0x01,0x71,0x09,0x05,0x03,0x00},
-    {0x36,0x49,0x49,0x49,0x36,0x00},{0x06,0x49,0x49,0x29,0x1E,0x00}
-};
+typedef struct {
+    uint8_t* row;
+    uint8_t page;
+    uint8_t x;
+    uint8_t lo, hi;     // changed columns, lo > hi = none
+} Run_t;
+
+static void run_begin(Run_t* r, uint8_t x, uint8_t page) {
+    r->row = s_fb[page];
+    r->page = page;
+    r->x = x;
+    r->lo = OLED_WIDTH;
+    r->hi = 0;
+}
 
-static const uint8_t FONT5x7_LET[26][6] = {
-    /*A*/{0x7E,0x11,0x11,0x11,0x7E,0x00},/*B*/{0x7F,0x49,0x49,0x49,0x36,0x00},
-    /*C*/{0x3E,0x41,0x41,0x41,0x22,0x00},/*D*/{0x7F,0x41,0x41,0x22,0x1C,0x00},
-    /*E*/{0x7F,0x49,0x49,0x49,0x41,0x00},/*F*/{0x7F,0x09,0x09,0x09,0x01,0x00},
-    /*G*/{0x3E,0x41,0x49,0x49,0x7A,0x00},/*H*/{0x7F,0x08,0x08,0x08,0x7F,0x00},
-    /*I*/{0x00,0x41,0x7F,0x41,0x00,0x00},/*J*/{0x20,0x40,0x41,0x3F,0x01,0x00},
-    /*K*/{0x7F,0x08,0x14,0x22,0x41,0x00},/*L*/{0x7F,0x40,0x40,0x40,0x40,0x00},
-    /*M*/{0x7F,0x02,0x0C,0x02,0x7F,0x00},/*N*/{0x7F,0x04,0x08,0x10,0x7F,0x00},
-    /*O*/{0x3E,0x41,0x41,0x41,0x3E,0x00},/*P*/{0x7F,0x09,0x09,0x09,0x06,0x00},
-    /*Q*/{0x3E,0x41,0x51,0x21,0x5E,0x00},/*R*/{0x7F,0x09,0x19,0x29,0x46,0x00},
-    /*S*/{0x46,0x49,0x49,0x49,0x31,0x00},/*T*/{0x01,0x01,0x7F,0x01,0x01,0x00},
-    /*U*/{0x3F,0x40,0x40,0x40,0x3F,0x00},/*V*/{0x1F,0x20,0x40,0x20,0x1F,0x00},
-    /*W*/{0x7F,0x20,0x18,0x20,0x7F,0x00},/*X*/{0x63,0x14,0x08,0x14,0x63,0x00},
-    /*Y*/{0x07,0x08,0x70,0x08,0x07,0x00},/*Z*/{0x61,0x51,0x49,0x45,0x43,0x00}
-};
+// w glyph columns, then gap blank ones, clipped at the right edge
+static void run_put(Run_t* r, const uint8_t* g, uint8_t w, uint8_t gap) {
+    uint8_t x = r->x;
+    for(uint8_t i = 0; i < w + gap && x < OLED_WIDTH; i++, x++) {
+        uint8_t col = (i < w) ? g[i] : 0;
+        if(r->row[x] != col) {
+            r->row[x] = col;
+            if(x < r->lo) r->lo = x;
+            r->hi = x;
+        }
+    }
+    r->x = x;
+}
 
-static const uint8_t FONT5x7_SPACE[6] = {0,0,0,0,0,0};
-static const uint8_t FONT5x7_MINUS[6] = {0x08,0x08,0x08,0x08,0x08,0x00};
+static uint8_t run_end(Run_t* r) {
+    if(r->lo <= r->hi) fb_mark(r->page, r->lo, r->hi);
+    return r->x;
+}
 
 /* ============================================================================
  * Text Drawing Functions
  * ============================================================================ */
-static void oled_draw_digit(uint8_t x, uint8_t page, int d) {
-    if(d >= 0 && d <= 9) {
-        oled_setpos(page, x);
-        oled_data(FONT5x7_DIGIT[d], 6);
+uint8_t oled_text(uint8_t x, uint8_t page, const char* s) {
+    if(page >= OLED_PAGES) return x;
+    Run_t r;
+    run_begin(&r, x, page);
+    for(; *s && r.x < OLED_WIDTH; s++) {
+        uint8_t c = (uint8_t)*s;
+        if(c < FONT5X7_FIRST || c > FONT5X7_LAST) c = ' ';
+#if FONT5X7_PROPORTIONAL
+        run_put(&r, FONT5X7[c - FONT5X7_FIRST], FONT5X7_WIDTH[c - FONT5X7_FIRST], 1);
+#else
+        run_put(&r, FONT5X7[c - FONT5X7_FIRST], FONT5X7_COLS, 1);
+#endif
     }
+    return run_end(&r);
 }
 
-static void oled_draw_letter(uint8_t x, uint8_t page, char c) {
-    const uint8_t* g = FONT5x7_SPACE;
-    if(c >= 'A' && c <= 'Z') g = FONT5x7_LET[c-'A'];
-    else if(c >= '0' && c <= '9') g = FONT5x7_DIGIT[c-'0'];
-    else if(c == '-') g = FONT5x7_MINUS;
-    oled_setpos(page, x);
-    oled_data(g, 6);
+// Decimal digits of v, most significant first; returns the count
+static uint8_t format_uint(char* buf, unsigned v) {
+    char tmp[10];
+    uint8_t n = 0;
+    do {
+        tmp[n++] = '0' + (v % 10);
+        v /= 10;
+    } while(v);
+    for(uint8_t i = 0; i < n; i++) buf[i] = tmp[n - 1 - i];
+    buf[n] = 0;
+    return n;
+}
+
+static uint8_t oled_print_uint(uint8_t x, uint8_t page, unsigned v) {
+    char buf[11];
+    format_uint(buf, v);
+    return oled_text(x, page, buf);
 }
 
-static void oled_print_text(uint8_t x, uint8_t page, const char* s) {
-    while(*s) {
-        char c = (*s >= 'a' && *s <= 'z') ? (*s - 32) : *s;
-        oled_draw_letter(x, page, c);
-        x += 6;
-        s++;
+uint8_t oled_big_uint(uint8_t x, uint8_t page, unsigned v, uint8_t scale) {
+    if(scale < 2) return oled_print_uint(x, page, v);
+    if(scale > 3) scale = 3;
+    char buf[11];
+    uint8_t n = format_uint(buf, v);
+    uint8_t end = x;
+
+    // One run per page row of the digits
+    for(uint8_t p = 0; p < scale && page + p < OLED_PAGES; p++) {
+        Run_t r;
+        run_begin(&r, x, page + p);
+        for(uint8_t i = 0; i < n; i++) {
+            uint8_t d = buf[i] - '0';
+            const uint8_t* g = (scale == 2) ? FONT5X7_DIGIT_X2[d][p] : FONT5X7_DIGIT_X3[d][p];
+            run_put(&r, g, FONT5X7_COLS * scale, scale);
+        }
+        end = run_end(&r);
     }
+    return end;
 }
 
-static void oled_print_uint(uint8_t x, uint8_t page, unsigned v) {
-    char buf[10];
-    int n = 0;
+// Draw a "LABEL value" line and blank whatever the previous frame left behind
+static void oled_print_field(uint8_t page, const char* label, unsigned v) {
+    oled_text(0, page, label);
+    fb_clear_to_eol(oled_print_uint(6*6, page, v), page);
+}
 
-    if(v == 0) {
-        oled_draw_digit(x, page, 0);
-        return;
-    }
+// "RT min/mean/p95ms" from the game's reaction times; returns the column after
+static uint8_t oled_print_reaction(uint8_t page) {
+    uint8_t x = oled_text(0, page, "RT ");
+    x = oled_print_uint(x, page, g_reaction_us.min / 1000);
+    x = oled_text(x, page, "/");
+    x = oled_print_uint(x, page, Stats_Mean(&g_reaction_us) / 1000);
+    x = oled_text(x, page, "/");
+    x = oled_print_uint(x, page, Stats_P95(&g_reaction_us) / 1000);
+    return oled_text(x, page, "ms");
+}
 
-    while(v && n < 10) {
-        buf[n++] = '0' + (v % 10);
-        v /= 10;
+// The speed's high-score table, best first: "TOP SPEED n", then
+// "1. score L level" rows on pages 1..6
+static void oled_print_top_scores(uint8_t speed) {
+    const uint8_t rows = STORE_TOP_N < 6 ? STORE_TOP_N : 6;
+    const StoreScore_t* top = Store_TopScores(speed);
+
+    fb_clear_to_eol(oled_print_uint(oled_text(0, 0, "TOP SPEED "), 0, speed), 0);
+    for(uint8_t i = 0; i < rows; i++) {
+        uint8_t page = 1 + i;
+        uint8_t x = oled_text(oled_print_uint(0, page, i + 1), page, ". ");
+        if(top[i].score) {
+            x = oled_print_uint(x, page, top[i].score);
+            x = oled_print_uint(oled_text(x, page, " L"), page, top[i].level);
+        } else {
+            x = oled_text(x, page, "-");
+        }
+        fb_clear_to_eol(x, page);
+    }
+    for(uint8_t page = 1 + rows; page < 7; page++) {
+        fb_clear_to_eol(0, page);
     }
+}
 
-    for(int i = n - 1; i >= 0; i--, x += 6) {
-        oled_draw_digit(x, page, buf[i] - '0');
+// Large number in columns x .. end-1, blanking the rest of each page row.
+// A number too wide for the span at scale drops a size (10 digits at 3x
+// need 180 columns); the rows it no longer covers are blanked too.
+static void oled_big_field(uint8_t x, uint8_t end, uint8_t page, unsigned v, uint8_t scale) {
+    char buf[11];
+    uint8_t n = format_uint(buf, v);
+    uint8_t fit = scale;
+    while(fit > 1 && n * (FONT5X7_COLS + 1) * fit > end - x) fit--;
+
+    uint8_t right = oled_big_uint(x, page, v, fit);
+    for(uint8_t p = 0; p < scale; p++) {
+        fb_clear_span(p < fit ? right : x, end, page + p);
     }
 }
 
 /* ============================================================================
  * Public Functions
  * ============================================================================ */
+void oled_cmd_list(const uint8_t* cmds, uint16_t n) {
+    I2C1_WriteRef(OLED_ADDR, 0x00, cmds, n);
+}
+
+void oled_set_contrast(uint8_t level) {
+    const uint8_t c[2] = {0x81, level};
+    oled_cmds(c, sizeof(c));
+}
+
+// A span takes two descriptors (position, data). Spans that don't fit stay
+// dirty for the next flush rather than waiting for the queue to drain.
+void oled_flush(void) {
+    for(uint8_t p = 0; p < OLED_PAGES; p++) {
+        uint8_t lo = s_dirty_lo[p];
+        uint8_t hi = s_dirty_hi[p];
+        if(lo > hi) continue;
+        if(I2C1_Free() < 2) return;
+        oled_setpos(p, lo);
+        oled_data(&s_fb[p][lo], (uint16_t)(hi - lo + 1));
+        fb_clean(p);
+    }
+}
+
 void oled_clear(void) {
-    uint8_t z[128] = {0};
-    for(uint8_t p = 0; p < 8; p++) {
-        oled_setpos(p, 0);
-        oled_data(z, 128);
+    for(uint8_t p = 0; p < OLED_PAGES; p++) {
+        fb_clear_to_eol(0, p);
     }
+    oled_flush();
 }
 
 void oled_init(void) {
-    I2C1_Init_OLED();
+    I2C1_Init(OLED_I2C_SPEED);
 
     // Initialization sequence
-    oled_cmd(0xAE); oled_cmd(0xD5); oled_cmd(0x80);
-    oled_cmd(0xA8); oled_cmd(0x3F); oled_cmd(0xD3); oled_cmd(0x00);
-    oled_cmd(0x40); oled_cmd(0x8D); oled_cmd(0x14);
-    oled_cmd(0x20); oled_cmd(0x00); oled_cmd(0xA1); oled_cmd(0xC8);
-    oled_cmd(0xDA); oled_cmd(0x12); oled_cmd(0x81); oled_cmd(0x7F);
-    oled_cmd(0xD9); oled_cmd(0xF1); oled_cmd(0xDB); oled_cmd(0x40);
-    oled_cmd(0xA4); oled_cmd(0xA6); oled_cmd(0xAF);
+    oled_cmd_list(OLED_INIT_SEQ, sizeof(OLED_INIT_SEQ));
+
+    // Panel RAM is undefined after power-up: push the whole blank frame once
+    memset(s_fb, 0, sizeof(s_fb));
+    for(uint8_t p = 0; p < OLED_PAGES; p++) {
+        fb_mark(p, 0, OLED_WIDTH - 1);
+    }
+    oled_flush();
+}
 
-    oled_clear();
+// Switching layouts blanks the framebuffer; the next OLED_ShowStatus() redraws
+void OLED_SetBigScore(uint8_t on) {
+    on = on ? 1 : 0;
+    if(on == s_big_score) return;
+    s_big_score = on;
+    for(uint8_t p = 0; p < OLED_PAGES; p++) {
+        fb_clear_to_eol(0, p);
+    }
 }
 
 void OLED_ShowStatus(void) {
-    oled_clear();
-
-    // LEVEL
-    oled_print_text(0, 0, "LEVEL");
-    oled_print_uint(6*6, 0, g_level);
-
-    // LIVES
-    oled_print_text(0, 2, "LIVES");
-    oled_print_uint(6*6, 2, g_lives);
-
-    // SCORE
-    oled_print_text(0, 4, "SCORE");
-    oled_print_uint(6*6, 4, g_score);
-
-    // DIFF
-    oled_print_text(0, 6, "SPEED");
-    oled_print_uint(6*6, 6, g_difficulty);
-
-    // STATE
-    switch(g_game_state) {
-        case GAME_STATE_VICTORY:
-            oled_print_text(0, 7, "VICTORY");
-            break;
-        case GAME_STATE_GAME_DEATH:
-            oled_print_text(0, 7, "GAME-OVER");
-            break;
-        case GAME_STATE_PATTERN_DISPLAY:
-            oled_print_text(0, 7, "SHOW");
-            break;
-        case GAME_STATE_INPUT_WAIT:
-            oled_print_text(0, 7, "INPUT");
-            break;
-        case GAME_STATE_DIFFICULTY_SELECT:
-            oled_print_text(0, 7, "SPPED-SELECT");
-            break;
-        default:
-            oled_print_text(0, 7, "PLAY");
-            break;
+    PROF_BEGIN(PROF_OLED_STATUS);
+
+    // The status layouts don't redraw every page: blank the table away first
+    uint8_t table = (g_game_state == GAME_STATE_DIFFICULTY_SELECT);
+    if(s_table_shown && !table) {
+        for(uint8_t p = 0; p < OLED_PAGES; p++) {
+            fb_clear_to_eol(0, p);
+        }
+    }
+    s_table_shown = table;
+
+    if(table) {
+        oled_print_top_scores(g_difficulty);
+    } else if(s_big_score) {
+        // LEVEL and LIVES at 2x side by side, SCORE at 3x across the panel
+        fb_clear_span(oled_text(0, 0, "LEVEL"), OLED_WIDTH / 2, 0);
+        fb_clear_to_eol(oled_text(OLED_WIDTH / 2, 0, "LIVES"), 0);
+        oled_big_field(0, OLED_WIDTH / 2, 1, g_level, 2);
+        oled_big_field(OLED_WIDTH / 2, OLED_WIDTH, 1, g_lives, 2);
+
+        fb_clear_span(oled_text(0, 3, "SCORE"), OLED_WIDTH / 2, 3);
+        uint8_t x = oled_text(OLED_WIDTH / 2, 3, "SPEED ");
+        fb_clear_to_eol(oled_print_uint(x, 3, g_difficulty), 3);
+        oled_big_field(0, OLED_WIDTH, 4, g_score, 3);
+    } else {
+        // LEVEL
+        oled_print_field(0, "LEVEL", g_level);
+
+        // LIVES
+        oled_print_field(2, "LIVES", g_lives);
+
+        // SCORE
+        oled_print_field(4, "SCORE", g_score);
+
+        // DIFF
+        oled_print_field(6, "SPEED", g_difficulty);
     }
+
+    // STATE, or the reaction times so far while the next level is introduced
+    if(g_game_state == GAME_STATE_LEVEL_INTRO && g_reaction_us.count) {
+        fb_clear_to_eol(oled_print_reaction(7), 7);
+    } else {
+        const char* label;
+        switch(g_game_state) {
+            case GAME_STATE_VICTORY:
+                label = "VICTORY";
+                break;
+            case GAME_STATE_GAME_DEATH:
+                label = "GAME-OVER";
+                break;
+            case GAME_STATE_PATTERN_DISPLAY:
+                label = "SHOW";
+                break;
+            case GAME_STATE_INPUT_WAIT:
+                label = "INPUT";
+                break;
+            case GAME_STATE_DIFFICULTY_SELECT:
+                label = "SPPED-SELECT";
+                break;
+            default:
+                label = "PLAY";
+                break;
+        }
+        fb_clear_to_eol(oled_text(0, 7, label), 7);
+    }
+
+    oled_flush();
+    PROF_END(PROF_OLED_STATUS);
 }
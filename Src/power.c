@@ -0,0 +1,142 @@
+/* ============================================================================
+ * Idle / Power Management Implementation
+ * Power_Idle() sleeps until an interrupt or the requested tick. Waits longer
+ * than one tick reprogram SysTick to fire once at the deadline instead of
+ * every millisecond, then credit g_tick_counter with the ticks that passed.
+ * ============================================================================ */
+
+#include "power.h"
+#include "config.h"
+#include "utils.h"
+#include "hardware.h"
+
+#define STM32F411xE
+#include "stm32f4xx.h"
+
+/* Global Variables */
+uint32_t g_idle_sleep_cycles = 0;
+
+static uint32_t s_tick_cycles = 0;      // SysTick clocks per 1 ms tick
+static volatile uint8_t s_wake_request = 0;
+static uint32_t s_report_tick = 0;
+static uint32_t s_report_sleep = 0;     // s_slept_us at the last report
+static uint32_t s_slept_us = 0;         // sleep time, the same unit in every clock profile
+static uint32_t s_slept_frac = 0;       // clocks short of the next whole us
+
+/* ============================================================================
+ * Sleep Paths (called with IRQs masked; the wakeup IRQ runs on unmask)
+ * ============================================================================ */
+// Less than a tick away: plain WFI, the next SysTick ends it at the latest
+static uint32_t sleep_one_tick(void) {
+    uint32_t v0 = SysTick->VAL;
+    __DSB();
+    __WFI();
+    uint32_t v1 = SysTick->VAL;
+    // Counting down: a larger value means the counter reloaded once
+    return (v1 <= v0) ? v0 - v1 : v0 + (s_tick_cycles - v1);
+}
+
+// Several ticks away: one long SysTick period up to the deadline
+static uint32_t sleep_tickless(uint32_t ms) {
+    uint32_t ctrl = SysTick->CTRL;
+    SysTick->CTRL = ctrl & ~SysTick_CTRL_ENABLE_Msk;
+
+    uint32_t left = SysTick->VAL;       // clocks until the tick already due
+    uint32_t load = left + (ms - 1) * s_tick_cycles;
+    SysTick->LOAD = load;
+    SysTick->VAL = 0;
+    SysTick->CTRL = ctrl | SysTick_CTRL_ENABLE_Msk;
+
+    __DSB();
+    __WFI();
+
+    ctrl = SysTick->CTRL;               // reading clears COUNTFLAG
+    SysTick->CTRL = ctrl & ~SysTick_CTRL_ENABLE_Msk;
+    uint32_t slept, next;
+
+    if(ctrl & SysTick_CTRL_COUNTFLAG_Msk) {
+        // Ran to the deadline: the pending SysTick IRQ adds the last tick
+        g_tick_counter += ms - 1;
+        slept = load + 1;
+        next = s_tick_cycles;
+    } else {
+        // Another interrupt woke us early: credit whole ticks only
+        slept = load - SysTick->VAL;
+        uint32_t ticks = 0;
+        if(slept >= left) ticks = 1 + (slept - left) / s_tick_cycles;
+        g_tick_counter += ticks;
+        next = s_tick_cycles - ((slept + s_tick_cycles - left) % s_tick_cycles);
+    }
+
+    // Finish the current tick on its original boundary, then 1 ms again
+    SysTick->LOAD = next - 1;
+    SysTick->VAL = 0;
+    SysTick->CTRL = ctrl | SysTick_CTRL_ENABLE_Msk;
+    SysTick->LOAD = s_tick_cycles - 1;
+    return slept;
+}
+
+static void credit_sleep(uint32_t cycles) {
+    uint32_t per_us = s_tick_cycles / 1000;
+    g_idle_sleep_cycles += cycles;
+    s_slept_frac += cycles;
+    s_slept_us += s_slept_frac / per_us;
+    s_slept_frac %= per_us;
+}
+
+/* ============================================================================
+ * Public Functions
+ * ============================================================================ */
+void Power_Init(void) {
+    s_tick_cycles = SysTick->LOAD + 1;
+    s_report_tick = GetTick();
+}
+
+// New core clock: 1 ms ticks at the new rate, starting over from now
+void Power_ClockChanged(void) {
+    s_tick_cycles = SystemCoreClock / 1000;
+    SysTick->LOAD = s_tick_cycles - 1;
+    SysTick->VAL = 0;
+    s_slept_frac = 0;
+}
+
+// Sleep until wake_tick (at most IDLE_MAX_SLEEP_MS away) or until an ISR
+// calls Power_RequestWake(); other interrupts are serviced and we sleep on
+void Power_Idle(uint32_t wake_tick) {
+    uint32_t now = GetTick();
+    if((int32_t)(wake_tick - now) > IDLE_MAX_SLEEP_MS) wake_tick = now + IDLE_MAX_SLEEP_MS;
+
+    for(;;) {
+        int32_t ms = (int32_t)(wake_tick - GetTick());
+        if(ms <= 0 || s_wake_request) break;
+        if((uint32_t)ms > SysTick_LOAD_RELOAD_Msk / s_tick_cycles)
+            ms = SysTick_LOAD_RELOAD_Msk / s_tick_cycles;
+
+        __disable_irq();
+        if(!s_wake_request) credit_sleep((ms == 1) ? sleep_one_tick() : sleep_tickless(ms));
+        __enable_irq();
+    }
+    s_wake_request = 0;
+}
+
+// ISR-safe: end the current Power_Idle() so the main loop runs now
+void Power_RequestWake(void) {
+    s_wake_request = 1;
+}
+
+// Log the active/sleep split every IDLE_REPORT_MS
+void Power_Report(void) {
+    uint32_t now = GetTick();
+    uint32_t window = now - s_report_tick;
+    if(window < IDLE_REPORT_MS) return;
+
+    uint32_t slept = (s_slept_us - s_report_sleep) / 1000;
+    if(slept > window) slept = window;
+    uint32_t active_pm = (window - slept) * 1000 / window;
+
+    LOG("[IDLE] Active %lu.%lu%% (%lu ms busy, %lu ms asleep)\r\n",
+              active_pm / 10, active_pm % 10, window - slept, slept);
+
+    s_report_tick = now;
+    s_report_sleep = s_slept_us;
+}
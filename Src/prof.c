@@ -0,0 +1,129 @@
+/* ============================================================================
+ * Cycle Profiler Implementation
+ * Prof_Record() runs in any context with IRQs masked for the update.
+ * Commands arrive through the USART2 RX interrupt; the dump itself runs in
+ * the main loop from Prof_Poll() and waits for the log ring to drain after
+ * each probe so the output is never dropped.
+ * ============================================================================ */
+
+#include "prof.h"
+
+#if PROF_ENABLE
+#include "hardware.h"
+#include "utils.h"
+#include "power.h"
+#include <stdio.h>
+#include <string.h>
+
+#define STM32F411xE
+#include "stm32f4xx.h"
+
+/* Global Variables */
+ProfStat_t g_prof[PROF_COUNT];
+
+static const char* const PROF_NAMES[PROF_COUNT] = {
+    "BOOT", "DIFFICULTY", "LEVEL_INTRO", "PATTERN", "INPUT_WAIT", "RESULT",
+    "VICTORY", "GAME_DEATH",
+    "OLED_ShowStatus", "Log_Print",
+    "SysTick", "EXTI", "DMA2_S0/ADC", "I2C1_EV", "I2C1_ER", "DMA1_S7/I2C", "USART2",
+    "TIM3/Sound", "TIM5/LED",
+};
+
+static uint32_t s_overhead = 0;         // cycles of an empty begin/end pair
+static volatile uint8_t s_request = 0;  // command byte waiting for Prof_Poll()
+static uint8_t s_paused = 0;            // set while dumping
+
+/* ============================================================================
+ * Recording
+ * ============================================================================ */
+static uint8_t bucket(uint32_t cycles) {
+    uint8_t b = cycles ? (uint8_t)(32 - __builtin_clz(cycles)) : 0;
+    return b < PROF_BUCKETS ? b : PROF_BUCKETS - 1;
+}
+
+void Prof_Record(ProfId_t id, uint32_t cycles) {
+    if(s_paused || id >= PROF_COUNT) return;
+    cycles = cycles > s_overhead ? cycles - s_overhead : 0;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    ProfStat_t* p = &g_prof[id];
+    if(p->count == 0 || cycles < p->min) p->min = cycles;
+    if(cycles > p->max) p->max = cycles;
+    p->count++;
+    p->sum += cycles;
+    p->hist[bucket(cycles)]++;
+    __set_PRIMASK(primask);
+}
+
+void Prof_Reset(void) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memset(g_prof, 0, sizeof(g_prof));
+    __set_PRIMASK(primask);
+}
+
+/* ============================================================================
+ * Commands and Output
+ * ============================================================================ */
+// Calibrate the probe cost and open the RX command channel
+void Prof_Init(void) {
+    uint32_t best = UINT32_MAX;
+    for(uint8_t i = 0; i < 8; i++) {
+        uint32_t t0 = PROF_CYCLES();
+        uint32_t dt = PROF_CYCLES() - t0;
+        if(dt < best) best = dt;
+    }
+    s_overhead = best;
+    Prof_Reset();
+    USART2->CR1 |= USART_CR1_RXNEIE;
+}
+
+// From USART2_IRQHandler(): 'p' dumps, 'r' resets
+void Prof_Command(uint8_t c) {
+    if(c == 'p' || c == 'r') {
+        s_request = c;
+        Power_RequestWake();
+    }
+}
+
+void Prof_Poll(void) {
+    uint8_t c = s_request;
+    if(!c) return;
+    s_request = 0;
+    if(c == 'p') Prof_Dump();
+    else Prof_Reset();
+}
+
+void Prof_Dump(void) {
+    uint32_t per_us = SystemCoreClock / 1000000;
+    s_paused = 1;
+
+    Log_Print("[PROF] %lu MHz, probe cost %lu cycles subtracted\r\n", per_us, s_overhead);
+    Log_Print("[PROF] %-16s %8s %8s %8s %8s  (cycles)\r\n", "probe", "count", "min", "mean", "max");
+    for(uint8_t id = 0; id < PROF_COUNT; id++) {
+        // Copy under the mask so an ISR probe can't tear the line
+        ProfStat_t s;
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        s = g_prof[id];
+        __set_PRIMASK(primask);
+        if(s.count == 0) continue;
+
+        Log_Print("[PROF] %-16s %8lu %8lu %8lu %8lu  max %lu us\r\n", PROF_NAMES[id],
+                  s.count, s.min, (uint32_t)(s.sum / s.count), s.max, s.max / per_us);
+
+        // Histogram: lower bound of each populated log2 bucket
+        char line[200];
+        int n = snprintf(line, sizeof(line), "[PROF]   ");
+        for(uint8_t b = 0; b < PROF_BUCKETS && n < (int)sizeof(line) - 24; b++) {
+            if(!s.hist[b]) continue;
+            n += snprintf(line + n, sizeof(line) - n, " %lu:%lu",
+                          b ? 1ul << (b - 1) : 0ul, (unsigned long)s.hist[b]);
+        }
+        Log_Print("%s\r\n", line);
+        Log_Flush();
+    }
+    s_paused = 0;
+}
+#endif /* PROF_ENABLE */
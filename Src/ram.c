@@ -0,0 +1,84 @@
+/* ============================================================================
+ * RAM Budget Implementation
+ * The section bounds are linker script symbols (STM32F411RETX_FLASH.ld):
+ *   _sdata  .data  _edata  _sbss  .bss  _ebss = _end  heap ->   <- stack  _estack
+ * The painted span runs from the heap's high-water mark to just below the
+ * stack pointer main() started with. A scan only covers the words below
+ * the deepest one already found written, so repeated reports stay cheap.
+ * A stack that grows past the painted span into the heap or .bss can't be
+ * told apart from it; the report flags a peak over the linker's reserve.
+ * ============================================================================ */
+
+#include "ram.h"
+#include "utils.h"
+#include "power.h"
+
+#define STM32F411xE
+#include "stm32f4xx.h"
+
+#define PAINT           0xC5C5C5C5u
+#define PAINT_GUARD     32              /* bytes left alone below the live SP */
+
+extern uint8_t _sdata, _edata, _sbss, _ebss, _end, _estack;
+extern uint8_t _Min_Heap_Size, _Min_Stack_Size;     // absolute symbols: the address is the value
+
+static uint32_t* s_deepest;             // lowest word the stack is known to have written
+static volatile uint8_t s_request = 0;  // 'm' waiting for Ram_Poll()
+
+// First word above everything _sbrk() has handed out
+static uint32_t* heap_top(void) {
+    uintptr_t top = (uintptr_t)&_end + _sbrk_high_water();
+    return (uint32_t*)((top + 3) & ~(uintptr_t)3);
+}
+
+/* ============================================================================
+ * Stack Watermark
+ * ============================================================================ */
+void Ram_Paint(void) {
+    uint32_t* p = heap_top();
+    uint32_t* top = (uint32_t*)(uintptr_t)((__get_MSP() - PAINT_GUARD) & ~3u);
+    s_deepest = top;
+    while(p < top) *p++ = PAINT;
+}
+
+uint32_t Ram_StackPeak(void) {
+    uint32_t* p = heap_top();
+    while(p < s_deepest && *p == PAINT) p++;
+    if(p < s_deepest) s_deepest = p;
+    return (uint32_t)((uintptr_t)&_estack - (uintptr_t)s_deepest);
+}
+
+/* ============================================================================
+ * Report
+ * ============================================================================ */
+void Ram_Report(void) {
+    uint32_t data = (uint32_t)(&_edata - &_sdata);
+    uint32_t bss = (uint32_t)(&_ebss - &_sbss);
+    uint32_t heap = (uint32_t)_sbrk_high_water();
+    uint32_t stack = Ram_StackPeak();
+    uint32_t heap_reserve = (uint32_t)(uintptr_t)&_Min_Heap_Size;
+    uint32_t stack_reserve = (uint32_t)(uintptr_t)&_Min_Stack_Size;
+    uint32_t* bottom = heap_top();
+    uint32_t untouched = s_deepest > bottom ? (uint32_t)(s_deepest - bottom) * 4 : 0;
+
+    LOG("[RAM] %lu B: data %lu, bss %lu, heap peak %lu, stack peak %lu\r\n",
+        (uint32_t)(&_estack - &_sdata), data, bss, heap, stack);
+    LOG("[RAM] %lu B never touched; linker reserve heap %lu, stack %lu\r\n",
+        untouched, heap_reserve, stack_reserve);
+    // The link only fails when .data + .bss + the reserves don't fit
+    if(heap > heap_reserve || stack > stack_reserve)
+        LOG("[RAM] Peak over the linker reserve: raise _Min_Heap_Size/_Min_Stack_Size\r\n");
+}
+
+void Ram_Command(uint8_t c) {
+    if(c == 'm') {
+        s_request = c;
+        Power_RequestWake();
+    }
+}
+
+void Ram_Poll(void) {
+    if(!s_request) return;
+    s_request = 0;
+    Ram_Report();
+}
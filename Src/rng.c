@@ -0,0 +1,115 @@
+/* ============================================================================
+ * Random Numbers Implementation
+ * The pool is a 32-bit multiply-rotate hash, updated from ISRs with
+ * interrupts masked. Draws never touch it: the generator only changes by
+ * Rng_Stir() or Rng_Seed(), so a sequence between two stirs depends on the
+ * state alone. Rng_Bits() hands out the top bits of each output a few at a
+ * time, so a 2-bit draw costs a generator step every 16 calls.
+ * ============================================================================ */
+
+#include "rng.h"
+#include "hardware.h"
+
+#define STM32F411xE
+#include "stm32f4xx.h"
+
+#define ADC_SCAN_LEN    3       /* samples per scan: POT, TEMP, LIGHT */
+#define ADC_CH_TEMP     1
+#define ADC_CH_LIGHT    2
+
+static uint32_t s_state[4];
+static uint32_t s_pool = 0;
+static uint8_t s_fixed = 0;             // RNG_FIXED_SEED: ignore the pool
+static uint32_t s_bits = 0;             // unused output bits, top first
+static uint8_t s_bits_left = 0;
+
+static uint32_t rotl(uint32_t x, uint8_t k) {
+    return (x << k) | (x >> (32 - k));
+}
+
+// SplitMix32 step, spreads a seed over the state words
+static uint32_t splitmix(uint32_t* x) {
+    uint32_t z = (*x += 0x9E3779B9u);
+    z = (z ^ (z >> 16)) * 0x85EBCA6Bu;
+    z = (z ^ (z >> 13)) * 0xC2B2AE35u;
+    return z ^ (z >> 16);
+}
+
+/* ============================================================================
+ * Entropy Pool
+ * ============================================================================ */
+void Rng_AddEntropy(uint32_t x) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    s_pool = rotl(s_pool ^ x, 13) * 0x9E3779B1u;
+    __set_PRIMASK(primask);
+}
+
+// From the ADC DMA ISR: the noisy low nibbles of TEMP and LIGHT, per scan
+static void adc_block(const uint16_t* scans, uint8_t count) {
+    uint32_t x = 0;
+    for(uint8_t s = 0; s < count; s++) {
+        const uint16_t* scan = &scans[s * ADC_SCAN_LEN];
+        x = rotl(x, 8) ^ ((scan[ADC_CH_TEMP] & 0xFu) << 4) ^ (scan[ADC_CH_LIGHT] & 0xFu);
+    }
+    Rng_AddEntropy(x);
+}
+
+/* ============================================================================
+ * Generator
+ * ============================================================================ */
+void Rng_Init(void) {
+#if RNG_FIXED_SEED
+    Rng_Seed(RNG_FIXED_SEED);
+    s_fixed = 1;
+#else
+    uint32_t x = 1;
+    for(uint8_t i = 0; i < 4; i++) s_state[i] = splitmix(&x);
+#endif
+    ADC_SetBlockCallback(adc_block);
+}
+
+void Rng_Seed(uint32_t seed) {
+    for(uint8_t i = 0; i < 4; i++) s_state[i] = splitmix(&seed);
+    s_bits_left = 0;
+}
+
+uint32_t Rng_Stir(void) {
+    if(s_fixed) return 0;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t pool = s_pool;
+    __set_PRIMASK(primask);
+
+    uint32_t x = pool;
+    for(uint8_t i = 0; i < 4; i++) s_state[i] ^= splitmix(&x);
+    if(!(s_state[0] | s_state[1] | s_state[2] | s_state[3])) s_state[0] = 1;
+    s_bits_left = 0;
+    return pool;
+}
+
+// xoshiro128**
+uint32_t Rng_Next(void) {
+    uint32_t* s = s_state;
+    uint32_t result = rotl(s[1] * 5, 7) * 9;
+    uint32_t t = s[1] << 9;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 11);
+    return result;
+}
+
+uint8_t Rng_Bits(uint8_t n) {
+    if(n == 0 || n > 8) return 0;
+    if(s_bits_left < n) {
+        s_bits = Rng_Next();
+        s_bits_left = 32;
+    }
+    uint8_t v = (uint8_t)(s_bits >> (32 - n));
+    s_bits <<= n;
+    s_bits_left -= n;
+    return v;
+}
@@ -0,0 +1,174 @@
+/* ============================================================================
+ * Buzzer / Sound Sequencer Implementation
+ * ARR and CCR4 are preloaded, so a note written during one PWM period takes
+ * over cleanly at the next update event. The update ISR counts down the
+ * periods of the sounding note and, during its last one, writes the next
+ * note (or silence). s_left is the number of update events the current note
+ * has left and is set to its period count when it is written.
+ * ============================================================================ */
+
+#include "sound.h"
+#include "hardware.h"
+#include "power.h"
+#include "prof.h"
+
+#define STM32F411xE
+#include "stm32f4xx.h"
+
+#define BUZZER_PORT     GPIOC
+#define BUZZER_PIN      9
+#define BUZZER_TICK_HZ  1000000u                        /* TIM3 counter clock */
+#define REST_ARR        (BUZZER_TICK_HZ / 1000 - 1)     /* rests count 1 ms periods */
+
+/* Effect Queue: the main loop adds at head, the ISR takes from tail; both
+ * change it only with TIM3 unable to interrupt */
+static const Sound_t* s_queue[SOUND_QUEUE_LEN];
+static uint8_t s_q_head = 0;
+static uint8_t s_q_tail = 0;
+
+static const Sound_t* s_cur = 0;        // effect whose note was written last, 0 = none
+static uint8_t s_note = 0;
+static uint32_t s_left = 0;             // update events until the next note is due
+static uint8_t s_silent = 1;            // silence written, nothing left to play
+static volatile uint8_t s_active = 0;   // update interrupt running
+
+/* ============================================================================
+ * Timer
+ * ============================================================================ */
+void Sound_Init(void) {
+    RCC->AHB1ENR |= RCC_AHB1ENR_GPIOCEN;  // เปิด clock ของพอร์ต C
+    RCC->APB1ENR |= RCC_APB1ENR_TIM3EN;   // ใช้ TIM3 เหมือนเดิม
+
+    // PC9 -> AF2 (TIM3_CH4)
+    GPIOC->MODER &= ~(3u << (BUZZER_PIN * 2));
+    GPIOC->MODER |=  (2u << (BUZZER_PIN * 2));    // Alternate function
+    GPIOC->AFR[1] &= ~(0xFu << ((BUZZER_PIN - 8) * 4));
+    GPIOC->AFR[1] |=  (2u   << ((BUZZER_PIN - 8) * 4)); // AF2 = TIM3
+
+    // ตั้งค่า Timer3 channel 4 เป็น PWM
+    Sound_ClockChanged();
+    TIM3->ARR  = REST_ARR;  // ค่าเริ่มต้น ~1kHz
+    TIM3->CCR4 = 0;         // duty 0% (เงียบ)
+
+    TIM3->CCMR2 &= ~(7u << 12);          // เคลียร์ OC4M
+    TIM3->CCMR2 |=  (6u << 12);          // PWM mode 1
+    TIM3->CCMR2 |=  TIM_CCMR2_OC4PE;     // preload enable
+
+    TIM3->CCER  |=  TIM_CCER_CC4E;       // เปิด channel 4 output
+    TIM3->CR1   |=  TIM_CR1_ARPE | TIM_CR1_CEN;
+}
+
+// Keeps the 1 MHz tick across clock profiles; PSC loads at the next update
+void Sound_ClockChanged(void) {
+    TIM3->PSC = SystemClock_GetTIMCLK1() / BUZZER_TICK_HZ - 1;
+}
+
+// Preload one note (0 = silence); returns how many periods it lasts
+static uint32_t buzzer_load(const Note_t* n) {
+    uint32_t arr = REST_ARR, ccr = 0;
+    if(n && n->freq_hz) {
+        arr = BUZZER_TICK_HZ / n->freq_hz - 1;
+        if(arr > 65535) arr = 65535;
+        ccr = (arr + 1) * n->duty / 100;
+    }
+    TIM3->ARR = arr;
+    TIM3->CCR4 = ccr;
+    if(!n) return 1;
+
+    uint32_t periods = (uint32_t)n->ms * (BUZZER_TICK_HZ / 1000) / (arr + 1);
+    return periods ? periods : 1;
+}
+
+/* ============================================================================
+ * Sequencer
+ * ============================================================================ */
+// Move to the next note, taking the next queued effect when this one ends
+static uint8_t next_note(void) {
+    if(s_cur && ++s_note < s_cur->count) return 1;
+    s_cur = 0;
+    while(s_q_tail != s_q_head) {
+        const Sound_t* s = s_queue[s_q_tail++ % SOUND_QUEUE_LEN];
+        if(s->count == 0) continue;
+        s_cur = s;
+        s_note = 0;
+        return 1;
+    }
+    return 0;
+}
+
+// Write whatever comes next; called during the last period of the current note
+static void sequence_step(void) {
+    if(next_note()) {
+        s_left = buzzer_load(&s_cur->notes[s_note]);
+        s_silent = 0;
+    } else if(!s_silent) {
+        s_left = buzzer_load(0);
+        s_silent = 1;
+    } else {
+        // Silence is sounding and nothing is queued: stop interrupting
+        TIM3->DIER &= ~TIM_DIER_UIE;
+        s_active = 0;
+        Power_RequestWake();
+    }
+}
+
+void TIM3_IRQHandler(void) {
+    PROF_BEGIN(PROF_ISR_TIM3);
+    TIM3->SR = ~TIM_SR_UIF;
+    if(s_left && --s_left == 0) sequence_step();
+    PROF_END(PROF_ISR_TIM3);
+}
+
+/* ============================================================================
+ * Public Functions (main loop)
+ * ============================================================================ */
+uint8_t Sound_Play(const Sound_t* s) {
+    if(s->count == 0) return 1;
+    uint8_t ok = 1;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint8_t current = s_cur ? s_cur->priority : 0;
+    if(s_active && s->priority > current) {
+        // Preempt: the new effect starts at the next period boundary
+        s_q_tail = s_q_head;
+        s_cur = 0;
+    }
+    if((uint8_t)(s_q_head - s_q_tail) < SOUND_QUEUE_LEN) {
+        s_queue[s_q_head++ % SOUND_QUEUE_LEN] = s;
+    } else {
+        ok = 0;
+    }
+
+    if(!s_active) {
+        // Idle and silent: restart the counter so the first note begins now
+        s_silent = 1;
+        sequence_step();
+        TIM3->EGR = TIM_EGR_UG;
+        TIM3->SR = ~TIM_SR_UIF;         // set by the UG, not by a period ending
+        TIM3->DIER |= TIM_DIER_UIE;
+        s_active = 1;
+    } else if(!s_cur) {
+        sequence_step();
+    }
+
+    __set_PRIMASK(primask);
+    return ok;
+}
+
+// Silence from the next period boundary and drop everything queued
+void Sound_Stop(void) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    s_q_tail = s_q_head;
+    s_cur = 0;
+    if(s_active) {
+        s_silent = 0;
+        sequence_step();
+    }
+    __set_PRIMASK(primask);
+}
+
+uint8_t Sound_Busy(void) {
+    return s_active;
+}
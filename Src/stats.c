@@ -0,0 +1,100 @@
+/* ============================================================================
+ * Streaming Statistics Implementation
+ * Markers 0 and 4 track the minimum and maximum, marker 2 the 95th
+ * percentile and markers 1 and 3 the points halfway to either end. A marker
+ * that drifts a whole position from where it should be moves one position
+ * over, its height taken from a parabola through it and its neighbours, or
+ * linearly when the parabola would leave their range. Single precision
+ * runs on the FPU.
+ * ============================================================================ */
+
+#include "stats.h"
+
+#define P95     0.95f
+
+static const float STEP[5] = { 0.0f, P95 / 2, P95, (1.0f + P95) / 2, 1.0f };
+
+void Stats_Reset(Stats_t* s) {
+    s->count = 0;
+    s->min = UINT32_MAX;
+    s->sum = 0;
+}
+
+static float parabolic(const Stats_t* s, uint8_t i, int32_t d) {
+    float below = (float)(s->n[i] - s->n[i - 1]);
+    float above = (float)(s->n[i + 1] - s->n[i]);
+    return s->q[i] + (float)d / (float)(s->n[i + 1] - s->n[i - 1]) *
+           ((below + d) * (s->q[i + 1] - s->q[i]) / above +
+            (above - d) * (s->q[i] - s->q[i - 1]) / below);
+}
+
+void Stats_Add(Stats_t* s, uint32_t x) {
+    float v = (float)x;
+    s->sum += x;
+    if(x < s->min) s->min = x;
+
+    // First five: keep them sorted, they seed the markers
+    if(s->count < 5) {
+        uint8_t i = (uint8_t)s->count++;
+        while(i > 0 && s->q[i - 1] > v) {
+            s->q[i] = s->q[i - 1];
+            i--;
+        }
+        s->q[i] = v;
+        if(s->count == 5) {
+            for(uint8_t k = 0; k < 5; k++) {
+                s->n[k] = k + 1;
+                s->want[k] = 1.0f + 4.0f * STEP[k];
+            }
+        }
+        return;
+    }
+    s->count++;
+
+    // Cell the sample falls in; the end markers stretch to hold it
+    uint8_t k;
+    if(v < s->q[0]) {
+        s->q[0] = v;
+        k = 0;
+    } else if(v >= s->q[4]) {
+        s->q[4] = v;
+        k = 3;
+    } else {
+        k = 0;
+        while(v >= s->q[k + 1]) k++;
+    }
+    for(uint8_t i = k + 1; i < 5; i++) s->n[i]++;
+    for(uint8_t i = 0; i < 5; i++) s->want[i] += STEP[i];
+
+    for(uint8_t i = 1; i < 4; i++) {
+        float off = s->want[i] - (float)s->n[i];
+        if((off >= 1.0f && s->n[i + 1] - s->n[i] > 1) ||
+           (off <= -1.0f && s->n[i - 1] - s->n[i] < -1)) {
+            int32_t d = off > 0 ? 1 : -1;
+            float h = parabolic(s, i, d);
+            if(h <= s->q[i - 1] || h >= s->q[i + 1]) {
+                h = s->q[i] + (float)d * (s->q[i + d] - s->q[i]) / (float)(s->n[i + d] - s->n[i]);
+            }
+            s->q[i] = h;
+            s->n[i] += d;
+        }
+    }
+}
+
+uint32_t Stats_Mean(const Stats_t* s) {
+    return s->count ? (uint32_t)(s->sum / s->count) : 0;
+}
+
+uint32_t Stats_P95(const Stats_t* s) {
+    if(s->count == 0) return 0;
+    if(s->count <= 5) return (uint32_t)s->q[s->count - 1];  // nearest rank is the largest
+
+    // Marker 2 trails its desired position while the stream is short; read
+    // the height there off the line through the markers around it
+    float want = s->want[2];
+    uint8_t i = 0;
+    while(i < 3 && (float)s->n[i + 1] < want) i++;
+    float h = s->q[i] + (s->q[i + 1] - s->q[i]) * (want - (float)s->n[i]) /
+              (float)(s->n[i + 1] - s->n[i]);
+    return (uint32_t)(h + 0.5f);
+}
@@ -0,0 +1,303 @@
+/* ============================================================================
+ * Persistent Store Implementation
+ * Each sector starts with a header record (slot 0) holding its generation;
+ * the valid header with the newest generation marks the active sector.
+ * Records fill the following slots in order, so the first blank slot is
+ * the append point. Flash is programmed 32 bits at a time (2.7-3.6 V).
+ *
+ * Compaction writes the live records (saved speed, high-score tables) to
+ * the erased spare and its header last, so a reset part way leaves the
+ * old sector in charge. The now stale sector is erased by the next
+ * Store_Maintain(), which keeps a blocking erase off the append path.
+ * While an erase or a word program runs, any fetch from flash stalls the
+ * core, interrupts included.
+ * ============================================================================ */
+
+#include <stddef.h>
+#include "store.h"
+#include "hardware.h"
+#include "utils.h"
+
+#define STM32F411xE
+#include "stm32f4xx.h"
+
+#define STORE_FIRST_SECTOR  6                       /* flash sector at _sstore */
+#define STORE_SECTORS       2
+#define STORE_SECTOR_BYTES  (128u * 1024u)
+#define STORE_SLOTS         (STORE_SECTOR_BYTES / sizeof(StoreRecord_t))
+#define STORE_COMPACT_AT    (STORE_SLOTS * STORE_COMPACT_PERCENT / 100)
+#define STORE_MAGIC         0x53494D4Eu             /* "SIMN" */
+
+#define FLASH_KEY1          0x45670123u
+#define FLASH_KEY2          0xCDEF89ABu
+#define FLASH_SR_ERRORS     (FLASH_SR_WRPERR | FLASH_SR_PGAERR | FLASH_SR_PGPERR | FLASH_SR_PGSERR)
+
+typedef enum {
+    TAG_HEADER = 0x01,      // value = generation, extra = STORE_MAGIC
+    TAG_SPEED  = 0x02,      // value = speed
+    TAG_SCORE  = 0x03       // key = speed, value = score, extra = level
+} StoreTag_t;
+
+typedef struct {
+    uint8_t tag;
+    uint8_t key;
+    uint16_t reserved;
+    uint32_t value;
+    uint32_t extra;
+    uint32_t crc;           // CRC-32 of the 12 bytes above
+} StoreRecord_t;
+
+extern uint32_t _sstore[];  // linker script: start of the STORE region
+
+static StoreScore_t s_top[STORE_SPEEDS][STORE_TOP_N];
+static uint8_t s_speed = 0;
+static uint8_t s_active = 0;            // sector index holding the live log
+static uint32_t s_generation = 0;
+static uint16_t s_next = 1;             // first blank slot of the active sector
+static uint8_t s_spare_dirty = 0;       // other sector needs an erase
+
+/* ============================================================================
+ * Records
+ * ============================================================================ */
+static uint32_t crc32(const uint8_t* p, uint32_t n) {
+    static const uint32_t T[16] = {
+        0x00000000u, 0x1DB71064u, 0x3B6E20C8u, 0x26D930ACu, 0x76DC4190u, 0x6B6B51F4u,
+        0x4DB26158u, 0x5005713Cu, 0xEDB88320u, 0xF00F9344u, 0xD6D6A3E8u, 0xCB61B38Cu,
+        0x9B64C2B0u, 0x86D3D2D4u, 0xA00AE278u, 0xBDBDF21Cu
+    };
+    uint32_t c = 0xFFFFFFFFu;
+    while(n--) {
+        c ^= *p++;
+        c = (c >> 4) ^ T[c & 15];
+        c = (c >> 4) ^ T[c & 15];
+    }
+    return ~c;
+}
+
+static const StoreRecord_t* slot(uint8_t sector, uint16_t i) {
+    const uint8_t* base = (const uint8_t*)_sstore + (uint32_t)sector * STORE_SECTOR_BYTES;
+    return (const StoreRecord_t*)base + i;
+}
+
+static uint8_t record_blank(const StoreRecord_t* r) {
+    const uint32_t* w = (const uint32_t*)r;
+    return (w[0] & w[1] & w[2] & w[3]) == 0xFFFFFFFFu;
+}
+
+static uint8_t record_valid(const StoreRecord_t* r) {
+    return r->crc == crc32((const uint8_t*)r, offsetof(StoreRecord_t, crc));
+}
+
+static uint8_t header_valid(uint8_t sector) {
+    const StoreRecord_t* h = slot(sector, 0);
+    return h->tag == TAG_HEADER && h->extra == STORE_MAGIC && record_valid(h);
+}
+
+static uint8_t sector_blank(uint8_t sector) {
+    const uint32_t* w = (const uint32_t*)slot(sector, 0);
+    for(uint32_t i = 0; i < STORE_SECTOR_BYTES / 4; i++) {
+        if(w[i] != 0xFFFFFFFFu) return 0;
+    }
+    return 1;
+}
+
+/* ============================================================================
+ * Flash Programming
+ * ============================================================================ */
+static void flash_wait(void) {
+    while(FLASH->SR & FLASH_SR_BSY);
+}
+
+static void flash_unlock(void) {
+    if(FLASH->CR & FLASH_CR_LOCK) {
+        FLASH->KEYR = FLASH_KEY1;
+        FLASH->KEYR = FLASH_KEY2;
+    }
+    flash_wait();
+    FLASH->SR = FLASH_SR_EOP | FLASH_SR_ERRORS;
+}
+
+// The data cache may still hold what a sector read before it changed
+static void flash_done(void) {
+    FLASH->CR = FLASH_CR_LOCK;
+    if(FLASH->ACR & FLASH_ACR_DCEN) {
+        FLASH->ACR &= ~FLASH_ACR_DCEN;
+        FLASH->ACR |= FLASH_ACR_DCRST;
+        FLASH->ACR &= ~FLASH_ACR_DCRST;
+        FLASH->ACR |= FLASH_ACR_DCEN;
+    }
+}
+
+static void flash_erase(uint8_t sector) {
+    flash_unlock();
+    FLASH->CR = FLASH_CR_PSIZE_1 | FLASH_CR_SER |
+                ((uint32_t)(STORE_FIRST_SECTOR + sector) << FLASH_CR_SNB_Pos);
+    FLASH->CR |= FLASH_CR_STRT;
+    flash_wait();
+    flash_done();
+}
+
+// Returns 1 if every word reads back as written
+static uint8_t flash_program(uint8_t sector, uint16_t i, const StoreRecord_t* r) {
+    volatile uint32_t* dst = (volatile uint32_t*)slot(sector, i);
+    const uint32_t* src = (const uint32_t*)r;
+    uint8_t ok = 1;
+
+    flash_unlock();
+    FLASH->CR = FLASH_CR_PSIZE_1 | FLASH_CR_PG;
+    for(uint8_t k = 0; k < sizeof(StoreRecord_t) / 4 && ok; k++) {
+        dst[k] = src[k];
+        flash_wait();
+        if((FLASH->SR & FLASH_SR_ERRORS) || dst[k] != src[k]) ok = 0;
+    }
+    flash_done();
+    return ok;
+}
+
+static uint8_t write_record(uint8_t sector, uint16_t i, uint8_t tag, uint8_t key,
+                            uint32_t value, uint32_t extra) {
+    StoreRecord_t r = { tag, key, 0xFFFF, value, extra, 0 };
+    r.crc = crc32((const uint8_t*)&r, offsetof(StoreRecord_t, crc));
+    return flash_program(sector, i, &r);
+}
+
+/* ============================================================================
+ * Index
+ * ============================================================================ */
+// Ties rank below the entries already there
+static uint8_t insert_score(uint8_t speed, uint32_t score, uint16_t level) {
+    if(speed < 1 || speed > STORE_SPEEDS || score == 0) return 0;
+    StoreScore_t* t = s_top[speed - 1];
+    uint8_t r = STORE_TOP_N;
+    while(r > 0 && score > t[r - 1].score) r--;
+    if(r == STORE_TOP_N) return 0;
+    for(uint8_t k = STORE_TOP_N - 1; k > r; k--) t[k] = t[k - 1];
+    t[r].score = score;
+    t[r].level = level;
+    return r + 1;
+}
+
+static void apply(const StoreRecord_t* r) {
+    switch(r->tag) {
+        case TAG_SPEED:
+            if(r->value >= 1 && r->value <= STORE_SPEEDS) s_speed = (uint8_t)r->value;
+            break;
+        case TAG_SCORE:
+            insert_score(r->key, r->value, (uint16_t)r->extra);
+            break;
+        default:
+            break;
+    }
+}
+
+// One pass over the active sector up to its first blank slot; returns the
+// number of records that failed their CRC
+static uint16_t build_index(void) {
+    uint16_t bad = 0;
+    uint16_t i = 1;
+    for(; i < STORE_SLOTS; i++) {
+        const StoreRecord_t* r = slot(s_active, i);
+        if(record_blank(r)) break;
+        if(record_valid(r)) apply(r);
+        else bad++;
+    }
+    s_next = i;
+    return bad;
+}
+
+/* ============================================================================
+ * Log Maintenance
+ * ============================================================================ */
+// Start the log over in sector with what the index holds, header last
+static void rewrite(uint8_t sector) {
+    uint16_t i = 1;
+    if(s_speed) write_record(sector, i++, TAG_SPEED, 0, s_speed, 0);
+    for(uint8_t d = 0; d < STORE_SPEEDS; d++) {
+        for(uint8_t k = 0; k < STORE_TOP_N && s_top[d][k].score; k++) {
+            write_record(sector, i++, TAG_SCORE, d + 1, s_top[d][k].score, s_top[d][k].level);
+        }
+    }
+    write_record(sector, 0, TAG_HEADER, 0, s_generation + 1, STORE_MAGIC);
+    s_generation++;
+    s_active = sector;
+    s_next = i;
+}
+
+static void compact(void) {
+    uint8_t spare = s_active ^ 1;
+    if(s_spare_dirty) flash_erase(spare);   // Store_Maintain() didn't get to it
+    rewrite(spare);
+    s_spare_dirty = 1;
+    LOG("[STORE] Compacted into sector %u: %u records\r\n",
+        STORE_FIRST_SECTOR + s_active, s_next - 1);
+}
+
+// Callers update the index first: a compaction writes it out in full
+static void append(uint8_t tag, uint8_t key, uint32_t value, uint32_t extra) {
+    while(s_next < STORE_SLOTS) {
+        if(write_record(s_active, s_next++, tag, key, value, extra)) return;
+    }
+    compact();
+}
+
+/* ============================================================================
+ * Public Functions
+ * ============================================================================ */
+void Store_Init(void) {
+    uint32_t t0 = Cycle_Now();
+    uint8_t valid[STORE_SECTORS];
+    for(uint8_t s = 0; s < STORE_SECTORS; s++) valid[s] = header_valid(s);
+
+    if(!valid[0] && !valid[1]) {
+        // First boot, or nothing readable: start an empty log in sector 0
+        if(!sector_blank(0)) flash_erase(0);
+        s_generation = 0;
+        rewrite(0);
+        LOG("[STORE] Formatted sector %u\r\n", STORE_FIRST_SECTOR);
+    } else {
+        s_active = valid[1] && (!valid[0] ||
+                   (int32_t)(slot(1, 0)->value - slot(0, 0)->value) > 0);
+        s_generation = slot(s_active, 0)->value;
+        uint16_t bad = build_index();
+        LOG("[STORE] Sector %u gen %lu: %u records (%u bad) indexed in %lu us\r\n",
+            STORE_FIRST_SECTOR + s_active, s_generation, s_next - 1, bad,
+            (Cycle_Now() - t0) / (SystemCoreClock / 1000000));
+    }
+    s_spare_dirty = !sector_blank(s_active ^ 1);
+    Store_Maintain();
+
+    for(uint8_t d = 0; d < STORE_SPEEDS; d++) {
+        if(s_top[d][0].score) LOG("[STORE] Speed %u best: %lu (level %u)\r\n",
+                                  d + 1, s_top[d][0].score, s_top[d][0].level);
+    }
+}
+
+// Blocking: compacts a nearly full log and erases the stale sector
+void Store_Maintain(void) {
+    if(s_next >= STORE_COMPACT_AT) compact();
+    if(s_spare_dirty) {
+        flash_erase(s_active ^ 1);
+        s_spare_dirty = 0;
+    }
+}
+
+uint8_t Store_GetSpeed(void) {
+    return s_speed;
+}
+
+void Store_SetSpeed(uint8_t speed) {
+    if(speed == s_speed || speed < 1 || speed > STORE_SPEEDS) return;
+    s_speed = speed;
+    append(TAG_SPEED, 0, speed, 0);
+}
+
+uint8_t Store_AddScore(uint8_t speed, uint32_t score, uint16_t level) {
+    uint8_t rank = insert_score(speed, score, level);
+    if(rank) append(TAG_SCORE, speed, score, level);
+    return rank;
+}
+
+const StoreScore_t* Store_TopScores(uint8_t speed) {
+    if(speed < 1 || speed > STORE_SPEEDS) speed = 1;
+    return s_top[speed - 1];
+}
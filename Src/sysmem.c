@@ -22,6 +22,7 @@
 
 /* Includes */
 #include <errno.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /**
@@ -29,6 +30,11 @@
  */
 static uint8_t *__sbrk_heap_end = NULL;
 
+/**
+ * Highest heap end handed out so far; free() never lowers it
+ */
+static uint8_t *__sbrk_heap_peak = NULL;
+
 /**
  * @brief _sbrk() allocates memory to the newlib heap and is used by malloc
  *        and others from the C library
@@ -74,6 +80,23 @@ void *_sbrk(ptrdiff_t incr)
 
   prev_heap_end = __sbrk_heap_end;
   __sbrk_heap_end += incr;
+  if (__sbrk_heap_end > __sbrk_heap_peak)
+  {
+    __sbrk_heap_peak = __sbrk_heap_end;
+  }
 
   return (void *)prev_heap_end;
 }
+
+/**
+ * @brief _sbrk_high_water() reports the most heap _sbrk() has handed out
+ *        since reset, for the RAM report in Src/ram.c
+ *
+ * @return Bytes above the '_end' linker symbol, 0 if _sbrk() was never called
+ */
+size_t _sbrk_high_water(void)
+{
+  extern uint8_t _end; /* Symbol defined in the linker script */
+
+  return (NULL == __sbrk_heap_peak) ? 0 : (size_t)(__sbrk_heap_peak - &_end);
+}
@@ -3,6 +3,10 @@
  * ============================================================================ */
 
 #include "utils.h"
+#include "config.h"
+#include "prof.h"
+#include "journal.h"
+#include "ram.h"
 #include <stdarg.h>
 #include <stdio.h>
 
@@ -12,38 +16,174 @@
 /* Global Variables */
 volatile uint32_t g_tick_counter = 0;
 uint8_t g_system_initialized = 0;
+volatile uint32_t g_log_dropped_bytes = 0;
+
+/* Log TX Ring: Log_Print() advances head, USART2_IRQHandler() advances tail */
+#define LOG_TX_MASK (LOG_TX_BUFFER_SIZE - 1)
+static uint8_t s_tx_buf[LOG_TX_BUFFER_SIZE];
+static volatile uint16_t s_tx_head = 0;
+static volatile uint16_t s_tx_tail = 0;
 
 /* ============================================================================
  * Timing Functions
  * ============================================================================ */
 void Delay_ms(uint32_t ms) {
     uint32_t start = GetTick();
-    while((GetTick() - start) < ms);
+    while((GetTick() - start) < ms) __WFI();   // SysTick wakes us every tick
 }
 
 uint32_t GetTick(void) {
     return g_tick_counter;
 }
 
+// DWT cycle counter, for measuring code paths shorter than a tick
+void Cycle_Init(void) {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+uint32_t Cycle_Now(void) {
+    return DWT->CYCCNT;
+}
+
 /* ============================================================================
  * Logging Functions
  * ============================================================================ */
+// The TXE interrupt can't run here: in a handler or with IRQs masked
+static uint8_t log_irq_blocked(void) {
+    return __get_IPSR() != 0 || __get_PRIMASK() != 0;
+}
+
+// Send one queued byte by polling; for contexts where the ISR can't run
+static void log_tx_polled(void) {
+    while(!(USART2->SR & USART_SR_TXE));
+    USART2->DR = s_tx_buf[s_tx_tail & LOG_TX_MASK];
+    s_tx_tail++;
+}
+
+static uint8_t log_write(const char* p, uint16_t n) {
+    uint16_t free_bytes = LOG_TX_BUFFER_SIZE - (uint16_t)(s_tx_head - s_tx_tail);
+
+    if(n > free_bytes) {
+#if LOG_OVERFLOW_POLICY == LOG_OVERFLOW_BLOCK
+        if(n > LOG_TX_BUFFER_SIZE) n = LOG_TX_BUFFER_SIZE;
+        while((uint16_t)(LOG_TX_BUFFER_SIZE - (uint16_t)(s_tx_head - s_tx_tail)) < n) {
+            if(log_irq_blocked()) log_tx_polled();
+        }
+#else
+        g_log_dropped_bytes += n;
+        return 0;
+#endif
+    }
+
+    uint16_t head = s_tx_head;
+    for(uint16_t i = 0; i < n; i++) {
+        s_tx_buf[(uint16_t)(head + i) & LOG_TX_MASK] = p[i];
+    }
+    __DMB();                // bytes in place before the ISR can see them
+    s_tx_head = head + n;
+    USART2->CR1 |= USART_CR1_TXEIE;
+    return 1;
+}
+
+// Call from the main loop only: the ring has a single producer
 void Log_Print(const char* format, ...) {
     if(!g_system_initialized) return;
+    PROF_BEGIN(PROF_LOG_PRINT);
     char buffer[256];
     va_list args;
     va_start(args, format);
-    vsnprintf(buffer, sizeof(buffer), format, args);
+    int len = vsnprintf(buffer, sizeof(buffer), format, args);
     va_end(args);
-    for(char* p = buffer; *p; p++) {
-        while(!(USART2->SR & USART_SR_TXE));
-        USART2->DR = *p;
+    if(len > 0) {
+        if(len >= (int)sizeof(buffer)) len = sizeof(buffer) - 1;
+        log_write(buffer, (uint16_t)len);
+    }
+    PROF_END(PROF_LOG_PRINT);
+}
+
+#if LOG_TOKENIZED
+static uint8_t* put_varint(uint8_t* p, uint32_t v) {
+    while(v >= 0x80) {
+        *p++ = (uint8_t)v | 0x80;
+        v >>= 7;
     }
+    *p++ = (uint8_t)v;
+    return p;
+}
+#endif
+
+// Binary record for LOG(); fmt lives in .logstr, so its address is the ID
+void Log_Token(const char* fmt, uint8_t nargs, const uint32_t* args) {
+#if LOG_TOKENIZED
+    static uint32_t last_tick = 0;
+    if(!g_system_initialized) return;
+    if(nargs > LOG_MAX_ARGS) nargs = LOG_MAX_ARGS;
+
+    uint8_t frame[2 + 2 + 5 * (1 + LOG_MAX_ARGS) + 1];
+    uint8_t* p = frame + 2;
+    uint16_t id = (uint16_t)(uintptr_t)fmt;
+    uint32_t now = GetTick();
+
+    *p++ = (uint8_t)id;
+    *p++ = (uint8_t)(id >> 8);
+    p = put_varint(p, now - last_tick);
+    for(uint8_t i = 0; i < nargs; i++) {
+        p = put_varint(p, args[i]);
+    }
+
+    frame[0] = LOG_FRAME_SYNC;
+    frame[1] = (uint8_t)(p - frame - 2);
+    uint8_t sum = 0;
+    for(uint8_t* q = frame + 2; q < p; q++) sum += *q;
+    *p++ = sum;
+
+    // Deltas chain from the last record that made it into the ring
+    if(log_write((const char*)frame, (uint16_t)(p - frame))) last_tick = now;
+#else
+    (void)fmt; (void)nargs; (void)args;
+#endif
+}
+
+// Block until every queued byte is out of the shifter; safe in fault handlers
+void Log_Flush(void) {
+    while(s_tx_tail != s_tx_head) {
+        if(log_irq_blocked()) log_tx_polled();
+    }
+    while(!(USART2->SR & USART_SR_TC));
 }
 
 /* ============================================================================
- * Interrupt Handler
+ * Interrupt Handlers
  * ============================================================================ */
 void SysTick_Handler(void) {
+    PROF_BEGIN(PROF_ISR_SYSTICK);
     g_tick_counter++;
+    PROF_END(PROF_ISR_SYSTICK);
+}
+
+void USART2_IRQHandler(void) {
+    PROF_BEGIN(PROF_ISR_USART);
+    if(USART2->SR & USART_SR_RXNE) {
+        uint8_t c = (uint8_t)USART2->DR;
+        Prof_Command(c);
+        Journal_Command(c);
+        Ram_Command(c);
+    }
+    if((USART2->SR & USART_SR_TXE) && (USART2->CR1 & USART_CR1_TXEIE)) {
+        if(s_tx_tail != s_tx_head) {
+            USART2->DR = s_tx_buf[s_tx_tail & LOG_TX_MASK];
+            s_tx_tail++;
+        } else {
+            USART2->CR1 &= ~USART_CR1_TXEIE;
+        }
+    }
+    PROF_END(PROF_ISR_USART);
+}
+
+// Push out whatever was logged before the fault, then halt as before
+void HardFault_Handler(void) {
+    Log_Flush();
+    while(1);
 }
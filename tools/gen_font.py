@@ -0,0 +1,296 @@
+#!/usr/bin/env python3
+"""
+Generate the 5x7 glyph atlas (Src/font5x7.c, Inc/font5x7.h) from the art below.
+
+Every printable ASCII character from ' ' to '~' is drawn in a 5 x 7 cell,
+'#' for a lit pixel. The atlas stores each glyph as 5 column bytes (bit 0 =
+top row) with no spacing column; the renderer adds one blank column per
+glyph. With --proportional the blank columns around each glyph are trimmed,
+the glyph is shifted left and a width table is emitted as well.
+
+The digits are also emitted pre-scaled for large readouts: at scale k every
+pixel becomes a k x k block, 7k rows split over k display pages, stored
+page by page so a renderer can send each page row as one run.
+
+    gen_font.py                     # rewrite the atlas in place
+    gen_font.py --proportional      # same, with per-glyph widths
+    gen_font.py --digit-scales 2,3  # which large digit sets to emit (default)
+"""
+
+import argparse
+import ast
+import os
+
+COLS, ROWS = 5, 7
+FIRST, LAST = 0x20, 0x7E
+SPACE_WIDTH = 3                     # proportional advance of ' ', before spacing
+
+# Eight glyphs per block: a row of quoted characters, then 7 pixel rows
+ART = r"""
+    ' '   '!'   '"'   '#'   '$'   '%'   '&'   "'"
+    ..... ..#.. .#.#. .#.#. ..#.. ##... .##.. .##..
+    ..... ..#.. .#.#. .#.#. .#### ##..# #..#. ..#..
+    ..... ..#.. .#.#. ##### #.#.. ...#. #.#.. .#...
+    ..... ..#.. ..... .#.#. .###. ..#.. .#... .....
+    ..... ..#.. ..... ##### ..#.# .#... #.#.# .....
+    ..... ..... ..... .#.#. ####. #..## #..#. .....
+    ..... ..#.. ..... .#.#. ..#.. ...## .##.# .....
+
+    '('   ')'   '*'   '+'   ','   '-'   '.'   '/'
+    ...#. .#... ..... ..... ..... ..... ..... .....
+    ..#.. ..#.. ..#.. ..#.. ..... ..... ..... ....#
+    .#... ...#. #.#.# ..#.. ..... ..... ..... ...#.
+    .#... ...#. .###. ##### ..... ##### ..... ..#..
+    .#... ...#. #.#.# ..#.. .##.. ..... ..... .#...
+    ..#.. ..#.. ..#.. ..#.. ..#.. ..... .##.. #....
+    ...#. .#... ..... ..... .#... ..... .##.. .....
+
+    '0'   '1'   '2'   '3'   '4'   '5'   '6'   '7'
+    .###. ..#.. .###. ##### ...#. ##### ..##. #####
+    #...# .##.. #...# ...#. ..##. #.... .#... ....#
+    #..## ..#.. ....# ..#.. .#.#. ####. #.... ...#.
+    #.#.# ..#.. ...#. ...#. #..#. ....# ####. ..#..
+    ##..# ..#.. ..#.. ....# ##### ....# #...# .#...
+    #...# ..#.. .#... #...# ...#. #...# #...# .#...
+    .###. .###. ##### .###. ...#. .###. .###. .#...
+
+    '8'   '9'   ':'   ';'   '<'   '='   '>'   '?'
+    .###. .###. ..... ..... ...#. ..... #.... .###.
+    #...# #...# .##.. .##.. ..#.. ..... .#... #...#
+    #...# #...# .##.. .##.. .#... ##### ..#.. ....#
+    .###. .#### ..... ..... #.... ..... ...#. ...#.
+    #...# ....# .##.. .##.. .#... ##### ..#.. ..#..
+    #...# ...#. .##.. ..#.. ..#.. ..... .#... .....
+    .###. .##.. ..... .#... ...#. ..... #.... ..#..
+
+    '@'   'A'   'B'   'C'   'D'   'E'   'F'   'G'
+    .###. .###. ####. .###. ###.. ##### ##### .###.
+    #...# #...# #...# #...# #..#. #.... #.... #...#
+    ....# #...# #...# #.... #...# #.... #.... #....
+    .##.# #...# ####. #.... #...# ####. ####. #.###
+    #.#.# ##### #...# #.... #...# #.... #.... #...#
+    #.#.# #...# #...# #...# #..#. #.... #.... #...#
+    .###. #...# ####. .###. ###.. ##### #.... .####
+
+    'H'   'I'   'J'   'K'   'L'   'M'   'N'   'O'
+    #...# .###. ..### #...# #.... #...# #...# .###.
+    #...# ..#.. ...#. #..#. #.... ##.## #...# #...#
+    #...# ..#.. ...#. #.#.. #.... #.#.# ##..# #...#
+    ##### ..#.. ...#. ##... #.... #.#.# #.#.# #...#
+    #...# ..#.. ...#. #.#.. #.... #...# #..## #...#
+    #...# ..#.. #..#. #..#. #.... #...# #...# #...#
+    #...# .###. .##.. #...# ##### #...# #...# .###.
+
+    'P'   'Q'   'R'   'S'   'T'   'U'   'V'   'W'
+    ####. .###. ####. .#### ##### #...# #...# #...#
+    #...# #...# #...# #.... ..#.. #...# #...# #...#
+    #...# #...# #...# #.... ..#.. #...# #...# #...#
+    ####. #...# ####. .###. ..#.. #...# #...# #.#.#
+    #.... #.#.# #.#.. ....# ..#.. #...# #...# #.#.#
+    #.... #..#. #..#. ....# ..#.. #...# .#.#. ##.##
+    #.... .##.# #...# ####. ..#.. .###. ..#.. #...#
+
+    'X'   'Y'   'Z'   '['   '\\'  ']'   '^'   '_'
+    #...# #...# ##### .###. ..... .###. ..#.. .....
+    #...# #...# ....# .#... #.... ...#. .#.#. .....
+    .#.#. #...# ...#. .#... .#... ...#. #...# .....
+    ..#.. .#.#. ..#.. .#... ..#.. ...#. ..... .....
+    .#.#. ..#.. .#... .#... ...#. ...#. ..... .....
+    #...# ..#.. #.... .#... ....# ...#. ..... .....
+    #...# ..#.. ##### .###. ..... .###. ..... #####
+
+    '`'   'a'   'b'   'c'   'd'   'e'   'f'   'g'
+    .#... ..... #.... ..... ....# ..... ..##. .....
+    ..#.. ..... #.... ..... ....# ..... .#..# .####
+    ...#. .###. #.##. .###. .##.# .###. .#... #...#
+    ..... ....# ##..# #.... #..## #...# ###.. #...#
+    ..... .#### #...# #.... #...# ##### .#... .####
+    ..... #...# #...# #...# #...# #.... .#... ....#
+    ..... .#### ####. .###. .#### .###. .#... .###.
+
+    'h'   'i'   'j'   'k'   'l'   'm'   'n'   'o'
+    #.... ..#.. ...#. #.... .##.. ..... ..... .....
+    #.... ..... ..... #.... ..#.. ..... ..... .....
+    #.##. .##.. ..##. #..#. ..#.. ##.#. #.##. .###.
+    ##..# ..#.. ...#. #.#.. ..#.. #.#.# ##..# #...#
+    #...# ..#.. ...#. ##... ..#.. #.#.# #...# #...#
+    #...# ..#.. #..#. #.#.. ..#.. #...# #...# #...#
+    #...# .###. .##.. #..#. .###. #...# #...# .###.
+
+    'p'   'q'   'r'   's'   't'   'u'   'v'   'w'
+    ..... ..... ..... ..... .#... ..... ..... .....
+    ..... ..... ..... ..... .#... ..... ..... .....
+    ####. .##.# #.##. .###. ###.. #...# #...# #...#
+    #...# #..## ##..# #.... .#... #...# #...# #...#
+    ####. .#### #.... .###. .#... #...# #...# #.#.#
+    #.... ....# #.... ....# .#..# #..## .#.#. #.#.#
+    #.... ....# #.... ####. ..##. .##.# ..#.. .#.#.
+
+    'x'   'y'   'z'   '{'   '|'   '}'   '~'
+    ..... ..... ..... ...#. ..#.. .#... .....
+    ..... ..... ..... ..#.. ..#.. ..#.. .....
+    #...# #...# ##### ..#.. ..#.. ..#.. .....
+    .#.#. #...# ...#. .#... ..#.. ...#. .##.#
+    ..#.. .#### ..#.. ..#.. ..#.. ..#.. #..#.
+    .#.#. ....# .#... ..#.. ..#.. ..#.. .....
+    #...# .###. ##### ...#. ..#.. .#... .....
+"""
+
+
+def parse_art(text):
+    """Map character -> list of COLS column bytes."""
+    glyphs = {}
+    lines = [ln for ln in text.splitlines() if ln.strip()]
+    for b in range(0, len(lines), ROWS + 1):
+        header, rows = lines[b], lines[b + 1:b + 1 + ROWS]
+        for i in range((len(header) - 4 + 1 + COLS) // (COLS + 1)):
+            at = 4 + i * (COLS + 1)
+            ch = ast.literal_eval(header[at:at + COLS].strip())
+            cols = [0] * COLS
+            for y, row in enumerate(rows):
+                cell = row[at:at + COLS]
+                if len(cell) != COLS or set(cell) - set(".#"):
+                    raise SystemExit(f"glyph {ch!r}: bad row {y}: {cell!r}")
+                for x, px in enumerate(cell):
+                    if px == "#":
+                        cols[x] |= 1 << y
+            glyphs[ch] = cols
+    missing = [chr(c) for c in range(FIRST, LAST + 1) if chr(c) not in glyphs]
+    if missing:
+        raise SystemExit(f"no art for {missing}")
+    return glyphs
+
+
+def trim(cols, ch):
+    """Left-align a glyph; returns (columns padded to COLS, width)."""
+    lit = [x for x, c in enumerate(cols) if c]
+    if not lit:
+        return [0] * COLS, SPACE_WIDTH if ch == " " else 0
+    used = cols[lit[0]:lit[-1] + 1]
+    return used + [0] * (COLS - len(used)), len(used)
+
+
+def scale_glyph(cols, k):
+    """k-times glyph as k pages of COLS * k column bytes each."""
+    pages = [[0] * (COLS * k) for _ in range(k)]
+    for x, col in enumerate(cols):
+        for y in range(ROWS):
+            if not (col >> y) & 1:
+                continue
+            for dy in range(k):
+                row = y * k + dy
+                for dx in range(k):
+                    pages[row // 8][x * k + dx] |= 1 << (row % 8)
+    return pages
+
+
+def c_rows(values, per_line, chars):
+    """Initializer lines, each commented with the characters it covers."""
+    out = []
+    for i in range(0, len(values), per_line):
+        span = chars[i:i + per_line]
+        label = repr(span[0]) if len(span) == 1 else f"{span[0]!r} .. {span[-1]!r}"
+        out.append("    " + " ".join(values[i:i + per_line]) + f"  /* {label} */")
+    return "\n".join(out)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    ap.add_argument("--proportional", action="store_true", help="trim glyphs, emit widths")
+    ap.add_argument("--digit-scales", default="2,3",
+                    help="comma-separated scale factors for the large digits")
+    ap.add_argument("--root", default=os.path.join(os.path.dirname(__file__), ".."),
+                    help="repository root (default: parent of tools/)")
+    args = ap.parse_args()
+    scales = [int(k) for k in args.digit_scales.split(",") if k]
+    if any(k < 2 or k > 8 for k in scales):
+        raise SystemExit("digit scales must be 2..8")
+
+    glyphs = parse_art(ART)
+    chars = [chr(c) for c in range(FIRST, LAST + 1)]
+    widths = []
+    entries = []
+    for ch in chars:
+        cols = glyphs[ch]
+        if args.proportional:
+            cols, w = trim(cols, ch)
+            widths.append(w)
+        body = ",".join(f"0x{c:02X}" for c in cols)
+        entries.append(f"{{{body}}},")
+
+    count = len(chars)
+    big_decls, big_defs = [], []
+    for k in scales:
+        name = f"FONT5X7_DIGIT_X{k}"
+        big_decls.append(f"extern const uint8_t {name}[10][{k}][{COLS * k}];")
+        lines = []
+        for d in "0123456789":
+            pages = scale_glyph(glyphs[d], k)
+            body = ", ".join("{" + ",".join(f"0x{c:02X}" for c in pg) + "}" for pg in pages)
+            lines.append(f"{{{body}}},")
+        big_defs.append(f"""
+const uint8_t {name}[10][{k}][{COLS * k}] = {{
+{c_rows(lines, 1, list("0123456789"))}
+}};
+""")
+    notice = "Generated by tools/gen_font.py; edit the art there, not this file"
+    header = f"""/* ============================================================================
+ * 5x7 Glyph Atlas
+ * {notice}.
+ * Printable ASCII, {COLS} column bytes per glyph (bit 0 = top row); the
+ * spacing column after each glyph is implicit.
+ * ============================================================================ */
+
+#ifndef FONT5X7_H
+#define FONT5X7_H
+
+#include <stdint.h>
+
+#define FONT5X7_FIRST           0x{FIRST:02X}    /* ' ' */
+#define FONT5X7_LAST            0x{LAST:02X}    /* '~' */
+#define FONT5X7_COLS            {COLS}
+#define FONT5X7_PROPORTIONAL    {int(args.proportional)}       /* 1 = FONT5X7_WIDTH[] holds each advance */
+
+extern const uint8_t FONT5X7[{count}][FONT5X7_COLS];
+#if FONT5X7_PROPORTIONAL
+extern const uint8_t FONT5X7_WIDTH[{count}];
+#endif
+
+/* Large digits: [digit][page][column], spacing of k columns implicit */
+{chr(10).join(big_decls)}
+
+#endif /* FONT5X7_H */
+"""
+    source = f"""/* ============================================================================
+ * 5x7 Glyph Atlas
+ * {notice}.
+ * ============================================================================ */
+
+#include "font5x7.h"
+
+const uint8_t FONT5X7[{count}][FONT5X7_COLS] = {{
+{c_rows(entries, 1, chars)}
+}};
+"""
+    if args.proportional:
+        source += f"""
+const uint8_t FONT5X7_WIDTH[{count}] = {{
+{c_rows([f"{w}," for w in widths], 16, chars)}
+}};
+"""
+
+    source += "".join(big_defs)
+
+    with open(os.path.join(args.root, "Inc", "font5x7.h"), "w") as f:
+        f.write(header)
+    with open(os.path.join(args.root, "Src", "font5x7.c"), "w") as f:
+        f.write(source)
+
+    size = count * COLS + (count if args.proportional else 0)
+    print(f"font5x7: {count} glyphs, {size} bytes of flash")
+    for k in scales:
+        print(f"font5x7: digits x{k}, {10 * k * COLS * k} bytes of flash")
+
+
+if __name__ == "__main__":
+    main()
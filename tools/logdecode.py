@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+"""
+Host decoder for tokenized logs (LOG_TOKENIZED = 1 in Inc/config.h).
+
+The firmware puts every LOG() format string into the non-loaded .logstr
+section of the ELF and sends only its offset there (the message ID), a
+millisecond tick delta and the raw integer arguments:
+
+    0xA5, len, id_lo, id_hi, varint dt_ms, varint arg..., sum8
+
+where len counts the bytes between it and the checksum, and sum8 is the
+8-bit sum of those bytes. Bytes outside a valid frame are passed through as
+plain text, so ASCII Log_Print() output can share the line.
+
+    logdecode.py --elf Debug/projectmaicro.elf --dump-table > strings.json
+    logdecode.py --elf Debug/projectmaicro.elf capture.bin
+    logdecode.py --table strings.json < /dev/ttyACM0
+"""
+
+import argparse
+import codecs
+import json
+import re
+import struct
+import sys
+
+FRAME_SYNC = 0xA5
+SECTION = ".logstr"
+CONVERSION = re.compile(r"%([-+ 0#]*\d*(?:\.\d+)?)(hh|h|ll|l|z|j|t)?([diuxXoc%])")
+
+
+def read_string_table(elf_path):
+    """Map message ID -> format string from the .logstr section."""
+    with open(elf_path, "rb") as f:
+        elf = f.read()
+    if elf[:4] != b"\x7fELF":
+        raise SystemExit(f"{elf_path}: not an ELF file")
+    is64 = elf[4] == 2
+    end = "<" if elf[5] == 1 else ">"
+
+    if is64:
+        shoff, = struct.unpack_from(end + "Q", elf, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from(end + "HHH", elf, 0x3A)
+        shdr = end + "IIQQQQ"
+    else:
+        shoff, = struct.unpack_from(end + "I", elf, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from(end + "HHH", elf, 0x2E)
+        shdr = end + "IIIIII"
+
+    sections = [struct.unpack_from(shdr, elf, shoff + i * shentsize) for i in range(shnum)]
+    names_off = sections[shstrndx][4]
+
+    for name, _type, _flags, addr, offset, size in sections:
+        nend = elf.index(b"\0", names_off + name)
+        if elf[names_off + name:nend].decode() != SECTION:
+            continue
+        data = elf[offset:offset + size]
+        table, pos = {}, 0
+        while pos < len(data):
+            nul = data.find(b"\0", pos)
+            if nul < 0:
+                nul = len(data)
+            if nul > pos:
+                table[(addr + pos) & 0xFFFF] = data[pos:nul].decode("utf-8", "replace")
+            pos = nul + 1
+        return table
+    raise SystemExit(f"{elf_path}: no {SECTION} section (built with LOG_TOKENIZED = 0?)")
+
+
+def read_varints(payload):
+    values, v, shift = [], 0, 0
+    for b in payload:
+        v |= (b & 0x7F) << shift
+        shift += 7
+        if not b & 0x80:
+            values.append(v)
+            v, shift = 0, 0
+    return values
+
+
+def render(fmt, args):
+    """printf-style formatting of raw 32-bit integers."""
+    args = list(args)
+
+    def one(m):
+        flags, _length, conv = m.groups()
+        if conv == "%":
+            return "%"
+        v = args.pop(0) if args else 0
+        if conv in "di" and v & 0x80000000:
+            v -= 1 << 32
+        if conv == "u":
+            conv = "d"
+        if conv == "c":
+            return chr(v & 0xFF)
+        return ("%" + flags + conv) % v
+
+    return CONVERSION.sub(one, fmt)
+
+
+def decode(stream, table, out):
+    """Decode as bytes arrive, so a live port shows each record at once.
+    A frame split across reads is held until the rest of it comes in."""
+    tick = 0
+    text = codecs.getincrementaldecoder("utf-8")("replace")
+    data = b""
+    eof = False
+    while not eof:
+        chunk = stream.read1(4096)
+        eof = not chunk
+        data += chunk
+        plain = bytearray()
+        i = 0
+        while i < len(data):
+            b = data[i]
+            if b == FRAME_SYNC:
+                if i + 1 >= len(data) or i + 3 + data[i + 1] > len(data):
+                    if not eof:
+                        break
+                else:
+                    n = data[i + 1]
+                    payload = data[i + 2:i + 2 + n]
+                    if n >= 3 and (sum(payload) & 0xFF) == data[i + 2 + n]:
+                        out.write(text.decode(bytes(plain)))
+                        plain.clear()
+                        msg_id = payload[0] | (payload[1] << 8)
+                        values = read_varints(payload[2:])
+                        if values:
+                            tick += values[0]
+                        fmt = table.get(msg_id, f"<unknown id 0x{msg_id:04x}>\r\n")
+                        line = render(fmt, values[1:])
+                        out.write(f"[{tick:>9} ms] {line.lstrip(chr(13) + chr(10))}")
+                        out.flush()
+                        i += 3 + n
+                        continue
+            plain.append(b)
+            i += 1
+        out.write(text.decode(bytes(plain), final=eof))
+        out.flush()
+        data = data[i:]
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    src = ap.add_mutually_exclusive_group(required=True)
+    src.add_argument("--elf", help="firmware ELF containing the .logstr section")
+    src.add_argument("--table", help="JSON string table written by --dump-table")
+    ap.add_argument("--dump-table", action="store_true", help="print the string table as JSON")
+    ap.add_argument("capture", nargs="?", help="raw UART capture (default: stdin)")
+    opt = ap.parse_args()
+
+    if opt.elf:
+        table = read_string_table(opt.elf)
+    else:
+        with open(opt.table) as f:
+            table = {int(k): v for k, v in json.load(f).items()}
+
+    if opt.dump_table:
+        json.dump({str(k): v for k, v in sorted(table.items())}, sys.stdout, indent=1)
+        sys.stdout.write("\n")
+        return
+
+    stream = open(opt.capture, "rb") if opt.capture else sys.stdin.buffer
+    with stream:
+        decode(stream, table, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()